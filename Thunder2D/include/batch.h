@@ -10,7 +10,9 @@
 #include <functional>
 #include <glad/gl.h>
 #include <algorithm>
+#include <cstddef>
 #include <t2dshader.h>
+#include <t2dspatial.h>
 #define __2(_s,_n) (((_s) < (_n)) ? (_s) : (_n))
 
 #undef near
@@ -136,6 +138,28 @@ public:
         return viewProjectionMatrix;
     }
 
+    //! world space rectangle covered by getViewProjectionMatrix
+    AABB2D getViewBounds() const {
+        updateMatrices();
+        glm::mat4 inverse = glm::inverse(viewProjectionMatrix);
+        const glm::vec2 ndc[4] = {{-1.0f, -1.0f}, {1.0f, -1.0f}, {1.0f, 1.0f}, {-1.0f, 1.0f}};
+
+        AABB2D bounds;
+        for (int i = 0; i < 4; i++) {
+            glm::vec4 world = inverse * glm::vec4(ndc[i], 0.0f, 1.0f);
+            glm::vec2 p = glm::vec2(world) / world.w;
+            if (i == 0) {
+                bounds = {p.x, p.y, p.x, p.y};
+                continue;
+            }
+            bounds.minX = (std::min)(bounds.minX, p.x);
+            bounds.minY = (std::min)(bounds.minY, p.y);
+            bounds.maxX = (std::max)(bounds.maxX, p.x);
+            bounds.maxY = (std::max)(bounds.maxY, p.y);
+        }
+        return bounds;
+    }
+
     glm::vec2 worldToScreen(const glm::vec2& worldPos) const {
         updateMatrices();
         glm::vec4 clip = viewProjectionMatrix * glm::vec4(worldPos, 0.0f, 1.0f);
@@ -222,6 +246,7 @@ class SpriteShader : public IShader {
 private:
     GLuint ID;
     std::vector<GLuint>* textures; 
+    int textureBase = 0;
     
 public:
     SpriteShader(const std::string& vertexPath, const std::string& fragmentPath, std::vector<GLuint>* textureArray) 
@@ -258,15 +283,19 @@ public:
             glUniform1iv(texturesLoc, 8, samplerValues);
         }
         
+        setUniform("textureBase", textureBase);
+        
         if (textures) {
-            for (int i = 0; i < __2((int)textures->size(), 8); i++) {
+            for (int i = 0; i < __2((int)textures->size() - textureBase, 8); i++) {
                 glActiveTexture(GL_TEXTURE0 + i);
-                glBindTexture(GL_TEXTURE_2D, (*textures)[i]);
+                glBindTexture(GL_TEXTURE_2D, (*textures)[textureBase + i]);
             }
         }
     }
     
     GLuint getID() const override { return ID; }
+    int getTextureSlotCount() const override { return 8; }
+    void setTextureBase(int base) override { textureBase = base; }
     
 private:
     void init(const std::string& vertexPath, const std::string& fragmentPath) {
@@ -420,6 +449,16 @@ private:
         return shader;
     }
 };
+struct RenderStats {
+    inline static size_t drawCalls = 0;
+    inline static size_t lastFrameDrawCalls = 0;
+
+    static void endFrame() {
+        lastFrameDrawCalls = drawCalls;
+        drawCalls = 0;
+    }
+};
+
 struct BaseVertex {
     virtual ~BaseVertex() = default;
     virtual size_t getSize() const = 0;
@@ -427,9 +466,19 @@ struct BaseVertex {
     virtual void setupAttributes() const = 0;
 };
 
+struct SpriteInstance {
+    float x, y;
+    float scaleX, scaleY;
+    float rotation;
+    float u0, v0, u1, v1;
+    float r, g, b, a;
+    int textureID;
+};
+
 class IRenderable {
 public:
     virtual ~IRenderable() = default;
+    virtual bool fillInstance(SpriteInstance& out) const { return false; }
     virtual bool isDirty() const = 0;
     virtual void setClean() = 0;
     virtual int getZOrder() const = 0;
@@ -440,11 +489,24 @@ public:
     virtual int getIndexCount() const = 0;
     size_t vertexOffsetInBuffer = 0;
     size_t indexOffsetInBuffer = 0;
+    int textureBaseInBuffer = 0;
 };
 
+template<typename IndexType>
+inline std::vector<IndexType> generateQuadIndices(size_t quadCount) {
+    std::vector<IndexType> indices(quadCount * 6);
+    for (size_t q = 0; q < quadCount; ++q) {
+        IndexType offset = static_cast<IndexType>(q * 4);
+        IndexType* out = &indices[q * 6];
+        out[0] = offset + 0; out[1] = offset + 1; out[2] = offset + 2;
+        out[3] = offset + 2; out[4] = offset + 3; out[5] = offset + 0;
+    }
+    return indices;
+}
+
 template<typename VertexType>
 class AbstractBatchRenderer {
-private:
+protected:
 std::vector<GLuint> textures;
 std::unique_ptr<IShader> shader;
 
@@ -455,6 +517,17 @@ size_t maxIndices;
 
 std::function<void()> setupVertexLayout;
 
+// contiguous draw range whose texture ids all fall in [textureBase, textureBase + slots)
+struct SubBatch {
+    size_t first;
+    size_t count;
+    int textureBase;
+};
+std::vector<SubBatch> subBatches;
+size_t drawCalls = 0;
+// renderables was swapped for another set, rebuild even if every member is clean
+bool membershipChanged = false;
+
 public:
 std::vector<std::shared_ptr<IRenderable>> renderables;
     AbstractBatchRenderer(size_t maxVerts, size_t maxIdxs, 
@@ -462,8 +535,9 @@ std::vector<std::shared_ptr<IRenderable>> renderables;
                          std::unique_ptr<IShader> shaderPtr)
         : maxVertices(maxVerts), maxIndices(maxIdxs), 
           setupVertexLayout(vertexLayoutSetup), shader(std::move(shaderPtr)) {}
+    virtual ~AbstractBatchRenderer() = default;
     
-    void init() {
+    virtual void init() {
         glGenVertexArrays(1, &vao);
         glGenBuffers(1, &vbo);
         glGenBuffers(1, &ebo);
@@ -501,8 +575,11 @@ std::vector<std::shared_ptr<IRenderable>> renderables;
     void setTextures(const std::vector<GLuint>& textureArray) {
         textures = textureArray;
     }
+
+    //! the next reload rebuilds the buffers even when no renderable is dirty
+    void markMembershipChanged() { membershipChanged = true; }
     
-    void reload() {
+    virtual void reload() {
         if (renderables.empty()) return;
         
         bool anyDirty = false;
@@ -512,19 +589,17 @@ std::vector<std::shared_ptr<IRenderable>> renderables;
                 break;
             }
         }
-        if (!anyDirty) return;
-        
+        if (!anyDirty && !membershipChanged) return;
+        membershipChanged = false;
 
         
-        std::sort(renderables.begin(), renderables.end(), 
-            [](const auto& a, const auto& b) {
-                return a->getZOrder() < b->getZOrder();
-            });
+        sortRenderables();
         
         std::vector<VertexType> vertexData;
         std::vector<unsigned int> indexData;
         unsigned int vertexOffset = 0;
         unsigned int indexOffset = 0;
+        subBatches.clear();
         
         for (const auto& renderable : renderables) {
             auto vertices = renderable->generateVertices();
@@ -532,6 +607,7 @@ std::vector<std::shared_ptr<IRenderable>> renderables;
             
             renderable->vertexOffsetInBuffer = vertexOffset;
             renderable->indexOffsetInBuffer = indexOffset;
+            appendSubBatch(*renderable, indexOffset, indices.size());
 
             for (const auto& vertex : vertices) {
                 vertexData.push_back(*static_cast<const VertexType*>(vertex->getData()));
@@ -564,7 +640,7 @@ std::vector<std::shared_ptr<IRenderable>> renderables;
             std::cout << "  [" << key << "] = " << value << '\n';
         }
     }
-    void updateDirtyRenderables() {
+    virtual void updateDirtyRenderables() {
         int _c = 0;
         std::map<std::string, int> vals{};
         glBindBuffer(GL_ARRAY_BUFFER, vbo);
@@ -572,6 +648,10 @@ std::vector<std::shared_ptr<IRenderable>> renderables;
     
         for (auto& renderable : renderables) {
             if (!renderable->isDirty()) continue;
+            if (!fitsTextureWindow(*renderable)) {
+                reload();
+                return;
+            }
     
             auto vertices = renderable->generateVertices();
             auto indices = renderable->generateIndices(renderable->vertexOffsetInBuffer);
@@ -600,21 +680,27 @@ std::vector<std::shared_ptr<IRenderable>> renderables;
         printMap(vals);
         std::cout<<"updated "<<_c<<" renderables!"<<std::endl;
     }
-    void render(const float proj[16]) {
+    virtual void render(const float proj[16]) {
         if (renderables.empty() || !shader) return;
         
         shader->use();
         shader->setProjection(proj);
-        shader->setupUniforms();
         
         glBindVertexArray(vao);
         
-        if (indexCount > 0) {
-            glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
+        drawCalls = 0;
+        for (const auto& batch : subBatches) {
+            shader->setTextureBase(batch.textureBase);
+            shader->setupUniforms();
+            glDrawElements(GL_TRIANGLES, batch.count, GL_UNSIGNED_INT, (void*)(batch.first * sizeof(unsigned int)));
+            countDrawCall();
         }
         
         cleanup();
     }
+
+    size_t getDrawCallCount() const { return drawCalls; }
+    size_t getSubBatchCount() const { return subBatches.size(); }
     
     void destroy() {
         glDeleteBuffers(1, &vbo);
@@ -622,12 +708,62 @@ std::vector<std::shared_ptr<IRenderable>> renderables;
         glDeleteVertexArrays(1, &vao);
     }
     
-private:
+protected:
+    int textureSlots() const {
+        return shader ? shader->getTextureSlotCount() : 0;
+    }
+
+    int textureWindowBase(int textureID) const {
+        int slots = textureSlots();
+        if (slots <= 0 || textureID < 0) return 0;
+        return (textureID / slots) * slots;
+    }
+
+    bool fitsTextureWindow(const IRenderable& renderable) const {
+        int slots = textureSlots();
+        int textureID = renderable.getTextureID();
+        if (slots <= 0 || textureID < 0) return true;
+        return textureID >= renderable.textureBaseInBuffer && textureID < renderable.textureBaseInBuffer + slots;
+    }
+
+    // z order first, then texture window so each window forms as few ranges as possible
+    void sortRenderables() {
+        std::stable_sort(renderables.begin(), renderables.end(),
+            [this](const auto& a, const auto& b) {
+                if (a->getZOrder() != b->getZOrder()) return a->getZOrder() < b->getZOrder();
+                return textureWindowBase(a->getTextureID()) < textureWindowBase(b->getTextureID());
+            });
+    }
+
+    void appendSubBatch(IRenderable& renderable, size_t first, size_t count) {
+        int textureID = renderable.getTextureID();
+        int base = textureWindowBase(textureID);
+
+        if (!subBatches.empty()) {
+            SubBatch& last = subBatches.back();
+            bool sameWindow = textureID < 0 || textureSlots() <= 0 || last.textureBase == base;
+            if (sameWindow && last.first + last.count == first) {
+                last.count += count;
+                renderable.textureBaseInBuffer = last.textureBase;
+                return;
+            }
+        }
+        subBatches.push_back({first, count, base});
+        renderable.textureBaseInBuffer = base;
+    }
+
+    void countDrawCall() {
+        drawCalls++;
+        RenderStats::drawCalls++;
+    }
+
     void cleanup() {
         glBindVertexArray(0);
         glUseProgram(0);
         
-        for (int i = 0; i < textures.size(); i++) {
+        int slots = textureSlots();
+        int boundCount = slots > 0 ? __2((int)textures.size(), slots) : (int)textures.size();
+        for (int i = 0; i < boundCount; i++) {
             glActiveTexture(GL_TEXTURE0 + i);
             glBindTexture(GL_TEXTURE_2D, 0);
         }
@@ -635,6 +771,246 @@ private:
     }
 };
 
+// Batch for renderables that are all 4-vertex quads. The index pattern is fixed,
+// so the element buffer is built once for the whole capacity and only vertex data
+// is uploaded afterwards. Indices are 16-bit while the capacity fits in 65536 vertices.
+template<typename VertexType>
+class QuadBatchRenderer : public AbstractBatchRenderer<VertexType> {
+    using Base = AbstractBatchRenderer<VertexType>;
+
+    size_t quadCapacity = 0;
+    GLenum indexType = GL_UNSIGNED_INT;
+    bool allowShortIndices = true;
+    std::vector<VertexType> vertexData;
+    // quads in the vertex buffer and how many it has room for before it must be reallocated
+    size_t quadCount = 0;
+    size_t vertexQuadCapacity = 0;
+    size_t builtRenderables = 0;
+    size_t rebuilds = 0;
+    size_t drawLimit = SIZE_MAX;
+
+public:
+    QuadBatchRenderer(size_t maxVerts, size_t maxIdxs,
+                      std::function<void()> vertexLayoutSetup,
+                      std::unique_ptr<IShader> shaderPtr,
+                      bool allowShortIndices = true)
+        : Base(maxVerts, maxIdxs, vertexLayoutSetup, std::move(shaderPtr)),
+          allowShortIndices(allowShortIndices) {}
+
+    void init() override {
+        glGenVertexArrays(1, &this->vao);
+        glGenBuffers(1, &this->vbo);
+        glGenBuffers(1, &this->ebo);
+
+        glBindVertexArray(this->vao);
+
+        glBindBuffer(GL_ARRAY_BUFFER, this->vbo);
+        glBufferData(GL_ARRAY_BUFFER, this->maxVertices * sizeof(VertexType), nullptr, GL_DYNAMIC_DRAW);
+        vertexQuadCapacity = this->maxVertices / 4;
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->ebo);
+
+        if (this->setupVertexLayout) {
+            this->setupVertexLayout();
+        }
+
+        glBindVertexArray(0);
+
+        buildIndexBuffer((std::max)(this->maxIndices / 6, this->maxVertices / 4));
+    }
+
+    void reload() override {
+        if (!prepareReload()) return;
+
+        ensureQuadCapacity(quadCount);
+
+        glBindBuffer(GL_ARRAY_BUFFER, this->vbo);
+        if (quadCount > vertexQuadCapacity) {
+            vertexQuadCapacity = (std::max<size_t>)({quadCount, vertexQuadCapacity * 2, 64});
+            glBufferData(GL_ARRAY_BUFFER, vertexQuadCapacity * 4 * sizeof(VertexType), nullptr, GL_DYNAMIC_DRAW);
+        }
+        glBufferSubData(GL_ARRAY_BUFFER, 0, vertexData.size() * sizeof(VertexType), vertexData.data());
+    }
+
+    //! the CPU half of reload, no GL: decides whether to rebuild, sorts, assigns offsets and fills vertexData.
+    //! false when nothing changed and the buffer already holds this set
+    bool prepareReload() {
+        if (this->renderables.empty()) return false;
+
+        bool anyDirty = false;
+        for (const auto& renderable : this->renderables) {
+            if (renderable->isDirty()) {
+                anyDirty = true;
+                break;
+            }
+        }
+        if (!anyDirty && !this->membershipChanged && builtRenderables == this->renderables.size()) return false;
+        this->membershipChanged = false;
+
+        this->sortRenderables();
+
+        vertexData.clear();
+        vertexData.reserve(this->renderables.size() * 4);
+        this->subBatches.clear();
+        size_t quad = 0;
+
+        for (const auto& renderable : this->renderables) {
+            if (renderable->getVertexCount() != 4) {
+                // never drawn, cleaned so it does not force a rebuild every frame
+                if (renderable->isDirty()) std::cerr << "QuadBatchRenderer: skipping non-quad renderable" << std::endl;
+                renderable->setClean();
+                continue;
+            }
+            auto vertices = renderable->generateVertices();
+
+            renderable->vertexOffsetInBuffer = quad * 4;
+            renderable->indexOffsetInBuffer = quad * 6;
+            this->appendSubBatch(*renderable, quad * 6, 6);
+
+            for (const auto& vertex : vertices) {
+                vertexData.push_back(*static_cast<const VertexType*>(vertex->getData()));
+            }
+
+            quad++;
+            renderable->setClean();
+        }
+
+        this->indexCount = quad * 6;
+        quadCount = quad;
+        builtRenderables = this->renderables.size();
+        rebuilds++;
+        return true;
+    }
+
+    //! adds quads after the last one without sorting or re-uploading the rest of the batch.
+    //! falls back to a full reload, and returns false, when the buffer is out of room or
+    //! the new quads would not sort to the end
+    bool appendRenderables(const std::vector<std::shared_ptr<IRenderable>>& added) {
+        if (added.empty()) return true;
+
+        bool inPlace = builtRenderables == this->renderables.size() && !this->renderables.empty() &&
+                       quadCount == builtRenderables && quadCount + added.size() <= vertexQuadCapacity;
+        const IRenderable* previous = inPlace ? this->renderables.back().get() : nullptr;
+        for (size_t i = 0; inPlace && i < added.size(); i++) {
+            const IRenderable& next = *added[i];
+            inPlace = next.getVertexCount() == 4 &&
+                      (next.getZOrder() > previous->getZOrder() ||
+                       (next.getZOrder() == previous->getZOrder() &&
+                        this->textureWindowBase(next.getTextureID()) >= this->textureWindowBase(previous->getTextureID())));
+            previous = &next;
+        }
+
+        this->renderables.insert(this->renderables.end(), added.begin(), added.end());
+        if (!inPlace) {
+            reload();
+            return false;
+        }
+
+        vertexData.clear();
+        size_t first = quadCount;
+        for (const auto& renderable : added) {
+            auto vertices = renderable->generateVertices();
+            renderable->vertexOffsetInBuffer = quadCount * 4;
+            renderable->indexOffsetInBuffer = quadCount * 6;
+            this->appendSubBatch(*renderable, quadCount * 6, 6);
+            for (const auto& vertex : vertices) {
+                vertexData.push_back(*static_cast<const VertexType*>(vertex->getData()));
+            }
+            quadCount++;
+            renderable->setClean();
+        }
+
+        ensureQuadCapacity(quadCount);
+        glBindBuffer(GL_ARRAY_BUFFER, this->vbo);
+        glBufferSubData(GL_ARRAY_BUFFER, first * 4 * sizeof(VertexType), vertexData.size() * sizeof(VertexType), vertexData.data());
+
+        this->indexCount = quadCount * 6;
+        builtRenderables = this->renderables.size();
+        return true;
+    }
+
+    //! quads from this one on are not drawn, SIZE_MAX draws everything
+    void setDrawLimit(size_t quads) { drawLimit = quads; }
+
+    void updateDirtyRenderables() override {
+        glBindBuffer(GL_ARRAY_BUFFER, this->vbo);
+
+        VertexType quadData[4];
+        for (auto& renderable : this->renderables) {
+            // reload skips these, they have no slot in the buffer
+            if (!renderable->isDirty() || renderable->getVertexCount() != 4) continue;
+            if (!this->fitsTextureWindow(*renderable)) {
+                reload();
+                return;
+            }
+
+            auto vertices = renderable->generateVertices();
+            for (int i = 0; i < 4; ++i) {
+                quadData[i] = *static_cast<const VertexType*>(vertices[i]->getData());
+            }
+
+            glBufferSubData(GL_ARRAY_BUFFER,
+                            renderable->vertexOffsetInBuffer * sizeof(VertexType),
+                            sizeof(quadData),
+                            quadData);
+
+            renderable->setClean();
+        }
+    }
+
+    void render(const float proj[16]) override {
+        if (this->renderables.empty() || !this->shader) return;
+
+        this->shader->use();
+        this->shader->setProjection(proj);
+
+        glBindVertexArray(this->vao);
+
+        size_t indexSize = indexType == GL_UNSIGNED_SHORT ? sizeof(unsigned short) : sizeof(unsigned int);
+        size_t indexLimit = drawLimit == SIZE_MAX ? SIZE_MAX : drawLimit * 6;
+        this->drawCalls = 0;
+        for (const auto& batch : this->subBatches) {
+            if (batch.first >= indexLimit) break;
+            size_t count = (std::min)(batch.count, indexLimit - batch.first);
+            this->shader->setTextureBase(batch.textureBase);
+            this->shader->setupUniforms();
+            glDrawElements(GL_TRIANGLES, count, indexType, (void*)(batch.first * indexSize));
+            this->countDrawCall();
+        }
+
+        this->cleanup();
+    }
+
+    GLenum getIndexType() const { return indexType; }
+    size_t getQuadCapacity() const { return quadCapacity; }
+    size_t getQuadCount() const { return quadCount; }
+    //! full sorted rebuilds so far, offsets of existing quads only move on one of these
+    size_t getRebuildCount() const { return rebuilds; }
+
+private:
+    void ensureQuadCapacity(size_t quads) {
+        if (quads <= quadCapacity) return;
+        buildIndexBuffer((std::max<size_t>)({quads, quadCapacity * 2, 64}));
+    }
+
+    void buildIndexBuffer(size_t quads) {
+        glBindVertexArray(this->vao);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->ebo);
+
+        if (allowShortIndices && quads * 4 <= 65536) {
+            auto indices = generateQuadIndices<unsigned short>(quads);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned short), indices.data(), GL_STATIC_DRAW);
+            indexType = GL_UNSIGNED_SHORT;
+        } else {
+            auto indices = generateQuadIndices<unsigned int>(quads);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+            indexType = GL_UNSIGNED_INT;
+        }
+
+        glBindVertexArray(0);
+        quadCapacity = quads;
+    }
+};
+
 struct SpriteVertex : public BaseVertex {
     struct Data {
         float x, y, u, v;
@@ -726,6 +1102,16 @@ private:
     int getTextureID() const override { return textureID; }
     int getVertexCount() const override { return 4; }
     int getIndexCount() const override { return 6; }
+
+    //! rotated sprites use the circle around the quad
+    AABB2D getBounds() const {
+        float hx = std::fabs(scale.x) * 0.5f;
+        float hy = std::fabs(scale.y) * 0.5f;
+        if (rotation != 0.0f) {
+            hx = hy = std::sqrt(hx * hx + hy * hy);
+        }
+        return {pos.x - hx, pos.y - hy, pos.x + hx, pos.y + hy};
+    }
     
     std::vector<std::unique_ptr<BaseVertex>> generateVertices() override {
         max::vec2<float> halfScale = scale * 0.5f;
@@ -767,6 +1153,13 @@ private:
             offset + 2u, offset + 3u, offset + 0u
         };
     }
+
+    bool fillInstance(SpriteInstance& out) const override {
+        out = {pos.x, pos.y, scale.x, scale.y, rotation,
+               txCoords[0].x, txCoords[0].y, txCoords[2].x, txCoords[2].y,
+               color.x, color.y, color.z, color.w, textureID};
+        return true;
+    }
     
     void setPosition(max::vec2<float> position) { pos = position; dirty = true; }
     void setScale(max::vec2<float> size) { scale = size; dirty = true; }
@@ -774,6 +1167,173 @@ private:
     void setZOrder(int z) { zOrder = z; dirty = true; }
 };
 
+// CPU reference of the expansion done in sprite_instanced.vert.
+inline std::array<SpriteVertex::Data, 4> expandSpriteInstance(const SpriteInstance& instance) {
+    static const float cornerSigns[4][2] = {{-1, 1}, {1, 1}, {1, -1}, {-1, -1}};
+    static const float uvSelect[4][2] = {{0, 0}, {1, 0}, {1, 1}, {0, 1}};
+
+    std::array<SpriteVertex::Data, 4> vertices{};
+    for (int i = 0; i < 4; ++i) {
+        max::vec2<float> corner{cornerSigns[i][0] * instance.scaleX * 0.5f, cornerSigns[i][1] * instance.scaleY * 0.5f};
+        if (instance.rotation != 0.0f) {
+            max::rotate(corner, instance.rotation);
+        }
+        float u = instance.u0 + (instance.u1 - instance.u0) * uvSelect[i][0];
+        float v = instance.v0 + (instance.v1 - instance.v0) * uvSelect[i][1];
+        vertices[i] = {corner.x + instance.x, corner.y + instance.y, u, v,
+                       instance.r, instance.g, instance.b, instance.a, instance.textureID};
+    }
+    return vertices;
+}
+
+// Draws every sprite as one instance record; the quad is expanded in the vertex
+// shader. vbo holds the instance records. Renderables that cannot describe
+// themselves as an instance are skipped.
+class InstancedSpriteBatchRenderer : public AbstractBatchRenderer<SpriteVertex::Data> {
+    using Base = AbstractBatchRenderer<SpriteVertex::Data>;
+
+    size_t instanceCapacity = 0;
+    size_t instanceCount = 0;
+    std::vector<SpriteInstance> instanceData;
+
+public:
+    InstancedSpriteBatchRenderer(size_t maxInstances, std::unique_ptr<IShader> shaderPtr)
+        : Base(maxInstances * 4, maxInstances * 6, nullptr, std::move(shaderPtr)),
+          instanceCapacity(maxInstances) {}
+
+    void init() override {
+        glGenVertexArrays(1, &vao);
+        glGenBuffers(1, &vbo);
+        glGenBuffers(1, &ebo);
+
+        glBindVertexArray(vao);
+
+        auto indices = generateQuadIndices<unsigned short>(1);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned short), indices.data(), GL_STATIC_DRAW);
+
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        glBufferData(GL_ARRAY_BUFFER, instanceCapacity * sizeof(SpriteInstance), nullptr, GL_DYNAMIC_DRAW);
+        setupInstanceAttributes();
+
+        glBindVertexArray(0);
+    }
+
+    void reload() override {
+        if (!prepareReload()) return;
+
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        if (instanceData.size() > instanceCapacity) {
+            instanceCapacity = (std::max<size_t>)(instanceData.size(), instanceCapacity * 2);
+            glBufferData(GL_ARRAY_BUFFER, instanceCapacity * sizeof(SpriteInstance), nullptr, GL_DYNAMIC_DRAW);
+        }
+        glBufferSubData(GL_ARRAY_BUFFER, 0, instanceData.size() * sizeof(SpriteInstance), instanceData.data());
+    }
+
+    //! the CPU half of reload, no GL: decides whether to rebuild, sorts, assigns slots and fills instanceData
+    bool prepareReload() {
+        if (renderables.empty()) return false;
+
+        bool anyDirty = false;
+        for (const auto& renderable : renderables) {
+            if (renderable->isDirty()) {
+                anyDirty = true;
+                break;
+            }
+        }
+        if (!anyDirty && !membershipChanged) return false;
+        membershipChanged = false;
+
+        sortRenderables();
+
+        instanceData.clear();
+        instanceData.reserve(renderables.size());
+        subBatches.clear();
+        SpriteInstance instance{};
+        for (const auto& renderable : renderables) {
+            if (!renderable->fillInstance(instance)) continue;
+            renderable->vertexOffsetInBuffer = instanceData.size();
+            appendSubBatch(*renderable, instanceData.size(), 1);
+            instanceData.push_back(instance);
+            renderable->setClean();
+        }
+
+        instanceCount = instanceData.size();
+        return true;
+    }
+
+    void updateDirtyRenderables() override {
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+
+        SpriteInstance instance{};
+        for (auto& renderable : renderables) {
+            if (!renderable->isDirty()) continue;
+            if (!fitsTextureWindow(*renderable)) {
+                reload();
+                return;
+            }
+            if (!renderable->fillInstance(instance)) continue;
+
+            glBufferSubData(GL_ARRAY_BUFFER,
+                            renderable->vertexOffsetInBuffer * sizeof(SpriteInstance),
+                            sizeof(SpriteInstance),
+                            &instance);
+            renderable->setClean();
+        }
+    }
+
+    void render(const float proj[16]) override {
+        if (instanceCount == 0 || !shader) return;
+
+        shader->use();
+        shader->setProjection(proj);
+
+        glBindVertexArray(vao);
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+
+        drawCalls = 0;
+        for (const auto& batch : subBatches) {
+            shader->setTextureBase(batch.textureBase);
+            shader->setupUniforms();
+            setupInstanceAttributes(batch.first * sizeof(SpriteInstance));
+            glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, 0, static_cast<GLsizei>(batch.count));
+            countDrawCall();
+        }
+
+        cleanup();
+    }
+
+private:
+    // re-pointed per sub-batch since GL 3.3 has no base instance
+    static void setupInstanceAttributes(size_t firstByte = 0) {
+        const GLsizei stride = sizeof(SpriteInstance);
+
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, stride, (void*)(firstByte + offsetof(SpriteInstance, x)));
+        glEnableVertexAttribArray(0);
+        glVertexAttribDivisor(0, 1);
+
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, stride, (void*)(firstByte + offsetof(SpriteInstance, scaleX)));
+        glEnableVertexAttribArray(1);
+        glVertexAttribDivisor(1, 1);
+
+        glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, stride, (void*)(firstByte + offsetof(SpriteInstance, rotation)));
+        glEnableVertexAttribArray(2);
+        glVertexAttribDivisor(2, 1);
+
+        glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, stride, (void*)(firstByte + offsetof(SpriteInstance, u0)));
+        glEnableVertexAttribArray(3);
+        glVertexAttribDivisor(3, 1);
+
+        glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, stride, (void*)(firstByte + offsetof(SpriteInstance, r)));
+        glEnableVertexAttribArray(4);
+        glVertexAttribDivisor(4, 1);
+
+        glVertexAttribIPointer(5, 1, GL_INT, stride, (void*)(firstByte + offsetof(SpriteInstance, textureID)));
+        glEnableVertexAttribArray(5);
+        glVertexAttribDivisor(5, 1);
+    }
+};
+
 class Line : public IRenderable {
 public:
     max::vec2<float> start, end;
@@ -887,7 +1447,7 @@ class Box2D_DebugRenderer{
     Box2D_DebugRenderer(){
         shader = ShaderFactory::create<LineShader>("resources/shaders/debug.vert","resources/shaders/debug.frag");
 
-        renderer = std::make_shared<AbstractBatchRenderer<LineVertex::Data>>(
+        renderer = std::make_shared<QuadBatchRenderer<LineVertex::Data>>(
             500, 500*(3/2), 
             []() { 
                 LineVertex dummy{0,0,0,0,0,0,0,0,0,0};
@@ -0,0 +1,389 @@
+#ifndef T_2DATLAS_H
+#define T_2DATLAS_H
+#include "max.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct AtlasRect {
+    int x = 0, y = 0, width = 0, height = 0;
+    bool operator==(const AtlasRect& o) const { return x == o.x && y == o.y && width == o.width && height == o.height; }
+};
+
+//! MaxRects bin with best short side fit, no rotation so UVs stay axis aligned
+class MaxRectsPacker {
+    int binWidth, binHeight;
+    std::vector<AtlasRect> freeRects;
+    size_t usedArea = 0;
+
+    static bool contains(const AtlasRect& outer, const AtlasRect& inner) {
+        return inner.x >= outer.x && inner.y >= outer.y && inner.x + inner.width <= outer.x + outer.width &&
+               inner.y + inner.height <= outer.y + outer.height;
+    }
+
+    void split(const AtlasRect& used) {
+        std::vector<AtlasRect> next;
+        next.reserve(freeRects.size() + 4);
+        for (const AtlasRect& f : freeRects) {
+            if (used.x >= f.x + f.width || used.x + used.width <= f.x || used.y >= f.y + f.height ||
+                used.y + used.height <= f.y) {
+                next.push_back(f);
+                continue;
+            }
+            if (used.x > f.x) next.push_back({f.x, f.y, used.x - f.x, f.height});
+            if (used.x + used.width < f.x + f.width)
+                next.push_back({used.x + used.width, f.y, f.x + f.width - used.x - used.width, f.height});
+            if (used.y > f.y) next.push_back({f.x, f.y, f.width, used.y - f.y});
+            if (used.y + used.height < f.y + f.height)
+                next.push_back({f.x, used.y + used.height, f.width, f.y + f.height - used.y - used.height});
+        }
+        // a free rect inside another one adds nothing, of two equal ones the first stays
+        freeRects.clear();
+        for (size_t i = 0; i < next.size(); i++) {
+            bool redundant = false;
+            for (size_t j = 0; j < next.size() && !redundant; j++) {
+                if (i == j || !contains(next[j], next[i])) continue;
+                redundant = !(next[i] == next[j]) || j < i;
+            }
+            if (!redundant) freeRects.push_back(next[i]);
+        }
+    }
+
+public:
+    MaxRectsPacker(int width, int height) : binWidth(width), binHeight(height) {
+        freeRects.push_back({0, 0, width, height});
+    }
+
+    bool insert(int width, int height, AtlasRect& out) {
+        int bestShort = INT32_MAX, bestLong = INT32_MAX;
+        const AtlasRect* best = nullptr;
+        for (const AtlasRect& f : freeRects) {
+            if (f.width < width || f.height < height) continue;
+            int dx = f.width - width, dy = f.height - height;
+            int shortSide = (std::min)(dx, dy), longSide = (std::max)(dx, dy);
+            if (shortSide < bestShort || (shortSide == bestShort && longSide < bestLong)) {
+                bestShort = shortSide;
+                bestLong = longSide;
+                best = &f;
+            }
+        }
+        if (!best) return false;
+        out = {best->x, best->y, width, height};
+        split(out);
+        usedArea += static_cast<size_t>(width) * height;
+        return true;
+    }
+
+    float occupancy() const { return usedArea / static_cast<float>(static_cast<size_t>(binWidth) * binHeight); }
+    int getWidth() const { return binWidth; }
+    int getHeight() const { return binHeight; }
+};
+
+//! source image for the packer, RGBA8 rows top down
+struct AtlasImage {
+    std::string name;
+    int width = 0, height = 0;
+    std::vector<uint8_t> rgba;
+};
+
+struct AtlasBuildOptions {
+    int maxSize = 2048;
+    //! empty pixels between neighbouring cells
+    int padding = 2;
+    //! edge pixels repeated around each sprite so filtering never samples a neighbour
+    int extrude = 1;
+    //! cut fully transparent borders, the offset keeps the sprite where it was
+    bool trim = true;
+};
+
+//! x, y, width, height are the trimmed content inside its page, top down pixels
+struct AtlasSprite {
+    std::string name;
+    uint16_t page = 0;
+    uint16_t x = 0, y = 0, width = 0, height = 0;
+    //! where the trimmed content sat inside the source image
+    int16_t offsetX = 0, offsetY = 0;
+    uint16_t sourceWidth = 0, sourceHeight = 0;
+};
+
+struct AtlasPage {
+    int width = 0, height = 0;
+    //! image file next to the manifest
+    std::string file;
+    //! only filled by buildAtlas, the runtime loads the image file instead
+    std::vector<uint8_t> rgba;
+};
+
+//! name -> page and rect table written by the offline packer, read at runtime
+class AtlasManifest {
+    std::unordered_map<std::string, size_t> byName;
+    std::string directory;
+
+    template <typename T>
+    static void put(std::vector<uint8_t>& out, T value) {
+        uint8_t bytes[sizeof(T)];
+        std::memcpy(bytes, &value, sizeof(T));
+        out.insert(out.end(), bytes, bytes + sizeof(T));
+    }
+    static void putString(std::vector<uint8_t>& out, const std::string& text) {
+        put<uint16_t>(out, static_cast<uint16_t>(text.size()));
+        out.insert(out.end(), text.begin(), text.end());
+    }
+
+    struct Reader {
+        const uint8_t* data;
+        size_t size, at = 0;
+        bool ok = true;
+        template <typename T>
+        T get() {
+            T value{};
+            if (at + sizeof(T) > size) {
+                ok = false;
+                return value;
+            }
+            std::memcpy(&value, data + at, sizeof(T));
+            at += sizeof(T);
+            return value;
+        }
+        std::string getString() {
+            uint16_t length = get<uint16_t>();
+            if (!ok || at + length > size) {
+                ok = false;
+                return {};
+            }
+            std::string text(reinterpret_cast<const char*>(data + at), length);
+            at += length;
+            return text;
+        }
+    };
+
+public:
+    static constexpr uint32_t magic = 0x41443254;  // "T2DA"
+    static constexpr uint16_t version = 1;
+
+    std::vector<AtlasPage> pages;
+    std::vector<AtlasSprite> sprites;
+
+    void index() {
+        byName.clear();
+        for (size_t i = 0; i < sprites.size(); i++) byName[sprites[i].name] = i;
+    }
+
+    const AtlasSprite* find(const std::string& name) const {
+        auto it = byName.find(name);
+        return it == byName.end() ? nullptr : &sprites[it->second];
+    }
+
+    //! same corner order and flipped v as parse_sheet, for textures loaded with flipVertically
+    std::array<max::vec2<float>, 4> coords(const AtlasSprite& sprite) const {
+        const AtlasPage& page = pages[sprite.page];
+        float x0 = sprite.x / static_cast<float>(page.width);
+        float x1 = (sprite.x + sprite.width) / static_cast<float>(page.width);
+        float y0 = 1.0f - (sprite.y + sprite.height) / static_cast<float>(page.height);
+        float y1 = 1.0f - sprite.y / static_cast<float>(page.height);
+        return {max::vec2<float>{x0, y0}, max::vec2<float>{x1, y0}, max::vec2<float>{x1, y1}, max::vec2<float>{x0, y1}};
+    }
+
+    std::string pagePath(size_t page) const { return directory + pages[page].file; }
+
+    std::vector<uint8_t> serialize() const {
+        std::vector<uint8_t> out;
+        put<uint32_t>(out, magic);
+        put<uint16_t>(out, version);
+        put<uint16_t>(out, static_cast<uint16_t>(pages.size()));
+        put<uint32_t>(out, static_cast<uint32_t>(sprites.size()));
+        for (const AtlasPage& page : pages) {
+            put<uint16_t>(out, static_cast<uint16_t>(page.width));
+            put<uint16_t>(out, static_cast<uint16_t>(page.height));
+            putString(out, page.file);
+        }
+        for (const AtlasSprite& s : sprites) {
+            putString(out, s.name);
+            put(out, s.page);
+            put(out, s.x);
+            put(out, s.y);
+            put(out, s.width);
+            put(out, s.height);
+            put(out, s.offsetX);
+            put(out, s.offsetY);
+            put(out, s.sourceWidth);
+            put(out, s.sourceHeight);
+        }
+        return out;
+    }
+
+    bool deserialize(const uint8_t* data, size_t size) {
+        Reader in{data, size};
+        if (in.get<uint32_t>() != magic || in.get<uint16_t>() != version) {
+            std::cerr << "AtlasManifest: not a T2DA v" << version << " manifest" << std::endl;
+            return false;
+        }
+        pages.assign(in.get<uint16_t>(), {});
+        sprites.assign(in.get<uint32_t>(), {});
+        if (!in.ok || sprites.size() > size) return false;
+        for (AtlasPage& page : pages) {
+            page.width = in.get<uint16_t>();
+            page.height = in.get<uint16_t>();
+            page.file = in.getString();
+        }
+        for (AtlasSprite& s : sprites) {
+            s.name = in.getString();
+            s.page = in.get<uint16_t>();
+            s.x = in.get<uint16_t>();
+            s.y = in.get<uint16_t>();
+            s.width = in.get<uint16_t>();
+            s.height = in.get<uint16_t>();
+            s.offsetX = in.get<int16_t>();
+            s.offsetY = in.get<int16_t>();
+            s.sourceWidth = in.get<uint16_t>();
+            s.sourceHeight = in.get<uint16_t>();
+            if (s.page >= pages.size()) in.ok = false;
+        }
+        if (!in.ok) {
+            std::cerr << "AtlasManifest: truncated or corrupt manifest" << std::endl;
+            return false;
+        }
+        index();
+        return true;
+    }
+
+    bool save(const std::string& path) const {
+        std::vector<uint8_t> bytes = serialize();
+        std::ofstream file(path, std::ios::binary);
+        file.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+        return static_cast<bool>(file);
+    }
+
+    bool load(const std::string& path) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            std::cerr << "AtlasManifest: cannot open " << path << std::endl;
+            return false;
+        }
+        std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        size_t slash = path.find_last_of("/\\");
+        directory = slash == std::string::npos ? "" : path.substr(0, slash + 1);
+        return deserialize(bytes.data(), bytes.size());
+    }
+};
+
+namespace t2datlas_detail {
+inline int nextPow2(int v) {
+    int p = 1;
+    while (p < v) p <<= 1;
+    return p;
+}
+
+inline AtlasRect trimmedBounds(const AtlasImage& image) {
+    int minX = image.width, minY = image.height, maxX = -1, maxY = -1;
+    for (int y = 0; y < image.height; y++) {
+        for (int x = 0; x < image.width; x++) {
+            if (image.rgba[(static_cast<size_t>(y) * image.width + x) * 4 + 3] == 0) continue;
+            minX = (std::min)(minX, x);
+            maxX = (std::max)(maxX, x);
+            minY = (std::min)(minY, y);
+            maxY = (std::max)(maxY, y);
+        }
+    }
+    if (maxX < 0) return {0, 0, 1, 1};
+    return {minX, minY, maxX - minX + 1, maxY - minY + 1};
+}
+
+// copies the content rect of image to (dx, dy) and repeats its edges extrude pixels outwards
+inline void blitExtruded(const AtlasImage& image, const AtlasRect& content, AtlasPage& page, int dx, int dy, int extrude) {
+    auto src = [&](int x, int y) {
+        x = (std::clamp)(x, 0, content.width - 1);
+        y = (std::clamp)(y, 0, content.height - 1);
+        return &image.rgba[(static_cast<size_t>(content.y + y) * image.width + content.x + x) * 4];
+    };
+    for (int y = -extrude; y < content.height + extrude; y++) {
+        for (int x = -extrude; x < content.width + extrude; x++) {
+            std::memcpy(&page.rgba[(static_cast<size_t>(dy + y) * page.width + dx + x) * 4], src(x, y), 4);
+        }
+    }
+}
+}  // namespace t2datlas_detail
+
+//! packs images into as few power of two pages as maxSize allows, page files are left for the caller to name
+inline AtlasManifest buildAtlas(const std::vector<AtlasImage>& images, const AtlasBuildOptions& options = {}) {
+    using namespace t2datlas_detail;
+    AtlasManifest manifest;
+    std::vector<AtlasRect> content(images.size());
+    std::vector<size_t> remaining;
+    int border = options.extrude * 2 + options.padding;
+    for (size_t i = 0; i < images.size(); i++) {
+        content[i] = options.trim ? trimmedBounds(images[i]) : AtlasRect{0, 0, images[i].width, images[i].height};
+        if (content[i].width + border > options.maxSize || content[i].height + border > options.maxSize) {
+            std::cerr << "buildAtlas: " << images[i].name << " does not fit a " << options.maxSize << " page" << std::endl;
+            continue;
+        }
+        remaining.push_back(i);
+    }
+    // big sides first, MaxRects fills around them much better
+    std::stable_sort(remaining.begin(), remaining.end(), [&](size_t a, size_t b) {
+        int sa = (std::max)(content[a].width, content[a].height), sb = (std::max)(content[b].width, content[b].height);
+        if (sa != sb) return sa > sb;
+        return content[a].width * content[a].height > content[b].width * content[b].height;
+    });
+
+    while (!remaining.empty()) {
+        size_t area = 0;
+        for (size_t i : remaining) area += static_cast<size_t>(content[i].width + border) * (content[i].height + border);
+        int side = (std::min)(options.maxSize, nextPow2(static_cast<int>(std::ceil(std::sqrt(static_cast<double>(area))))));
+        int width = side, height = side;
+
+        std::vector<std::pair<size_t, AtlasRect>> placed;
+        std::vector<size_t> leftover;
+        while (true) {
+            MaxRectsPacker packer(width, height);
+            placed.clear();
+            leftover.clear();
+            for (size_t i : remaining) {
+                AtlasRect cell;
+                if (packer.insert(content[i].width + border, content[i].height + border, cell)) placed.push_back({i, cell});
+                else leftover.push_back(i);
+            }
+            if (leftover.empty() || (width >= options.maxSize && height >= options.maxSize)) break;
+            if (width <= height && width < options.maxSize) width *= 2;
+            else height *= 2;
+        }
+
+        AtlasPage page;
+        page.width = width;
+        page.height = height;
+        page.rgba.assign(static_cast<size_t>(width) * height * 4, 0);
+        uint16_t pageIndex = static_cast<uint16_t>(manifest.pages.size());
+        for (const auto& [i, cell] : placed) {
+            const AtlasImage& image = images[i];
+            const AtlasRect& c = content[i];
+            int x = cell.x + options.extrude, y = cell.y + options.extrude;
+            blitExtruded(image, c, page, x, y, options.extrude);
+
+            AtlasSprite sprite;
+            sprite.name = image.name;
+            sprite.page = pageIndex;
+            sprite.x = static_cast<uint16_t>(x);
+            sprite.y = static_cast<uint16_t>(y);
+            sprite.width = static_cast<uint16_t>(c.width);
+            sprite.height = static_cast<uint16_t>(c.height);
+            sprite.offsetX = static_cast<int16_t>(c.x);
+            sprite.offsetY = static_cast<int16_t>(c.y);
+            sprite.sourceWidth = static_cast<uint16_t>(image.width);
+            sprite.sourceHeight = static_cast<uint16_t>(image.height);
+            manifest.sprites.push_back(sprite);
+        }
+        manifest.pages.push_back(std::move(page));
+        remaining.swap(leftover);
+    }
+    manifest.index();
+    return manifest;
+}
+
+#endif
@@ -0,0 +1,565 @@
+#ifndef T_2DGLYPHATLAS_H
+#define T_2DGLYPHATLAS_H
+#include <workerpool.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include FT_OUTLINE_H
+
+constexpr uint32_t T2D_REPLACEMENT_CHAR = 0xFFFD;
+
+//! decodes one codepoint at i and advances i, malformed sequences give U+FFFD
+inline uint32_t utf8Next(std::string_view text, size_t& i) {
+    auto byte = [&](size_t at) { return static_cast<unsigned char>(text[at]); };
+    unsigned char lead = byte(i++);
+    if (lead < 0x80) return lead;
+
+    int extra;
+    uint32_t cp;
+    if ((lead & 0xE0) == 0xC0) { extra = 1; cp = lead & 0x1F; }
+    else if ((lead & 0xF0) == 0xE0) { extra = 2; cp = lead & 0x0F; }
+    else if ((lead & 0xF8) == 0xF0) { extra = 3; cp = lead & 0x07; }
+    else return T2D_REPLACEMENT_CHAR;
+
+    for (int k = 0; k < extra; k++) {
+        if (i >= text.size() || (byte(i) & 0xC0) != 0x80) return T2D_REPLACEMENT_CHAR;
+        cp = (cp << 6) | (byte(i++) & 0x3F);
+    }
+    static const uint32_t minimum[4] = {0, 0x80, 0x800, 0x10000};
+    if (cp < minimum[extra] || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) return T2D_REPLACEMENT_CHAR;
+    return cp;
+}
+
+inline std::vector<uint32_t> utf8Decode(std::string_view text) {
+    std::vector<uint32_t> out;
+    out.reserve(text.size());
+    for (size_t i = 0; i < text.size();) out.push_back(utf8Next(text, i));
+    return out;
+}
+
+//! single channel coverage, rows bottom-up like UIFont::init writes them
+struct GlyphBitmap {
+    int width = 0, height = 0;
+    int bearingX = 0, bearingY = 0;
+    int advance = 0;  // 26.6 fixed point, same as Character::advance
+    std::vector<uint8_t> pixels;
+};
+
+class IGlyphRasterizer {
+public:
+    virtual ~IGlyphRasterizer() = default;
+    virtual bool rasterize(uint32_t codepoint, GlyphBitmap& out) = 0;
+    //! true when the bitmaps hold signed distances instead of coverage
+    virtual bool distanceField() const { return false; }
+};
+
+//! one straight piece of a flattened outline, in pixels with y up
+struct SdfSegment {
+    float x0, y0, x1, y1;
+};
+
+//! 128 sits on the outline, inside is brighter, spread is the distance in pixels that maps to 0 and 255
+inline void buildSdf(const std::vector<SdfSegment>& segments, float originX, float originY,
+                     int spread, GlyphBitmap& out) {
+    out.pixels.assign(static_cast<size_t>(out.width) * out.height, 0);
+    for (int row = 0; row < out.height; row++) {
+        float py = originY + row + 0.5f;
+        for (int col = 0; col < out.width; col++) {
+            float px = originX + col + 0.5f;
+            float best = 1e30f;
+            int winding = 0;
+            for (const auto& seg : segments) {
+                float dx = seg.x1 - seg.x0, dy = seg.y1 - seg.y0;
+                float lenSq = dx * dx + dy * dy;
+                float t = lenSq > 0.0f ? ((px - seg.x0) * dx + (py - seg.y0) * dy) / lenSq : 0.0f;
+                t = (std::max)(0.0f, (std::min)(1.0f, t));
+                float ex = seg.x0 + dx * t - px, ey = seg.y0 + dy * t - py;
+                best = (std::min)(best, ex * ex + ey * ey);
+
+                // nonzero winding, so overlapping contours stay filled
+                if (seg.y0 <= py) {
+                    if (seg.y1 > py && dx * (py - seg.y0) - (px - seg.x0) * dy > 0) winding++;
+                } else if (seg.y1 <= py && dx * (py - seg.y0) - (px - seg.x0) * dy < 0) {
+                    winding--;
+                }
+            }
+            float distance = std::sqrt(best) * (winding != 0 ? 1.0f : -1.0f);
+            float v = 0.5f + distance / (2.0f * spread);
+            v = (std::max)(0.0f, (std::min)(1.0f, v));
+            out.pixels[static_cast<size_t>(row) * out.width + col] = static_cast<uint8_t>(v * 255.0f + 0.5f);
+        }
+    }
+}
+
+//! owns its own FT_Library so it can live on a worker thread
+class FreeTypeGlyphRasterizer : public IGlyphRasterizer {
+    FT_Library ft = nullptr;
+    FT_Face face = nullptr;
+
+public:
+    FreeTypeGlyphRasterizer(const std::string& fontPath, int pixelSize) {
+        if (FT_Init_FreeType(&ft)) {
+            std::cerr << "FREETYPE: Init failed" << std::endl;
+            ft = nullptr;
+            return;
+        }
+        if (FT_New_Face(ft, fontPath.c_str(), 0, &face)) {
+            std::cerr << "FREETYPE: Font load failed " << fontPath << std::endl;
+            face = nullptr;
+            return;
+        }
+        FT_Set_Pixel_Sizes(face, 0, pixelSize);
+    }
+    ~FreeTypeGlyphRasterizer() {
+        if (face) FT_Done_Face(face);
+        if (ft) FT_Done_FreeType(ft);
+    }
+    bool valid() const { return face != nullptr; }
+
+    bool rasterize(uint32_t codepoint, GlyphBitmap& out) override {
+        if (!face || FT_Load_Char(face, codepoint, FT_LOAD_RENDER)) return false;
+        const auto& bitmap = face->glyph->bitmap;
+        out.width = bitmap.width;
+        out.height = bitmap.rows;
+        out.bearingX = face->glyph->bitmap_left;
+        out.bearingY = face->glyph->bitmap_top;
+        out.advance = static_cast<int>(face->glyph->advance.x);
+        out.pixels.resize(static_cast<size_t>(out.width) * out.height);
+        for (int i = 0; i < out.height; ++i) {
+            const unsigned char* row = bitmap.buffer + (out.height - 1 - i) * bitmap.pitch;
+            std::memcpy(&out.pixels[static_cast<size_t>(i) * out.width], row, out.width);
+        }
+        return true;
+    }
+};
+
+//! distance field glyphs from the outline at one base size, a single atlas then serves every text size
+class FreeTypeSdfRasterizer : public IGlyphRasterizer {
+    FT_Library ft = nullptr;
+    FT_Face face = nullptr;
+    int spread;
+    int curveSteps;
+
+    struct Flattener {
+        std::vector<SdfSegment>* segments;
+        float x = 0, y = 0, startX = 0, startY = 0;
+        int steps;
+
+        static float px(FT_Pos v) { return static_cast<float>(v) / 64.0f; }
+        void lineTo(float nx, float ny) {
+            if (nx != x || ny != y) segments->push_back({x, y, nx, ny});
+            x = nx;
+            y = ny;
+        }
+        void close() { lineTo(startX, startY); }
+
+        static int moveTo(const FT_Vector* to, void* user) {
+            auto* self = static_cast<Flattener*>(user);
+            self->close();
+            self->x = self->startX = px(to->x);
+            self->y = self->startY = px(to->y);
+            return 0;
+        }
+        static int line(const FT_Vector* to, void* user) {
+            static_cast<Flattener*>(user)->lineTo(px(to->x), px(to->y));
+            return 0;
+        }
+        static int conic(const FT_Vector* c, const FT_Vector* to, void* user) {
+            auto* self = static_cast<Flattener*>(user);
+            float x0 = self->x, y0 = self->y;
+            for (int i = 1; i <= self->steps; i++) {
+                float t = static_cast<float>(i) / self->steps, u = 1.0f - t;
+                self->lineTo(u * u * x0 + 2 * u * t * px(c->x) + t * t * px(to->x),
+                             u * u * y0 + 2 * u * t * px(c->y) + t * t * px(to->y));
+            }
+            return 0;
+        }
+        static int cubic(const FT_Vector* c1, const FT_Vector* c2, const FT_Vector* to, void* user) {
+            auto* self = static_cast<Flattener*>(user);
+            float x0 = self->x, y0 = self->y;
+            for (int i = 1; i <= self->steps; i++) {
+                float t = static_cast<float>(i) / self->steps, u = 1.0f - t;
+                float a = u * u * u, b = 3 * u * u * t, c = 3 * u * t * t, d = t * t * t;
+                self->lineTo(a * x0 + b * px(c1->x) + c * px(c2->x) + d * px(to->x),
+                             a * y0 + b * px(c1->y) + c * px(c2->y) + d * px(to->y));
+            }
+            return 0;
+        }
+    };
+
+public:
+    FreeTypeSdfRasterizer(const std::string& fontPath, int basePixelSize, int spread = 4, int curveSteps = 8)
+        : spread(spread), curveSteps(curveSteps) {
+        if (FT_Init_FreeType(&ft)) {
+            std::cerr << "FREETYPE: Init failed" << std::endl;
+            ft = nullptr;
+            return;
+        }
+        if (FT_New_Face(ft, fontPath.c_str(), 0, &face)) {
+            std::cerr << "FREETYPE: Font load failed " << fontPath << std::endl;
+            face = nullptr;
+            return;
+        }
+        FT_Set_Pixel_Sizes(face, 0, basePixelSize);
+    }
+    ~FreeTypeSdfRasterizer() {
+        if (face) FT_Done_Face(face);
+        if (ft) FT_Done_FreeType(ft);
+    }
+    bool valid() const { return face != nullptr; }
+    bool distanceField() const override { return true; }
+
+    bool rasterize(uint32_t codepoint, GlyphBitmap& out) override {
+        if (!face || FT_Load_Char(face, codepoint, FT_LOAD_NO_BITMAP)) return false;
+        out.advance = static_cast<int>(face->glyph->advance.x);
+
+        std::vector<SdfSegment> segments;
+        Flattener flattener{&segments};
+        flattener.steps = curveSteps;
+        FT_Outline_Funcs funcs{};
+        funcs.move_to = &Flattener::moveTo;
+        funcs.line_to = &Flattener::line;
+        funcs.conic_to = &Flattener::conic;
+        funcs.cubic_to = &Flattener::cubic;
+        if (FT_Outline_Decompose(&face->glyph->outline, &funcs, &flattener)) return false;
+        flattener.close();
+
+        if (segments.empty()) {
+            out.width = out.height = 0;
+            out.pixels.clear();
+            return true;
+        }
+        float minX = 1e30f, minY = 1e30f, maxX = -1e30f, maxY = -1e30f;
+        for (const auto& seg : segments) {
+            minX = (std::min)({minX, seg.x0, seg.x1});
+            maxX = (std::max)({maxX, seg.x0, seg.x1});
+            minY = (std::min)({minY, seg.y0, seg.y1});
+            maxY = (std::max)({maxY, seg.y0, seg.y1});
+        }
+        int left = static_cast<int>(std::floor(minX)) - spread;
+        int bottom = static_cast<int>(std::floor(minY)) - spread;
+        int top = static_cast<int>(std::ceil(maxY)) + spread;
+        out.width = static_cast<int>(std::ceil(maxX)) + spread - left;
+        out.height = top - bottom;
+        out.bearingX = left;
+        out.bearingY = top;
+        buildSdf(segments, static_cast<float>(left), static_cast<float>(bottom), spread, out);
+        return true;
+    }
+};
+
+inline uint64_t glyphAtlasKey(uint16_t font, uint16_t size, uint32_t codepoint) {
+    return (static_cast<uint64_t>(font) << 48) | (static_cast<uint64_t>(size) << 32) | codepoint;
+}
+
+struct AtlasGlyph {
+    int page = 0;
+    int x = 0, y = 0, width = 0, height = 0;
+    int bearingX = 0, bearingY = 0;
+    int advance = 0;
+    float u0 = 0, v0 = 0, u1 = 0, v1 = 0;
+    int shelf = 0;
+    uint64_t lastUsed = 0;
+};
+
+//! CPU side R8 atlas, shelf packed across pages, least recently used shelves are recycled when full
+class GlyphAtlas {
+public:
+    struct Shelf {
+        int y = 0, height = 0, cursorX = 0;
+        uint64_t lastUsed = 0;
+        std::vector<uint64_t> keys;
+    };
+    struct Page {
+        std::vector<uint8_t> pixels;
+        std::vector<Shelf> shelves;
+        int nextShelfY = 0;
+        int dirtyMinY = INT32_MAX, dirtyMaxY = -1;
+        bool dirty() const { return dirtyMaxY >= dirtyMinY; }
+    };
+
+private:
+    int pageSize;
+    size_t maxPages;
+    int padding = 1;
+    std::vector<Page> pages;
+    std::unordered_map<uint64_t, AtlasGlyph> glyphs;
+    uint64_t tick = 0;
+    uint64_t generation = 0;
+    size_t evictions = 0;
+
+    void markDirty(Page& page, int y0, int y1) {
+        page.dirtyMinY = (std::min)(page.dirtyMinY, y0);
+        page.dirtyMaxY = (std::max)(page.dirtyMaxY, y1);
+    }
+
+    void evictShelf(Page& page, Shelf& shelf) {
+        for (uint64_t key : shelf.keys) glyphs.erase(key);
+        evictions += shelf.keys.size();
+        shelf.keys.clear();
+        shelf.cursorX = 0;
+        for (int row = shelf.y; row < shelf.y + shelf.height; row++) {
+            std::memset(&page.pixels[static_cast<size_t>(row) * pageSize], 0, pageSize);
+        }
+        markDirty(page, shelf.y, shelf.y + shelf.height - 1);
+        generation++;
+    }
+
+    // best fitting shelf with room, then a new shelf, then a new page
+    bool findSpace(int w, int h, int& pageIndex, int& shelfIndex) {
+        int bestWaste = INT32_MAX;
+        pageIndex = shelfIndex = -1;
+        for (size_t p = 0; p < pages.size(); p++) {
+            for (size_t s = 0; s < pages[p].shelves.size(); s++) {
+                const Shelf& shelf = pages[p].shelves[s];
+                if (shelf.height < h || shelf.cursorX + w > pageSize) continue;
+                int waste = shelf.height - h;
+                if (waste < bestWaste) {
+                    bestWaste = waste;
+                    pageIndex = static_cast<int>(p);
+                    shelfIndex = static_cast<int>(s);
+                }
+            }
+        }
+        // a much taller shelf wastes more than opening a fresh one
+        if (pageIndex >= 0 && bestWaste <= h / 2) return true;
+
+        for (size_t p = 0; p < pages.size(); p++) {
+            if (pages[p].nextShelfY + h <= pageSize) {
+                Shelf shelf;
+                shelf.y = pages[p].nextShelfY;
+                shelf.height = h;
+                pages[p].nextShelfY += h;
+                pages[p].shelves.push_back(shelf);
+                pageIndex = static_cast<int>(p);
+                shelfIndex = static_cast<int>(pages[p].shelves.size() - 1);
+                return true;
+            }
+        }
+        if (pageIndex >= 0) return true;
+
+        if (pages.size() < maxPages) {
+            Page page;
+            page.pixels.assign(static_cast<size_t>(pageSize) * pageSize, 0);
+            pages.push_back(std::move(page));
+            return findSpace(w, h, pageIndex, shelfIndex);
+        }
+        return false;
+    }
+
+    bool evictForSpace(int h) {
+        Shelf* victim = nullptr;
+        Page* victimPage = nullptr;
+        for (auto& page : pages) {
+            for (auto& shelf : page.shelves) {
+                if (shelf.height < h) continue;
+                if (!victim || shelf.lastUsed < victim->lastUsed) {
+                    victim = &shelf;
+                    victimPage = &page;
+                }
+            }
+        }
+        if (victim) {
+            evictShelf(*victimPage, *victim);
+            return true;
+        }
+
+        // no shelf is tall enough, recycle the stalest page as a whole
+        Page* stalest = nullptr;
+        uint64_t stalestUse = UINT64_MAX;
+        for (auto& page : pages) {
+            uint64_t newest = 0;
+            for (auto& shelf : page.shelves) newest = (std::max)(newest, shelf.lastUsed);
+            if (newest < stalestUse) {
+                stalestUse = newest;
+                stalest = &page;
+            }
+        }
+        if (!stalest) return false;
+        for (auto& shelf : stalest->shelves) evictShelf(*stalest, shelf);
+        stalest->shelves.clear();
+        stalest->nextShelfY = 0;
+        return true;
+    }
+
+public:
+    explicit GlyphAtlas(int pageSize = 512, size_t maxPages = 4) : pageSize(pageSize), maxPages(maxPages) {}
+
+    //! marks the glyph as used this tick
+    const AtlasGlyph* find(uint64_t key) {
+        auto it = glyphs.find(key);
+        if (it == glyphs.end()) return nullptr;
+        touch(it->second);
+        return &it->second;
+    }
+
+    void touch(uint64_t key) {
+        auto it = glyphs.find(key);
+        if (it != glyphs.end()) touch(it->second);
+    }
+
+    const AtlasGlyph* insert(uint64_t key, const GlyphBitmap& bitmap) {
+        if (auto* existing = find(key)) return existing;
+        int w = bitmap.width + padding;
+        int h = bitmap.height + padding;
+        if (w > pageSize || h > pageSize) {
+            std::cerr << "GlyphAtlas: glyph larger than a page" << std::endl;
+            return nullptr;
+        }
+
+        int pageIndex, shelfIndex;
+        if (!findSpace(w, h, pageIndex, shelfIndex)) {
+            if (!evictForSpace(h) || !findSpace(w, h, pageIndex, shelfIndex)) return nullptr;
+        }
+
+        Page& page = pages[pageIndex];
+        Shelf& shelf = page.shelves[shelfIndex];
+        AtlasGlyph glyph;
+        glyph.page = pageIndex;
+        glyph.shelf = shelfIndex;
+        glyph.x = shelf.cursorX;
+        glyph.y = shelf.y;
+        glyph.width = bitmap.width;
+        glyph.height = bitmap.height;
+        glyph.bearingX = bitmap.bearingX;
+        glyph.bearingY = bitmap.bearingY;
+        glyph.advance = bitmap.advance;
+        glyph.u0 = static_cast<float>(glyph.x) / pageSize;
+        glyph.v0 = static_cast<float>(glyph.y) / pageSize;
+        glyph.u1 = static_cast<float>(glyph.x + glyph.width) / pageSize;
+        glyph.v1 = static_cast<float>(glyph.y + glyph.height) / pageSize;
+        shelf.cursorX += w;
+        shelf.keys.push_back(key);
+
+        for (int row = 0; row < bitmap.height; row++) {
+            std::memcpy(&page.pixels[static_cast<size_t>(glyph.y + row) * pageSize + glyph.x],
+                        &bitmap.pixels[static_cast<size_t>(row) * bitmap.width], bitmap.width);
+        }
+        if (bitmap.height > 0) markDirty(page, glyph.y, glyph.y + bitmap.height - 1);
+
+        auto& stored = glyphs[key] = glyph;
+        touch(stored);
+        return &stored;
+    }
+
+    //! call once per frame, recency is measured in ticks
+    void nextTick() { tick++; }
+
+    const std::vector<Page>& getPages() const { return pages; }
+    void clearDirty(size_t page) {
+        pages[page].dirtyMinY = INT32_MAX;
+        pages[page].dirtyMaxY = -1;
+    }
+    int getPageSize() const { return pageSize; }
+    size_t getMaxPages() const { return maxPages; }
+    size_t glyphCount() const { return glyphs.size(); }
+    size_t evictionCount() const { return evictions; }
+    //! bumps whenever glyphs are evicted, cached UVs older than this are stale
+    uint64_t getGeneration() const { return generation; }
+
+private:
+    void touch(AtlasGlyph& glyph) {
+        glyph.lastUsed = tick;
+        auto& shelf = pages[glyph.page].shelves[glyph.shelf];
+        shelf.lastUsed = (std::max)(shelf.lastUsed, tick);
+    }
+};
+
+//! one font at one pixel size feeding a shared atlas, rasterizing misses on a worker
+class GlyphCache {
+    std::shared_ptr<GlyphAtlas> atlas;
+    std::shared_ptr<IGlyphRasterizer> rasterizer;
+    uint16_t fontID;
+    uint16_t pixelSize;
+
+    std::unordered_set<uint32_t> requested;
+    std::mutex readyMutex;
+    std::vector<std::pair<uint32_t, GlyphBitmap>> ready;
+    std::unordered_set<uint32_t> missing;
+    std::unique_ptr<WorkerPool> worker;
+
+public:
+    GlyphCache(std::shared_ptr<GlyphAtlas> atlas, std::shared_ptr<IGlyphRasterizer> rasterizer,
+               uint16_t fontID, uint16_t pixelSize, bool async = true)
+        : atlas(std::move(atlas)), rasterizer(std::move(rasterizer)), fontID(fontID), pixelSize(pixelSize) {
+        if (async) worker = std::make_unique<WorkerPool>(1);
+    }
+    ~GlyphCache() {
+        if (worker) worker->stop();
+    }
+
+    uint64_t key(uint32_t codepoint) const { return glyphAtlasKey(fontID, pixelSize, codepoint); }
+
+    //! nullptr while the glyph is still being rasterized or has no outline in the font
+    const AtlasGlyph* get(uint32_t codepoint) {
+        if (const AtlasGlyph* glyph = atlas->find(key(codepoint))) return glyph;
+        if (missing.count(codepoint)) return nullptr;
+
+        if (!worker) {
+            GlyphBitmap bitmap;
+            if (!rasterizer->rasterize(codepoint, bitmap)) {
+                missing.insert(codepoint);
+                return nullptr;
+            }
+            return atlas->insert(key(codepoint), bitmap);
+        }
+
+        if (requested.insert(codepoint).second) {
+            auto source = rasterizer;
+            worker->submit([this, source, codepoint] {
+                GlyphBitmap bitmap;
+                if (!source->rasterize(codepoint, bitmap)) bitmap.width = -1;
+                std::lock_guard<std::mutex> lock(readyMutex);
+                ready.emplace_back(codepoint, std::move(bitmap));
+            });
+        }
+        return nullptr;
+    }
+
+    //! moves finished rasterizations into the atlas, returns how many landed
+    size_t pump() {
+        std::vector<std::pair<uint32_t, GlyphBitmap>> done;
+        {
+            std::lock_guard<std::mutex> lock(readyMutex);
+            done.swap(ready);
+        }
+        size_t inserted = 0;
+        for (auto& [codepoint, bitmap] : done) {
+            requested.erase(codepoint);
+            if (bitmap.width < 0) {
+                missing.insert(codepoint);
+                continue;
+            }
+            if (atlas->insert(key(codepoint), bitmap)) inserted++;
+        }
+        return inserted;
+    }
+
+    //! blocks until queued rasterizations finished, for tests and loading screens
+    void flush() {
+        if (!worker) return;
+        while (worker->pending() > 0) std::this_thread::yield();
+        pump();
+    }
+
+    //! the rasterizer had nothing for this codepoint, it will not be requested again
+    bool isMissing(uint32_t codepoint) const { return missing.count(codepoint) != 0; }
+    bool distanceField() const { return rasterizer->distanceField(); }
+    GlyphAtlas& getAtlas() { return *atlas; }
+    size_t pendingCount() const { return requested.size(); }
+};
+
+#endif
@@ -0,0 +1,292 @@
+#ifndef T_2DLAYOUT_H
+#define T_2DLAYOUT_H
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+struct LayoutLength {
+    enum Unit : uint8_t { AUTO, PIXELS, PERCENT };
+    float value = 0.0f;
+    Unit unit = AUTO;
+
+    static LayoutLength autoSize() { return {}; }
+    static LayoutLength px(float v) { return {v, PIXELS}; }
+    static LayoutLength percent(float v) { return {v, PERCENT}; }
+
+    bool operator==(const LayoutLength& other) const { return value == other.value && unit == other.unit; }
+    bool operator!=(const LayoutLength& other) const { return !(*this == other); }
+};
+
+enum class FlexDirection : uint8_t { ROW, COLUMN };
+enum class FlexJustify : uint8_t { START, CENTER, END, SPACE_BETWEEN, SPACE_AROUND };
+enum class FlexAlign : uint8_t { START, CENTER, END, STRETCH };
+
+struct LayoutStyle {
+    LayoutLength width, height;
+    FlexDirection direction = FlexDirection::ROW;
+    FlexJustify justify = FlexJustify::START;
+    FlexAlign alignItems = FlexAlign::START;
+    bool wrap = false;
+    float gap = 0.0f;
+    float padding = 0.0f;
+    //! share of the free main axis space this item takes
+    float grow = 0.0f;
+    //! skipped by the layout, it keeps whatever position it has
+    bool ignore = false;
+
+    bool operator==(const LayoutStyle& o) const {
+        return width == o.width && height == o.height && direction == o.direction && justify == o.justify &&
+               alignItems == o.alignItems && wrap == o.wrap && gap == o.gap && padding == o.padding &&
+               grow == o.grow && ignore == o.ignore;
+    }
+    bool operator!=(const LayoutStyle& o) const { return !(*this == o); }
+};
+
+//! x, y from the parent's top left corner, y grows downwards
+struct LayoutRect {
+    float x = 0.0f, y = 0.0f, width = 0.0f, height = 0.0f;
+    bool operator==(const LayoutRect& o) const { return x == o.x && y == o.y && width == o.width && height == o.height; }
+    bool operator!=(const LayoutRect& o) const { return !(*this == o); }
+};
+
+//! flexbox subset over flat arrays, node 0 is the root, measure results are cached per constraint
+class LayoutTree {
+    static constexpr int none = -1;
+
+    std::vector<LayoutStyle> styles;
+    std::vector<int> parents, firstChild, lastChild, nextSibling;
+    std::vector<float> intrinsicW, intrinsicH;
+    std::vector<float> measuredW, measuredH;
+    std::vector<float> cacheAvailW, cacheAvailH;
+    //! leaves without percentages measure the same under any constraint
+    std::vector<uint8_t> constraintFree;
+    std::vector<LayoutRect> rects;
+    std::vector<uint8_t> dirty;
+    std::vector<uint8_t> arranged;
+    size_t measures = 0;
+    size_t arranges = 0;
+
+    struct Line {
+        int first = -1, count = 0;
+        float main = 0.0f, cross = 0.0f, grow = 0.0f;
+    };
+    // lines of every node on the current measure/arrange path, used as a stack to keep recursion allocation free
+    std::vector<Line> lineStack;
+
+    static float resolve(const LayoutLength& length, float available, float fallback) {
+        switch (length.unit) {
+            case LayoutLength::PIXELS: return length.value;
+            case LayoutLength::PERCENT: return available * length.value / 100.0f;
+            default: return fallback;
+        }
+    }
+    bool row(int node) const { return styles[node].direction == FlexDirection::ROW; }
+    int nextItem(int c) const {
+        while (c != none && styles[c].ignore) c = nextSibling[c];
+        return c;
+    }
+
+    // greedy line breaking on the main axis over already measured children, pushed onto lineStack
+    void buildLines(int node, float innerMain) {
+        const LayoutStyle& style = styles[node];
+        bool isRow = row(node);
+        Line line;
+        for (int c = nextItem(firstChild[node]); c != none; c = nextItem(nextSibling[c])) {
+            float main = isRow ? measuredW[c] : measuredH[c];
+            float cross = isRow ? measuredH[c] : measuredW[c];
+            float withGap = line.count > 0 ? main + style.gap : main;
+            if (style.wrap && line.count > 0 && line.main + withGap > innerMain) {
+                lineStack.push_back(line);
+                line = Line{};
+                withGap = main;
+            }
+            if (line.count == 0) line.first = c;
+            line.main += withGap;
+            line.cross = (std::max)(line.cross, cross);
+            line.grow += styles[c].grow;
+            line.count++;
+        }
+        if (line.count > 0) lineStack.push_back(line);
+    }
+
+    void measure(int node, float availW, float availH) {
+        if (!dirty[node] && (constraintFree[node] || (cacheAvailW[node] == availW && cacheAvailH[node] == availH))) return;
+        measures++;
+        dirty[node] = 0;
+        const LayoutStyle& style = styles[node];
+        float pad = style.padding * 2.0f;
+
+        float ownW = resolve(style.width, availW, -1.0f);
+        float ownH = resolve(style.height, availH, -1.0f);
+        float innerW = (ownW >= 0.0f ? ownW : availW) - pad;
+        float innerH = (ownH >= 0.0f ? ownH : availH) - pad;
+
+        float contentW = intrinsicW[node], contentH = intrinsicH[node];
+        if (nextItem(firstChild[node]) != none) {
+            for (int c = nextItem(firstChild[node]); c != none; c = nextItem(nextSibling[c])) measure(c, innerW, innerH);
+
+            size_t base = lineStack.size();
+            buildLines(node, row(node) ? innerW : innerH);
+            float main = 0.0f, cross = 0.0f;
+            for (size_t l = base; l < lineStack.size(); l++) {
+                main = (std::max)(main, lineStack[l].main);
+                cross += lineStack[l].cross + (l > base ? style.gap : 0.0f);
+            }
+            lineStack.resize(base);
+            contentW = row(node) ? main : cross;
+            contentH = row(node) ? cross : main;
+        }
+        measuredW[node] = ownW >= 0.0f ? ownW : contentW + pad;
+        measuredH[node] = ownH >= 0.0f ? ownH : contentH + pad;
+        cacheAvailW[node] = availW;
+        cacheAvailH[node] = availH;
+        constraintFree[node] = firstChild[node] == none && style.width.unit != LayoutLength::PERCENT &&
+                               style.height.unit != LayoutLength::PERCENT;
+    }
+
+    void arrange(int node, const LayoutRect& rect) {
+        if (arranged[node] && rects[node] == rect) return;
+        arranges++;
+        rects[node] = rect;
+        arranged[node] = 1;
+        if (nextItem(firstChild[node]) == none) return;
+
+        const LayoutStyle& style = styles[node];
+        bool isRow = row(node);
+        float innerW = rect.width - style.padding * 2.0f;
+        float innerH = rect.height - style.padding * 2.0f;
+        float innerMain = isRow ? innerW : innerH;
+        float innerCross = isRow ? innerH : innerW;
+
+        for (int c = nextItem(firstChild[node]); c != none; c = nextItem(nextSibling[c])) measure(c, innerW, innerH);
+        size_t base = lineStack.size();
+        buildLines(node, innerMain);
+        size_t end = lineStack.size();
+        // a single line owns the whole cross axis, so stretch and centring use all of it
+        if (end - base == 1 && !style.wrap) lineStack[base].cross = innerCross;
+
+        float crossPos = style.padding;
+        for (size_t l = base; l < end; l++) {
+            // copied, the recursion below may grow lineStack
+            Line line = lineStack[l];
+            float free = innerMain - line.main;
+            float offset = 0.0f, spacing = style.gap;
+            if (line.grow <= 0.0f && free > 0.0f) {
+                switch (style.justify) {
+                    case FlexJustify::CENTER: offset = free / 2.0f; break;
+                    case FlexJustify::END: offset = free; break;
+                    case FlexJustify::SPACE_BETWEEN:
+                        if (line.count > 1) spacing += free / (line.count - 1);
+                        break;
+                    case FlexJustify::SPACE_AROUND:
+                        spacing += free / line.count;
+                        offset = free / line.count / 2.0f;
+                        break;
+                    default: break;
+                }
+            }
+
+            float mainPos = style.padding + offset;
+            int c = line.first;
+            for (int i = 0; i < line.count; i++, c = nextItem(nextSibling[c])) {
+                const LayoutStyle& childStyle = styles[c];
+                float main = isRow ? measuredW[c] : measuredH[c];
+                float cross = isRow ? measuredH[c] : measuredW[c];
+                if (line.grow > 0.0f && free > 0.0f) main += free * childStyle.grow / line.grow;
+
+                const LayoutLength& crossLength = isRow ? childStyle.height : childStyle.width;
+                float crossOffset = 0.0f;
+                switch (style.alignItems) {
+                    case FlexAlign::STRETCH:
+                        if (crossLength.unit == LayoutLength::AUTO) cross = line.cross;
+                        break;
+                    case FlexAlign::CENTER: crossOffset = (line.cross - cross) / 2.0f; break;
+                    case FlexAlign::END: crossOffset = line.cross - cross; break;
+                    default: break;
+                }
+
+                LayoutRect childRect;
+                if (isRow) childRect = {mainPos, crossPos + crossOffset, main, cross};
+                else childRect = {crossPos + crossOffset, mainPos, cross, main};
+                arrange(c, childRect);
+                mainPos += main + spacing;
+            }
+            crossPos += line.cross + style.gap;
+        }
+        lineStack.resize(base);
+    }
+
+public:
+    LayoutTree() { add(none, {}); }
+
+    int add(int parent, const LayoutStyle& style, float intrinsicWidth = 0.0f, float intrinsicHeight = 0.0f) {
+        int node = static_cast<int>(styles.size());
+        styles.push_back(style);
+        parents.push_back(parent);
+        firstChild.push_back(none);
+        lastChild.push_back(none);
+        nextSibling.push_back(none);
+        intrinsicW.push_back(intrinsicWidth);
+        intrinsicH.push_back(intrinsicHeight);
+        measuredW.push_back(0.0f);
+        measuredH.push_back(0.0f);
+        cacheAvailW.push_back(-1.0f);
+        cacheAvailH.push_back(-1.0f);
+        constraintFree.push_back(0);
+        rects.emplace_back();
+        dirty.push_back(1);
+        arranged.push_back(0);
+        if (parent != none) {
+            if (lastChild[parent] == none) firstChild[parent] = node;
+            else nextSibling[lastChild[parent]] = node;
+            lastChild[parent] = node;
+            markDirty(parent);
+            constraintFree[parent] = 0;
+        }
+        return node;
+    }
+
+    //! drops every node but the root
+    void clear() {
+        LayoutStyle root = styles[0];
+        *this = LayoutTree();
+        styles[0] = root;
+    }
+
+    //! dirty forces a measure, a cleared arranged flag forces an arrange, both up to the root
+    void markDirty(int node) {
+        for (int n = node; n != none; n = parents[n]) {
+            dirty[n] = 1;
+            arranged[n] = 0;
+        }
+    }
+
+    void setStyle(int node, const LayoutStyle& style) {
+        if (styles[node] == style) return;
+        styles[node] = style;
+        markDirty(node);
+    }
+    void setIntrinsic(int node, float width, float height) {
+        if (intrinsicW[node] == width && intrinsicH[node] == height) return;
+        intrinsicW[node] = width;
+        intrinsicH[node] = height;
+        markDirty(node);
+    }
+
+    //! false when nothing was dirty and the root size did not change
+    bool layout(float width, float height) {
+        LayoutRect root{0.0f, 0.0f, width, height};
+        if (arranged[0] && rects[0] == root) return false;
+        measure(0, width, height);
+        arrange(0, root);
+        return true;
+    }
+
+    const LayoutRect& rect(int node) const { return rects[node]; }
+    const LayoutStyle& style(int node) const { return styles[node]; }
+    size_t size() const { return styles.size(); }
+    size_t measureCount() const { return measures; }
+    size_t arrangeCount() const { return arranges; }
+};
+
+#endif
@@ -11,6 +11,10 @@ public:
     virtual void setProjection(const float proj[16]) = 0;
     virtual void setupUniforms() = 0;
     virtual GLuint getID() const = 0;
+    // number of sampler slots the fragment shader can index, 0 if untextured
+    virtual int getTextureSlotCount() const { return 0; }
+    // first texture of the bound window; vertex texture ids are relative to it
+    virtual void setTextureBase(int base) {}
 };
 
 class ShaderFactory {
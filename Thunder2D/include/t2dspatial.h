@@ -0,0 +1,178 @@
+#ifndef T_2DSPATIAL_H
+#define T_2DSPATIAL_H
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+struct AABB2D {
+    float minX = 0.0f, minY = 0.0f;
+    float maxX = 0.0f, maxY = 0.0f;
+
+    bool overlaps(const AABB2D& other) const {
+        return minX <= other.maxX && maxX >= other.minX &&
+               minY <= other.maxY && maxY >= other.minY;
+    }
+};
+
+//! uniform grid, entries are bucketed into every cell their bounds touch
+class SpatialGrid {
+private:
+    struct Entry {
+        AABB2D bounds;
+        int cellMinX, cellMinY, cellMaxX, cellMaxY;
+        uint32_t queryStamp = 0;
+        bool alive = false;
+    };
+
+    float cellSize;
+    std::unordered_map<uint64_t, std::vector<uint32_t>> cells;
+    std::vector<Entry> entries;
+    std::vector<uint32_t> freeHandles;
+    uint32_t currentStamp = 0;
+    size_t aliveCount = 0;
+
+    static uint64_t cellKey(int x, int y) {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(y);
+    }
+
+    int toCell(float v) const {
+        return static_cast<int>(std::floor(v / cellSize));
+    }
+
+    void link(uint32_t handle) {
+        Entry& entry = entries[handle];
+        for (int y = entry.cellMinY; y <= entry.cellMaxY; y++) {
+            for (int x = entry.cellMinX; x <= entry.cellMaxX; x++) {
+                cells[cellKey(x, y)].push_back(handle);
+            }
+        }
+    }
+
+    void unlink(uint32_t handle) {
+        Entry& entry = entries[handle];
+        for (int y = entry.cellMinY; y <= entry.cellMaxY; y++) {
+            for (int x = entry.cellMinX; x <= entry.cellMaxX; x++) {
+                auto it = cells.find(cellKey(x, y));
+                if (it == cells.end()) continue;
+                auto& bucket = it->second;
+                for (size_t i = 0; i < bucket.size(); i++) {
+                    if (bucket[i] == handle) {
+                        bucket[i] = bucket.back();
+                        bucket.pop_back();
+                        break;
+                    }
+                }
+                if (bucket.empty()) cells.erase(it);
+            }
+        }
+    }
+
+    void assignCells(Entry& entry) {
+        entry.cellMinX = toCell(entry.bounds.minX);
+        entry.cellMinY = toCell(entry.bounds.minY);
+        entry.cellMaxX = toCell(entry.bounds.maxX);
+        entry.cellMaxY = toCell(entry.bounds.maxY);
+    }
+
+    void nextStamp() {
+        if (++currentStamp == 0) {
+            for (auto& entry : entries) entry.queryStamp = 0;
+            currentStamp = 1;
+        }
+    }
+
+    void collect(const std::vector<uint32_t>& bucket, const AABB2D& area, std::vector<uint32_t>& out) {
+        for (uint32_t handle : bucket) {
+            Entry& entry = entries[handle];
+            if (entry.queryStamp == currentStamp) continue;
+            entry.queryStamp = currentStamp;
+            if (entry.bounds.overlaps(area)) out.push_back(handle);
+        }
+    }
+
+public:
+    explicit SpatialGrid(float cellSize = 256.0f) : cellSize(cellSize > 0.0f ? cellSize : 1.0f) {}
+
+    uint32_t insert(const AABB2D& bounds) {
+        uint32_t handle;
+        if (!freeHandles.empty()) {
+            handle = freeHandles.back();
+            freeHandles.pop_back();
+        } else {
+            handle = static_cast<uint32_t>(entries.size());
+            entries.emplace_back();
+        }
+        Entry& entry = entries[handle];
+        entry.bounds = bounds;
+        entry.alive = true;
+        assignCells(entry);
+        link(handle);
+        aliveCount++;
+        return handle;
+    }
+
+    //! only touches the buckets when the covered cell range changes
+    void update(uint32_t handle, const AABB2D& bounds) {
+        if (handle >= entries.size() || !entries[handle].alive) return;
+        Entry& entry = entries[handle];
+        entry.bounds = bounds;
+        if (toCell(bounds.minX) == entry.cellMinX && toCell(bounds.minY) == entry.cellMinY &&
+            toCell(bounds.maxX) == entry.cellMaxX && toCell(bounds.maxY) == entry.cellMaxY) {
+            return;
+        }
+        unlink(handle);
+        assignCells(entry);
+        link(handle);
+    }
+
+    void remove(uint32_t handle) {
+        if (handle >= entries.size() || !entries[handle].alive) return;
+        unlink(handle);
+        entries[handle].alive = false;
+        freeHandles.push_back(handle);
+        aliveCount--;
+    }
+
+    //! appends every handle overlapping area, each at most once
+    void query(const AABB2D& area, std::vector<uint32_t>& out) {
+        nextStamp();
+        int minX = toCell(area.minX), minY = toCell(area.minY);
+        int maxX = toCell(area.maxX), maxY = toCell(area.maxY);
+        double cellSpan = (double(maxX) - minX + 1) * (double(maxY) - minY + 1);
+
+        // zoomed far out, walking the occupied cells is cheaper than the empty ones
+        if (cellSpan > static_cast<double>(cells.size())) {
+            for (auto& [key, bucket] : cells) {
+                int x = static_cast<int>(static_cast<uint32_t>(key >> 32));
+                int y = static_cast<int>(static_cast<uint32_t>(key));
+                if (x < minX || x > maxX || y < minY || y > maxY) continue;
+                collect(bucket, area, out);
+            }
+            return;
+        }
+
+        for (int y = minY; y <= maxY; y++) {
+            for (int x = minX; x <= maxX; x++) {
+                auto it = cells.find(cellKey(x, y));
+                if (it != cells.end()) collect(it->second, area, out);
+            }
+        }
+    }
+
+    const AABB2D& bounds(uint32_t handle) const { return entries[handle].bounds; }
+    bool contains(uint32_t handle) const { return handle < entries.size() && entries[handle].alive; }
+    size_t size() const { return aliveCount; }
+    size_t cellCount() const { return cells.size(); }
+    float getCellSize() const { return cellSize; }
+
+    void clear() {
+        cells.clear();
+        entries.clear();
+        freeHandles.clear();
+        currentStamp = 0;
+        aliveCount = 0;
+    }
+};
+
+#endif
@@ -0,0 +1,538 @@
+#ifndef T_2DTILEMAP_H
+#define T_2DTILEMAP_H
+#include "batch.h"
+#include "box2d.h"
+#include "max.h"
+#include "t2dshader.h"
+#include "t2dspatial.h"
+#include <workerpool.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+constexpr int T2D_CHUNK_SIZE = 32;
+constexpr int T2D_CHUNK_TILES = T2D_CHUNK_SIZE * T2D_CHUNK_SIZE;
+constexpr uint16_t T2D_TILE_FULL_UV = 0xFFFF;
+
+enum TileFlags : uint8_t {
+    T2D_TILE_EMPTY = 0,
+    T2D_TILE_VISIBLE = 1 << 0,
+    T2D_TILE_SOLID = 1 << 1,
+};
+
+inline uint32_t packTileColor(const max::vec4<float>& color) {
+    auto channel = [](float v) {
+        v = v < 0.0f ? 0.0f : (v > 1.0f ? 1.0f : v);
+        return static_cast<uint32_t>(v * 255.0f + 0.5f);
+    };
+    return channel(color.x) | (channel(color.y) << 8) | (channel(color.z) << 16) | (channel(color.w) << 24);
+}
+
+inline max::vec4<float> unpackTileColor(uint32_t color) {
+    return {
+        (color & 0xFF) / 255.0f,
+        ((color >> 8) & 0xFF) / 255.0f,
+        ((color >> 16) & 0xFF) / 255.0f,
+        ((color >> 24) & 0xFF) / 255.0f
+    };
+}
+
+//! tile data of one chunk as parallel arrays, index = y * T2D_CHUNK_SIZE + x
+struct TileChunkData {
+    std::array<uint8_t, T2D_CHUNK_TILES> flags;
+    std::array<int16_t, T2D_CHUNK_TILES> textureIDs;  // -1 draws the colour only
+    std::array<uint16_t, T2D_CHUNK_TILES> uvCells;    // index into TileMap sheet
+    std::array<uint32_t, T2D_CHUNK_TILES> colors;     // packed RGBA8
+
+    TileChunkData() {
+        flags.fill(T2D_TILE_EMPTY);
+        textureIDs.fill(-1);
+        uvCells.fill(T2D_TILE_FULL_UV);
+        colors.fill(0xFFFFFFFF);
+    }
+
+    static int index(int x, int y) { return y * T2D_CHUNK_SIZE + x; }
+};
+
+//! merged run of solid tiles in chunk local tile units
+struct TileChunkRect {
+    int x, y, width, height;
+};
+
+struct TileChunkRange {
+    size_t firstQuad;
+    size_t quadCount;
+    int textureBase;
+};
+
+struct TileChunkMesh {
+    std::vector<SpriteVertex::Data> vertices;
+    std::vector<TileChunkRange> ranges;
+    std::vector<TileChunkRect> solids;
+};
+
+struct TileMeshInfo {
+    float tileSize = 32.0f;
+    max::vec2<float> origin = {0.0f, 0.0f};
+    int textureSlots = 8;
+    std::shared_ptr<const std::vector<std::array<max::vec2<float>, 4>>> sheet;
+};
+
+inline uint64_t tileChunkKey(int x, int y) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(y);
+}
+
+//! greedy rectangles over the solid tiles, same scan as Map::findLargestRect
+inline std::vector<TileChunkRect> mergeSolidTiles(const TileChunkData& data) {
+    std::vector<TileChunkRect> rects;
+    std::array<bool, T2D_CHUNK_TILES> processed{};
+    auto solid = [&](int x, int y) {
+        int i = TileChunkData::index(x, y);
+        return (data.flags[i] & T2D_TILE_SOLID) && !processed[i];
+    };
+
+    for (int y = 0; y < T2D_CHUNK_SIZE; y++) {
+        for (int x = 0; x < T2D_CHUNK_SIZE; x++) {
+            if (!solid(x, y)) continue;
+
+            int width = 0;
+            while (x + width < T2D_CHUNK_SIZE && solid(x + width, y)) width++;
+
+            int height = 1;
+            bool canExpand = true;
+            while (canExpand && y + height < T2D_CHUNK_SIZE) {
+                for (int i = x; i < x + width; i++) {
+                    if (!solid(i, y + height)) {
+                        canExpand = false;
+                        break;
+                    }
+                }
+                if (canExpand) height++;
+            }
+
+            for (int j = y; j < y + height; j++) {
+                for (int i = x; i < x + width; i++) {
+                    processed[TileChunkData::index(i, j)] = true;
+                }
+            }
+            rects.push_back({x, y, width, height});
+        }
+    }
+    return rects;
+}
+
+//! pure CPU meshing, safe to run on a worker with a copy of the chunk data
+inline TileChunkMesh buildChunkMesh(const TileChunkData& data, int chunkX, int chunkY, const TileMeshInfo& info) {
+    TileChunkMesh mesh;
+    mesh.solids = mergeSolidTiles(data);
+
+    auto windowBase = [&](int textureID) {
+        if (info.textureSlots <= 0 || textureID < 0) return -1;
+        return (textureID / info.textureSlots) * info.textureSlots;
+    };
+
+    // untextured tiles ride along with the lowest window so they cost no extra draw
+    int lowestBase = -1;
+    std::vector<int> order;
+    order.reserve(T2D_CHUNK_TILES);
+    for (int i = 0; i < T2D_CHUNK_TILES; i++) {
+        if (!(data.flags[i] & T2D_TILE_VISIBLE)) continue;
+        order.push_back(i);
+        int base = windowBase(data.textureIDs[i]);
+        if (base >= 0 && (lowestBase < 0 || base < lowestBase)) lowestBase = base;
+    }
+    if (lowestBase < 0) lowestBase = 0;
+    auto baseOf = [&](int i) {
+        int base = windowBase(data.textureIDs[i]);
+        return base < 0 ? lowestBase : base;
+    };
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return baseOf(a) < baseOf(b); });
+
+    const float half = info.tileSize * 0.5f;
+    const max::vec2<float> corners[4] = {{-half, half}, {half, half}, {half, -half}, {-half, -half}};
+    const std::array<max::vec2<float>, 4> fullUV = {
+        max::vec2<float>{0.0f, 0.0f},
+        max::vec2<float>{1.0f, 0.0f},
+        max::vec2<float>{1.0f, 1.0f},
+        max::vec2<float>{0.0f, 1.0f}
+    };
+
+    mesh.vertices.reserve(order.size() * 4);
+    for (int i : order) {
+        int x = i % T2D_CHUNK_SIZE;
+        int y = i / T2D_CHUNK_SIZE;
+        float cx = info.origin.x + (chunkX * T2D_CHUNK_SIZE + x) * info.tileSize + half;
+        float cy = info.origin.y + (chunkY * T2D_CHUNK_SIZE + y) * info.tileSize + half;
+
+        const auto* uv = &fullUV;
+        uint16_t cell = data.uvCells[i];
+        if (cell != T2D_TILE_FULL_UV && info.sheet && cell < info.sheet->size()) {
+            uv = &(*info.sheet)[cell];
+        }
+        max::vec4<float> color = unpackTileColor(data.colors[i]);
+        int textureID = data.textureIDs[i];
+
+        for (int c = 0; c < 4; c++) {
+            mesh.vertices.push_back({cx + corners[c].x, cy + corners[c].y, (*uv)[c].x, (*uv)[c].y,
+                                     color.x, color.y, color.z, color.w, textureID});
+        }
+
+        size_t quad = mesh.vertices.size() / 4 - 1;
+        int base = baseOf(i);
+        if (!mesh.ranges.empty() && mesh.ranges.back().textureBase == base) {
+            mesh.ranges.back().quadCount++;
+        } else {
+            mesh.ranges.push_back({quad, 1, base});
+        }
+    }
+    return mesh;
+}
+
+struct TileChunk {
+    int x, y;
+    TileChunkData tiles;
+    GLuint vao = 0, vbo = 0;
+    size_t quadCount = 0;
+    std::vector<TileChunkRange> ranges;
+    std::vector<b2BodyId> bodies;
+    uint32_t version = 0;
+    uint32_t meshedVersion = UINT32_MAX;
+    bool meshQueued = false;
+    bool modified = false;
+};
+
+//! streams 32x32 tile chunks around the camera, meshing on workers and uploading on the GL thread
+class TileMap {
+public:
+    using Generator = std::function<void(int chunkX, int chunkY, TileChunkData& out)>;
+
+private:
+    struct MeshResult {
+        uint64_t key;
+        uint32_t version;
+        TileChunkMesh mesh;
+    };
+
+    TileMeshInfo info;
+    Generator generator;
+    std::unordered_map<uint64_t, std::unique_ptr<TileChunk>> chunks;
+    std::unordered_map<uint64_t, TileChunkData> parked;
+
+    std::vector<GLuint> textures;
+    std::unique_ptr<IShader> shader;
+    GLuint sharedEbo = 0;
+
+    bool hasPhysics = false;
+    b2WorldId physicsWorld{};
+    float pixelsPerMeter = 64.0f;
+
+    int loadRadius = 1;
+    int unloadMargin = 1;
+    size_t maxLoadsPerFrame = 8;
+    size_t maxUploadsPerFrame = 8;
+    size_t drawCalls = 0;
+
+    std::mutex resultMutex;
+    std::vector<MeshResult> results;
+    std::unique_ptr<WorkerPool> workers;
+
+    float chunkWorldSize() const { return info.tileSize * T2D_CHUNK_SIZE; }
+
+    int worldToChunk(float v, float origin) const {
+        return static_cast<int>(std::floor((v - origin) / chunkWorldSize()));
+    }
+
+    static int floorDiv(int v, int d) {
+        return (v >= 0) ? v / d : -((-v + d - 1) / d);
+    }
+
+    // chunk data for an edit, unloaded chunks are generated and parked until they stream in
+    TileChunkData& editableData(int chunkX, int chunkY) {
+        uint64_t key = tileChunkKey(chunkX, chunkY);
+        auto loaded = chunks.find(key);
+        if (loaded != chunks.end()) {
+            loaded->second->version++;
+            loaded->second->modified = true;
+            return loaded->second->tiles;
+        }
+        auto it = parked.find(key);
+        if (it == parked.end()) {
+            it = parked.emplace(key, TileChunkData{}).first;
+            if (generator) generator(chunkX, chunkY, it->second);
+        }
+        return it->second;
+    }
+
+    void loadChunk(int chunkX, int chunkY) {
+        uint64_t key = tileChunkKey(chunkX, chunkY);
+        auto chunk = std::make_unique<TileChunk>();
+        chunk->x = chunkX;
+        chunk->y = chunkY;
+
+        auto it = parked.find(key);
+        if (it != parked.end()) {
+            chunk->tiles = it->second;
+            chunk->modified = true;
+            parked.erase(it);
+        } else if (generator) {
+            generator(chunkX, chunkY, chunk->tiles);
+        }
+        chunks.emplace(key, std::move(chunk));
+    }
+
+    void unloadChunk(std::unordered_map<uint64_t, std::unique_ptr<TileChunk>>::iterator it) {
+        TileChunk& chunk = *it->second;
+        destroyChunkResources(chunk);
+        if (chunk.modified) {
+            parked[it->first] = chunk.tiles;
+        }
+        chunks.erase(it);
+    }
+
+    void destroyChunkResources(TileChunk& chunk) {
+        if (chunk.vbo) glDeleteBuffers(1, &chunk.vbo);
+        if (chunk.vao) glDeleteVertexArrays(1, &chunk.vao);
+        chunk.vbo = chunk.vao = 0;
+        destroyBodies(chunk);
+    }
+
+    void destroyBodies(TileChunk& chunk) {
+        for (auto body : chunk.bodies) {
+            if (b2Body_IsValid(body)) b2DestroyBody(body);
+        }
+        chunk.bodies.clear();
+    }
+
+    void dispatchMeshing(TileChunk& chunk) {
+        chunk.meshQueued = true;
+        uint64_t key = tileChunkKey(chunk.x, chunk.y);
+        uint32_t version = chunk.version;
+        int chunkX = chunk.x, chunkY = chunk.y;
+        TileMeshInfo meshInfo = info;
+        auto tiles = std::make_shared<TileChunkData>(chunk.tiles);
+
+        workers->submit([this, key, version, chunkX, chunkY, meshInfo, tiles] {
+            MeshResult result{key, version, buildChunkMesh(*tiles, chunkX, chunkY, meshInfo)};
+            std::lock_guard<std::mutex> lock(resultMutex);
+            results.push_back(std::move(result));
+        });
+    }
+
+    void applyMesh(TileChunk& chunk, TileChunkMesh& mesh) {
+        if (!chunk.vao) {
+            glGenVertexArrays(1, &chunk.vao);
+            glGenBuffers(1, &chunk.vbo);
+            glBindVertexArray(chunk.vao);
+            glBindBuffer(GL_ARRAY_BUFFER, chunk.vbo);
+            SpriteVertex dummy(0,0,0,0,0,0,0,0,0);
+            dummy.setupAttributes();
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, sharedEbo);
+            glBindVertexArray(0);
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, chunk.vbo);
+        glBufferData(GL_ARRAY_BUFFER, mesh.vertices.size() * sizeof(SpriteVertex::Data),
+                     mesh.vertices.data(), GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        chunk.quadCount = mesh.vertices.size() / 4;
+        chunk.ranges = std::move(mesh.ranges);
+
+        if (!hasPhysics) return;
+        destroyBodies(chunk);
+        for (const auto& rect : mesh.solids) {
+            max::vec2<float> size = {rect.width * info.tileSize, rect.height * info.tileSize};
+            max::vec2<float> center = {
+                info.origin.x + (chunk.x * T2D_CHUNK_SIZE + rect.x) * info.tileSize + size.x * 0.5f,
+                info.origin.y + (chunk.y * T2D_CHUNK_SIZE + rect.y) * info.tileSize + size.y * 0.5f
+            };
+            chunk.bodies.push_back(max::physics::create_static_box(physicsWorld, size / 2.0f, center, pixelsPerMeter));
+        }
+    }
+
+    void collectResults() {
+        std::vector<MeshResult> ready;
+        {
+            std::lock_guard<std::mutex> lock(resultMutex);
+            size_t count = (std::min)(results.size(), maxUploadsPerFrame);
+            ready.assign(std::make_move_iterator(results.begin()), std::make_move_iterator(results.begin() + count));
+            results.erase(results.begin(), results.begin() + count);
+        }
+        for (auto& result : ready) {
+            auto it = chunks.find(result.key);
+            if (it == chunks.end()) continue;
+            TileChunk& chunk = *it->second;
+            chunk.meshQueued = false;
+            // edited while meshing, the next update queues it again
+            if (result.version != chunk.version) continue;
+            applyMesh(chunk, result.mesh);
+            chunk.meshedVersion = result.version;
+        }
+    }
+
+public:
+    TileMap(float tileSize, max::vec2<float> origin = {0.0f, 0.0f}, size_t workerCount = 0) {
+        info.tileSize = tileSize;
+        info.origin = origin;
+        workers = std::make_unique<WorkerPool>(workerCount);
+    }
+    TileMap(const TileMap&) = delete;
+    TileMap& operator=(const TileMap&) = delete;
+
+    void set_generator(Generator gen) { generator = std::move(gen); }
+    //! cells from parse_sheet, referenced by TileChunkData::uvCells
+    void set_sheet(std::vector<std::array<max::vec2<float>, 4>> cells) {
+        info.sheet = std::make_shared<const std::vector<std::array<max::vec2<float>, 4>>>(std::move(cells));
+    }
+    void set_physics(b2WorldId world, float pixels_per_meter) {
+        physicsWorld = world;
+        pixelsPerMeter = pixels_per_meter;
+        hasPhysics = true;
+    }
+    //! chunks kept around the view, and the extra ring before one is dropped
+    void set_streaming(int radius, int margin, size_t loadsPerFrame = 8, size_t uploadsPerFrame = 8) {
+        loadRadius = radius;
+        unloadMargin = margin;
+        maxLoadsPerFrame = loadsPerFrame;
+        maxUploadsPerFrame = uploadsPerFrame;
+    }
+
+    void init(std::vector<GLuint> textureArray,
+              const std::string& vertexPath = "resources/shaders/sprite.vert",
+              const std::string& fragmentPath = "resources/shaders/sprite.frag") {
+        textures = std::move(textureArray);
+        shader = ShaderFactory::create<SpriteShader>(vertexPath, fragmentPath, &textures);
+        info.textureSlots = shader->getTextureSlotCount();
+
+        auto indices = generateQuadIndices<unsigned short>(T2D_CHUNK_TILES);
+        glGenBuffers(1, &sharedEbo);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, sharedEbo);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned short), indices.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    }
+
+    void set_tile(int tileX, int tileY, uint8_t flags, int textureID = -1,
+                  max::vec4<float> color = {1, 1, 1, 1}, uint16_t uvCell = T2D_TILE_FULL_UV) {
+        int chunkX = floorDiv(tileX, T2D_CHUNK_SIZE);
+        int chunkY = floorDiv(tileY, T2D_CHUNK_SIZE);
+        TileChunkData& data = editableData(chunkX, chunkY);
+        int i = TileChunkData::index(tileX - chunkX * T2D_CHUNK_SIZE, tileY - chunkY * T2D_CHUNK_SIZE);
+        data.flags[i] = flags;
+        data.textureIDs[i] = static_cast<int16_t>(textureID);
+        data.colors[i] = packTileColor(color);
+        data.uvCells[i] = uvCell;
+    }
+
+    uint8_t get_flags(int tileX, int tileY) const {
+        int chunkX = floorDiv(tileX, T2D_CHUNK_SIZE);
+        int chunkY = floorDiv(tileY, T2D_CHUNK_SIZE);
+        int i = TileChunkData::index(tileX - chunkX * T2D_CHUNK_SIZE, tileY - chunkY * T2D_CHUNK_SIZE);
+        uint64_t key = tileChunkKey(chunkX, chunkY);
+
+        auto loaded = chunks.find(key);
+        if (loaded != chunks.end()) return loaded->second->tiles.flags[i];
+        auto it = parked.find(key);
+        if (it != parked.end()) return it->second.flags[i];
+        if (!generator) return T2D_TILE_EMPTY;
+        TileChunkData generated;
+        generator(chunkX, chunkY, generated);
+        return generated.flags[i];
+    }
+
+    //! loads, unloads and remeshes chunks for the current view, call once per frame on the GL thread
+    void update(const Camera2D& cam) {
+        collectResults();
+
+        AABB2D view = cam.getViewBounds();
+        int minX = worldToChunk(view.minX, info.origin.x) - loadRadius;
+        int minY = worldToChunk(view.minY, info.origin.y) - loadRadius;
+        int maxX = worldToChunk(view.maxX, info.origin.x) + loadRadius;
+        int maxY = worldToChunk(view.maxY, info.origin.y) + loadRadius;
+
+        for (auto it = chunks.begin(); it != chunks.end();) {
+            const TileChunk& chunk = *it->second;
+            bool keep = chunk.x >= minX - unloadMargin && chunk.x <= maxX + unloadMargin &&
+                        chunk.y >= minY - unloadMargin && chunk.y <= maxY + unloadMargin;
+            if (keep) {
+                ++it;
+                continue;
+            }
+            auto next = std::next(it);
+            unloadChunk(it);
+            it = next;
+        }
+
+        size_t loads = 0;
+        for (int y = minY; y <= maxY && loads < maxLoadsPerFrame; y++) {
+            for (int x = minX; x <= maxX && loads < maxLoadsPerFrame; x++) {
+                if (chunks.count(tileChunkKey(x, y))) continue;
+                loadChunk(x, y);
+                loads++;
+            }
+        }
+
+        for (auto& [key, chunk] : chunks) {
+            if (!chunk->meshQueued && chunk->meshedVersion != chunk->version) {
+                dispatchMeshing(*chunk);
+            }
+        }
+    }
+
+    void render(const Camera2D& cam) {
+        if (!shader) return;
+        AABB2D view = cam.getViewBounds();
+        float size = chunkWorldSize();
+
+        shader->use();
+        shader->setProjection(glm::value_ptr(cam.getViewProjectionMatrix()));
+        drawCalls = 0;
+
+        for (auto& [key, chunk] : chunks) {
+            if (!chunk->vao || chunk->quadCount == 0) continue;
+            AABB2D bounds = {
+                info.origin.x + chunk->x * size, info.origin.y + chunk->y * size,
+                info.origin.x + (chunk->x + 1) * size, info.origin.y + (chunk->y + 1) * size
+            };
+            if (!bounds.overlaps(view)) continue;
+
+            glBindVertexArray(chunk->vao);
+            for (const auto& range : chunk->ranges) {
+                shader->setTextureBase(range.textureBase);
+                shader->setupUniforms();
+                glDrawElements(GL_TRIANGLES, range.quadCount * 6, GL_UNSIGNED_SHORT,
+                               (void*)(range.firstQuad * 6 * sizeof(unsigned short)));
+                drawCalls++;
+                RenderStats::drawCalls++;
+            }
+        }
+
+        glBindVertexArray(0);
+        glUseProgram(0);
+    }
+
+    size_t loadedChunkCount() const { return chunks.size(); }
+    size_t parkedChunkCount() const { return parked.size(); }
+    size_t getDrawCallCount() const { return drawCalls; }
+    //! meshing jobs still in flight on the workers
+    size_t pendingMeshes() { return workers->pending(); }
+
+    void destroy() {
+        workers->stop();
+        for (auto& [key, chunk] : chunks) {
+            destroyChunkResources(*chunk);
+        }
+        chunks.clear();
+        if (sharedEbo) glDeleteBuffers(1, &sharedEbo);
+        sharedEbo = 0;
+        shader.reset();
+    }
+};
+
+#endif
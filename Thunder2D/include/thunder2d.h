@@ -13,11 +13,15 @@
 #include "gtc/type_ptr.hpp"
 #include "id.h"
 #include "max.h"
+#include "t2datlas.h"
+#include "t2dlayout.h"
 #include "t2dshader.h"
 #include "test_utils.h"
 #include "types.h"
 #include <algorithm>
 #include <array>
+#include <bitset>
+#include <cstdint>
 #include <cstddef>
 #include <functional>
 #include <map>
@@ -28,7 +32,11 @@
 #include <vector>
 #include <texture.h>
 #include <string>
+#include <string_view>
 #include <batch.h>
+#include <t2dspatial.h>
+#include <t2dtilemap.h>
+#include <t2dglyphatlas.h>
 
 #include <ft2build.h>
 #include FT_FREETYPE_H
@@ -396,12 +404,23 @@ struct SceneObject{
     }
 };
 
+//! where the t2datlas build target writes the packed sprites, CMake points it into the build tree
+#ifndef T2D_ATLAS_BASE
+#define T2D_ATLAS_BASE "resources/atlas/sprites"
+#endif
+
+enum class SceneRenderPath{
+    BATCHED,
+    INSTANCED
+};
+
 class Scene{
     public:
     max::vec2<int> screenSize{600,600};
     std::vector<SceneObject> objects;
     int loc = 0;
     float pixels_per_meter = 64.0f;
+    SceneRenderPath renderPath = SceneRenderPath::BATCHED;
 
 
     std::vector<GLuint>* spriteTextures;
@@ -411,10 +430,66 @@ class Scene{
     std::unique_ptr<IShader> spriteBatchShader;
     std::unique_ptr<AbstractBatchRenderer<SpriteVertex::Data>> spriteBatch;
 
+    TileMap* tilemap = nullptr;
+
+    bool culling = false;
+    bool cullBuilt = false;
+    SpatialGrid cullGrid;
+    std::unordered_map<Sprite*, uint32_t> cullHandles;
+    std::vector<std::shared_ptr<Sprite>> cullSprites;
+    std::vector<uint32_t> visibleHandles;
+    std::vector<uint32_t> lastVisibleHandles;
+
+    //! packed sprites by name, page i is sprite texture slot atlasTxBase + i
+    AtlasManifest atlas;
+    int atlasTxBase = -1;
+    std::vector<Texture> atlasPages;
+
 
     void set_pixels_per_meter(float pixels_per_meter){
         this->pixels_per_meter = pixels_per_meter;
     }
+    //! must be called before init
+    void set_render_path(SceneRenderPath path){
+        renderPath = path;
+    }
+    //! must be called after init, the scene streams and draws it under its sprites
+    void attach_tilemap(TileMap* map){
+        tilemap = map;
+        if(tilemap) tilemap->set_physics(physics_world, pixels_per_meter);
+    }
+    //! with culling on the batch only holds the scene objects inside the camera view
+    void set_culling(bool enabled,float cellSize = 256.0f){
+        culling = enabled;
+        cullBuilt = false;
+        cullGrid = SpatialGrid(cellSize);
+        cullHandles.clear();
+        cullSprites.clear();
+        lastVisibleHandles.clear();
+        if(!culling) return;
+        for(auto& obj:objects){
+            index_sprite(obj.sprite);
+        }
+    }
+    //! call after moving a sprite outside of update so the grid stays in sync
+    void moved(const std::shared_ptr<Sprite>& sprite){
+        if(!culling||!sprite) return;
+        auto it = cullHandles.find(sprite.get());
+        if(it == cullHandles.end()){
+            index_sprite(sprite);
+            return;
+        }
+        cullGrid.update(it->second, sprite->getBounds());
+    }
+    void remove_from_culling(const std::shared_ptr<Sprite>& sprite){
+        if(!sprite) return;
+        auto it = cullHandles.find(sprite.get());
+        if(it == cullHandles.end()) return;
+        cullGrid.remove(it->second);
+        cullSprites[it->second].reset();
+        cullHandles.erase(it);
+        cullBuilt = false;
+    }
     
 
     int add_no_physics_object(max::vec2<float> pos,max::vec2<float> size,int txLoc = -1){
@@ -437,12 +512,47 @@ class Scene{
         spriteBatch->addRenderable(sprite); 
         return add_object(sprite,max::physics::create_dynamic_box(physics_world,size/2.0f,pos,pixels_per_meter));
     }
+    //! must be called after init, reads the manifest and appends its page textures to the sprite textures
+    bool load_atlas(const std::string& manifestPath = T2D_ATLAS_BASE ".t2da"){
+        AtlasManifest loaded;
+        if(!loaded.load(manifestPath)) return false;
+        std::vector<Texture> pages(loaded.pages.size());
+        for(size_t i = 0; i < pages.size(); i++){
+            if(!pages[i].loadFromFile(loaded.pagePath(i))) return false;
+        }
+        atlas = std::move(loaded);
+        atlasPages = std::move(pages);
+        atlasTxBase = static_cast<int>(spriteTextures->size());
+        for(const auto& page:atlasPages) spriteTextures->push_back(page.getID());
+        spriteBatch->setTextures(*spriteTextures);
+        return true;
+    }
+    //! points the sprite at a packed image, false when the atlas has no such name
+    bool use_atlas_sprite(Sprite& sprite,const std::string& name){
+        const AtlasSprite* packed = atlasTxBase < 0 ? nullptr : atlas.find(name);
+        if(!packed){
+            std::cerr << "Scene: no atlas sprite named " << name << std::endl;
+            return false;
+        }
+        sprite.txid(atlasTxBase + packed->page);
+        sprite.txCoords = atlas.coords(*packed);
+        sprite.dirt();
+        return true;
+    }
+    int add_atlas_object(const std::string& name,max::vec2<float> pos,max::vec2<float> size){
+        auto sprite = std::make_shared<Sprite>(pos, size, -1);
+        use_atlas_sprite(*sprite, name);
+        spriteBatch->addRenderable(sprite);
+        return add_object(sprite,b2_nullBodyId);
+    }
     int add_object(std::shared_ptr<Sprite> sprite,b2BodyId bodid){
         objects.push_back({sprite,bodid,nullptr});
+        if(culling) index_sprite(sprite);
         return loc++;
     }
     int add_object(SceneObject obj){
         objects.push_back(obj);
+        if(culling) index_sprite(obj.sprite);
         return loc++;
     }
 
@@ -455,17 +565,27 @@ class Scene{
 
         sceneCam = {screenSize.x,screenSize.y};
 
-        spriteBatchShader = ShaderFactory::create<SpriteShader>(
-                    "resources/shaders/sprite.vert", "resources/shaders/sprite.frag", spriteTextures);
+        if(renderPath == SceneRenderPath::INSTANCED){
+            spriteBatchShader = ShaderFactory::create<SpriteShader>(
+                        "resources/shaders/sprite_instanced.vert", "resources/shaders/sprite.frag", spriteTextures);
 
-        spriteBatch = std::make_unique<AbstractBatchRenderer<SpriteVertex::Data>>(
-            0,0, 
-            []() { 
-                SpriteVertex dummy(0,0,0,0,0,0,0,0,0);
-                dummy.setupAttributes(); 
-            },
-            std::move(spriteBatchShader)
-        );
+            spriteBatch = std::make_unique<InstancedSpriteBatchRenderer>(
+                1024,
+                std::move(spriteBatchShader)
+            );
+        }else{
+            spriteBatchShader = ShaderFactory::create<SpriteShader>(
+                        "resources/shaders/sprite.vert", "resources/shaders/sprite.frag", spriteTextures);
+
+            spriteBatch = std::make_unique<QuadBatchRenderer<SpriteVertex::Data>>(
+                0,0, 
+                []() { 
+                    SpriteVertex dummy(0,0,0,0,0,0,0,0,0);
+                    dummy.setupAttributes(); 
+                },
+                std::move(spriteBatchShader)
+            );
+        }
 
         spriteBatch->init();
         spriteBatch->setTextures(*spriteTextures);
@@ -490,11 +610,20 @@ class Scene{
                 std::cout<<"ROT:: "<<obj.sprite->rotation<<std::endl;
                 obj.sprite->dirt();
             }
-           
+            if(culling&&obj.sprite->isDirty()){
+                moved(obj.sprite);
+            }
         }
 
         b2World_Step(physics_world, dt, 4);
 
+        if(tilemap){
+            tilemap->update(sceneCam);
+            tilemap->render(sceneCam);
+        }
+        if(culling){
+            cull();
+        }
         spriteBatch->updateDirtyRenderables();
         spriteBatch->render(glm::value_ptr(sceneCam.getViewProjectionMatrix()));
     }
@@ -563,6 +692,33 @@ class Scene{
                 }
     }
 
+    private:
+    void index_sprite(const std::shared_ptr<Sprite>& sprite){
+        if(!sprite||cullHandles.count(sprite.get())) return;
+        uint32_t handle = cullGrid.insert(sprite->getBounds());
+        if(handle >= cullSprites.size()) cullSprites.resize(handle + 1);
+        cullSprites[handle] = sprite;
+        cullHandles[sprite.get()] = handle;
+    }
+    // rebuilds the batch only when the visible set changed since the last frame
+    void cull(){
+        visibleHandles.clear();
+        cullGrid.query(sceneCam.getViewBounds(), visibleHandles);
+        std::sort(visibleHandles.begin(), visibleHandles.end());
+        if(cullBuilt&&visibleHandles == lastVisibleHandles) return;
+        cullBuilt = true;
+
+        spriteBatch->renderables.clear();
+        spriteBatch->renderables.reserve(visibleHandles.size());
+        for(uint32_t handle:visibleHandles){
+            spriteBatch->renderables.push_back(cullSprites[handle]);
+        }
+        spriteBatch->markMembershipChanged();
+        spriteBatch->reload();
+        std::swap(visibleHandles, lastVisibleHandles);
+    }
+    public:
+
     void destroy(){
         b2DestroyWorld(physics_world);
         delete this->spriteTextures;
@@ -575,6 +731,7 @@ class Scene{
 
 #define OMNIX_UI_FONT 0
 #define OMNIX_UI_BUTTON 1
+#define OMNIX_UI_FONT_SDF 2
 
 namespace t2d::ui{
     struct UIVertex:BaseVertex{
@@ -616,26 +773,78 @@ namespace t2d::ui{
         GLuint advance;     
         max::vec2<float> uvMin;
         max::vec2<float> uvMax;
+        int page = 0;
+    };
+
+    //! filled once by UIFont::init, dynamic fonts grow it as glyphs land in the atlas
+    struct GlyphTable {
+        std::array<Character, 256> entries{};
+        std::bitset<256> loaded;
+        std::unordered_map<uint32_t, Character> extended;
+        //! bumps when a glyph appears or its metrics or page change, cached layouts rebuild on it
+        uint64_t version = 0;
+        //! bumps on every real change, UV moves included, placed glyph vertices rebuild on it
+        uint64_t uvVersion = 0;
+        //! glyph texels are signed distances, drawn through the OMNIX_UI_FONT_SDF path
+        bool sdf = false;
+
+        const Character* find(uint32_t codepoint) const {
+            if (codepoint >= entries.size()) {
+                auto it = extended.find(codepoint);
+                return it == extended.end() ? nullptr : &it->second;
+            }
+            if (!loaded[codepoint]) return nullptr;
+            return &entries[codepoint];
+        }
+        void set(uint32_t codepoint, const Character& ch) {
+            Character* slot;
+            bool fresh;
+            if (codepoint >= entries.size()) {
+                auto [it, inserted] = extended.try_emplace(codepoint, ch);
+                slot = &it->second;
+                fresh = inserted;
+            } else {
+                slot = &entries[codepoint];
+                fresh = !loaded[codepoint];
+                loaded[codepoint] = true;
+            }
+            bool metrics = fresh || slot->size != ch.size || slot->bearing != ch.bearing || slot->advance != ch.advance ||
+                           slot->page != ch.page;
+            bool moved = metrics || slot->uvMin != ch.uvMin || slot->uvMax != ch.uvMax || slot->textureID != ch.textureID;
+            *slot = ch;
+            if (metrics) version++;
+            if (moved) uvVersion++;
+        }
+        void clear() {
+            loaded.reset();
+            extended.clear();
+            version++;
+            uvVersion++;
+        }
     };
 
     class UIGlyph : public IRenderable {
         public:
         max::vec2<float> pos, scale;
         max::vec4<float> color{0,0,0,0};
-        char character;
+        const GlyphTable* glyphs = nullptr;
+        uint32_t character = 0;
+        //! GlyphTable::uvVersion the vertices were built against, dynamic UVs move on eviction
+        uint64_t glyphVersion = 0;
         bool dirty = true;
         int txLoc = 1;
         bool visible = false;
-        std::unordered_map<char, Character> chars;
-        UIGlyph(std::unordered_map<char, Character> chars,char ch, max::vec2<float> position, max::vec2<float> size)
-            : chars(chars),character(ch), pos(position), scale(size) {
+        UIGlyph(const GlyphTable* glyphs,uint32_t ch, max::vec2<float> position, max::vec2<float> size)
+            : pos(position), scale(size), glyphs(glyphs), character(ch) {
 
 
             }
         UIGlyph(){}
 
         std::vector<std::unique_ptr<BaseVertex>> generateVertices() override {
-            const auto& ch = chars[character];
+            static const Character missing{};
+            const Character* found = glyphs ? glyphs->find(character) : nullptr;
+            const auto& ch = found ? *found : missing;
 
             max::vec2<float> half = scale * 0.5f;
             max::vec2<float> corners[4] = {
@@ -650,12 +859,12 @@ namespace t2d::ui{
 
             std::vector<std::unique_ptr<BaseVertex>> vertices;
             
-
+            int type = glyphs && glyphs->sdf ? OMNIX_UI_FONT_SDF : OMNIX_UI_FONT;
             
-            vertices.push_back(std::make_unique<UIVertex>(corners[0].x, corners[0].y, ch.uvMin.x, ch.uvMin.y, color.x,color.y,color.z,color.w, txLoc, OMNIX_UI_FONT));
-            vertices.push_back(std::make_unique<UIVertex>(corners[1].x, corners[1].y, ch.uvMax.x, ch.uvMin.y, color.x,color.y,color.z,color.w, txLoc, OMNIX_UI_FONT));
-            vertices.push_back(std::make_unique<UIVertex>(corners[2].x, corners[2].y, ch.uvMax.x, ch.uvMax.y, color.x,color.y,color.z,color.w, txLoc, OMNIX_UI_FONT));
-            vertices.push_back(std::make_unique<UIVertex>(corners[3].x, corners[3].y, ch.uvMin.x, ch.uvMax.y, color.x,color.y,color.z,color.w, txLoc, OMNIX_UI_FONT));
+            vertices.push_back(std::make_unique<UIVertex>(corners[0].x, corners[0].y, ch.uvMin.x, ch.uvMin.y, color.x,color.y,color.z,color.w, txLoc, type));
+            vertices.push_back(std::make_unique<UIVertex>(corners[1].x, corners[1].y, ch.uvMax.x, ch.uvMin.y, color.x,color.y,color.z,color.w, txLoc, type));
+            vertices.push_back(std::make_unique<UIVertex>(corners[2].x, corners[2].y, ch.uvMax.x, ch.uvMax.y, color.x,color.y,color.z,color.w, txLoc, type));
+            vertices.push_back(std::make_unique<UIVertex>(corners[3].x, corners[3].y, ch.uvMin.x, ch.uvMax.y, color.x,color.y,color.z,color.w, txLoc, type));
             
             return vertices;
         }
@@ -672,7 +881,7 @@ namespace t2d::ui{
         bool isDirty() const override { return dirty; }
         void setClean() override { dirty = false; }
         int getZOrder() const override { return 0; }
-        int getTextureID() const override { return 0; }
+        int getTextureID() const override { return txLoc; }
     };
 
     static int frameDirtCalls = 0;
@@ -703,6 +912,17 @@ namespace t2d::ui{
             frameDirtCalls++;
         }
         void txid(int txid){textureID = txid;}
+        //! copies the widget state in and only dirties the quad when something differs
+        void sync(const max::vec2<float>& position, const max::vec2<float>& size, const max::vec4<float>& newColor,
+                  int texID, const std::array<max::vec2<float>, 4>& coords){
+            if(pos == position && scale == size && max::equalsv4(color, newColor) && textureID == texID && txCoords == coords) return;
+            pos = position;
+            scale = size;
+            color = newColor;
+            textureID = texID;
+            txCoords = coords;
+            dirt();
+        }
         bool isDirty() const override { return dirty; }
         void setClean() override { dirty = false; }
         int getZOrder() const override { return zOrder; }
@@ -759,15 +979,120 @@ namespace t2d::ui{
     };
 
     
+    //! GL pages mirroring a GlyphAtlas, bind them at consecutive texture slots starting at the font's txLoc
+    struct GlyphAtlasTextures {
+        std::shared_ptr<GlyphAtlas> atlas;
+        std::vector<GLuint> pages;
+
+        explicit GlyphAtlasTextures(std::shared_ptr<GlyphAtlas> atlas) : atlas(std::move(atlas)) {
+            int size = this->atlas->getPageSize();
+            pages.resize(this->atlas->getMaxPages(), 0);
+            glGenTextures(static_cast<GLsizei>(pages.size()), pages.data());
+            for (GLuint page : pages) {
+                glBindTexture(GL_TEXTURE_2D, page);
+                glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, size, size, 0, GL_RED, GL_UNSIGNED_BYTE, nullptr);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            }
+        }
+        ~GlyphAtlasTextures() {
+            glDeleteTextures(static_cast<GLsizei>(pages.size()), pages.data());
+        }
+
+        //! sends only the dirty row band of each page
+        void upload() {
+            const auto& cpuPages = atlas->getPages();
+            int size = atlas->getPageSize();
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            for (size_t i = 0; i < cpuPages.size() && i < pages.size(); i++) {
+                const auto& page = cpuPages[i];
+                if (!page.dirty()) continue;
+                glBindTexture(GL_TEXTURE_2D, pages[i]);
+                glTexSubImage2D(GL_TEXTURE_2D, 0, 0, page.dirtyMinY, size, page.dirtyMaxY - page.dirtyMinY + 1,
+                                GL_RED, GL_UNSIGNED_BYTE, &page.pixels[static_cast<size_t>(page.dirtyMinY) * size]);
+                atlas->clearDirty(i);
+            }
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        }
+    };
+
     class UIFont {
         public:
-        std::unordered_map<char, Character> chars;
+        GlyphTable glyphs;
         GLuint fontAtlasTexture = 0;
         static inline FT_Library ft;
         static inline FT_Face face;
 
-        static std::unordered_map<char, Character> init(const std::string& fontPath, int fontSize,GLuint *fontAtlasTexture) {
-            std::unordered_map<char, Character> characters;
+        //! set by initDynamic, glyphs outside the table are rasterized into the shared atlas on demand
+        std::unique_ptr<GlyphCache> glyphCache;
+        std::shared_ptr<GlyphAtlasTextures> atlasTextures;
+        uint64_t atlasGeneration = 0;
+        static inline uint16_t nextFontID = 1;
+
+        bool initDynamic(std::shared_ptr<IGlyphRasterizer> rasterizer, int fontSize,
+                         std::shared_ptr<GlyphAtlasTextures> textures, bool async = true) {
+            atlasTextures = std::move(textures);
+            glyphCache = std::make_unique<GlyphCache>(atlasTextures->atlas, std::move(rasterizer),
+                                                      nextFontID++, static_cast<uint16_t>(fontSize), async);
+            atlasGeneration = atlasTextures->atlas->getGeneration();
+            glyphs.clear();
+            glyphs.sdf = glyphCache->distanceField();
+            return true;
+        }
+        bool initDynamic(const std::string& fontPath, int fontSize,
+                         std::shared_ptr<GlyphAtlasTextures> textures, bool async = true) {
+            auto rasterizer = std::make_shared<FreeTypeGlyphRasterizer>(fontPath, fontSize);
+            if (!rasterizer->valid()) return false;
+            return initDynamic(rasterizer, fontSize, std::move(textures), async);
+        }
+        bool isDynamic() const { return glyphCache != nullptr; }
+
+        //! nullptr while a dynamic glyph is still on its way
+        const Character* resolve(uint32_t codepoint) {
+            if (!glyphCache) return glyphs.find(codepoint);
+            syncAtlasGeneration();
+            if (const Character* ch = glyphs.find(codepoint)) return ch;
+
+            const AtlasGlyph* glyph = glyphCache->get(codepoint);
+            if (!glyph) return nullptr;
+            glyphs.set(codepoint, {
+                atlasTextures->pages[glyph->page],
+                max::vec2<int>(glyph->width, glyph->height),
+                max::vec2<int>(glyph->bearingX, glyph->bearingY),
+                static_cast<GLuint>(glyph->advance),
+                max::vec2<float>(glyph->u0, glyph->v0),
+                max::vec2<float>(glyph->u1, glyph->v1),
+                glyph->page
+            });
+            return glyphs.find(codepoint);
+        }
+        //! true when a missing glyph may still arrive
+        bool glyphPending(uint32_t codepoint) const {
+            return glyphCache && !glyphCache->isMissing(codepoint);
+        }
+        void touchGlyph(uint32_t codepoint) {
+            if (glyphCache) glyphCache->getAtlas().touch(glyphCache->key(codepoint));
+        }
+        //! lands finished glyphs and pushes the touched atlas rows to the GPU
+        void updateGlyphs() {
+            if (!glyphCache) return;
+            glyphCache->getAtlas().nextTick();
+            glyphCache->pump();
+            syncAtlasGeneration();
+            atlasTextures->upload();
+        }
+        //! evictions invalidate every cached UV, the table refills on the next layouts
+        void syncAtlasGeneration() {
+            GlyphAtlas& atlas = glyphCache->getAtlas();
+            if (atlas.getGeneration() == atlasGeneration) return;
+            atlasGeneration = atlas.getGeneration();
+            glyphs.clear();
+        }
+
+        static GlyphTable init(const std::string& fontPath, int fontSize,GLuint *fontAtlasTexture) {
+            GlyphTable characters;
 
             if (FT_Init_FreeType(&ft)) {
                 std::cerr << "FREETYPE: Init failed" << std::endl;
@@ -797,14 +1122,14 @@ namespace t2d::ui{
                     }
                 }
 
-                characters[c] = {
+                characters.set(c, {
                     *fontAtlasTexture,
                     max::vec2<int>(face->glyph->bitmap.width, face->glyph->bitmap.rows),
                     max::vec2<int>(face->glyph->bitmap_left, face->glyph->bitmap_top),
                     static_cast<GLuint>(face->glyph->advance.x),
                     max::vec2<float>((float)x / atlasW, (float)y / atlasH),
                     max::vec2<float>((float)(x + face->glyph->bitmap.width) / atlasW, (float)(y + face->glyph->bitmap.rows) / atlasH)
-                };
+                });
 
                 x += face->glyph->bitmap.width + 1;
                 #define __max(a,b) (((a) > (b)) ? (a) : (b))
@@ -821,6 +1146,47 @@ namespace t2d::ui{
 
             return characters;
         }
+
+        //! ASCII distance field atlas from the outlines at baseSize, draw with scale = wanted size / baseSize
+        static GlyphTable initSDF(const std::string& fontPath, int baseSize, GLuint *fontAtlasTexture, int spread = 4) {
+            GlyphTable characters;
+            FreeTypeSdfRasterizer rasterizer(fontPath, baseSize, spread);
+            if (!rasterizer.valid()) return {};
+
+            const int atlasSize = 1024;
+            GlyphAtlas atlas(atlasSize, 1);
+            glGenTextures(1, fontAtlasTexture);
+            for (uint32_t c = 32; c < 128; ++c) {
+                GlyphBitmap bitmap;
+                if (!rasterizer.rasterize(c, bitmap)) continue;
+                const AtlasGlyph* glyph = atlas.insert(c, bitmap);
+                if (!glyph) {
+                    std::cerr << "UIFont: sdf atlas full at " << c << std::endl;
+                    break;
+                }
+                characters.set(c, {
+                    *fontAtlasTexture,
+                    max::vec2<int>(glyph->width, glyph->height),
+                    max::vec2<int>(glyph->bearingX, glyph->bearingY),
+                    static_cast<GLuint>(glyph->advance),
+                    max::vec2<float>(glyph->u0, glyph->v0),
+                    max::vec2<float>(glyph->u1, glyph->v1)
+                });
+            }
+            characters.sdf = true;
+
+            glBindTexture(GL_TEXTURE_2D, *fontAtlasTexture);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            const auto& pages = atlas.getPages();
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, atlasSize, atlasSize, 0, GL_RED, GL_UNSIGNED_BYTE, pages.empty() ? nullptr : pages[0].pixels.data());
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+            return characters;
+        }
     };
 
 
@@ -828,6 +1194,7 @@ namespace t2d::ui{
 private:
     GLuint ID;
     std::vector<GLint>* textures;
+    int textureBase = 0;
 
 public:
     UIShader(const std::string& vertexPath, const std::string& fragmentPath, std::vector<GLint>* textureArray)
@@ -860,19 +1227,22 @@ public:
     void setupUniforms() override {
         GLint texturesLoc = glGetUniformLocation(ID, "textures");
         if (texturesLoc != -1) {
-            int samplerValues[32] = {0, 1, 2, 3, 4, 5, 6, 7,8,9,10,11,12,13,14,15,16,17,18,19,20,21,22,23,24,25,26,27,28,29,30,31};
-            glUniform1iv(texturesLoc, 32, samplerValues);
+            int samplerValues[16] = {0, 1, 2, 3, 4, 5, 6, 7,8,9,10,11,12,13,14,15};
+            glUniform1iv(texturesLoc, 16, samplerValues);
         }
+        setUniform("textureBase", textureBase);
         
         if (textures) {
-            for (int i = 0; i < __2((int)textures->size(), 32); i++) {
+            for (int i = 0; i < __2((int)textures->size() - textureBase, 16); i++) {
                 glActiveTexture(GL_TEXTURE0 + i);
-                glBindTexture(GL_TEXTURE_2D, (*textures)[i]);
+                glBindTexture(GL_TEXTURE_2D, (*textures)[textureBase + i]);
             }
         }
     }
 
     GLuint getID() const override { return ID; }
+    int getTextureSlotCount() const override { return 16; }
+    void setTextureBase(int base) override { textureBase = base; }
 
 private:
     void init(const std::string& vertexPath, const std::string& fragmentPath) {
@@ -937,23 +1307,56 @@ private:
     };
 
 
+    enum UIDirty : uint8_t {
+        UI_DIRTY_NONE = 0,
+        UI_DIRTY_VISUAL = 1,
+        UI_DIRTY_LAYOUT = 2,
+        UI_DIRTY_ALL = UI_DIRTY_VISUAL | UI_DIRTY_LAYOUT
+    };
+
+    //! a drawText call captured while its element updated, replayed on frames the element is skipped
+    struct UITextCommand {
+        std::string text;
+        max::vec2<float> position, scale;
+        max::vec4<float> color;
+        int fontLoc, fonttxLoc;
+    };
+
     struct UIElement{
         BoltID id = BoltID::randomBoltID(1);
 
         UIManager* manager = nullptr;
         std::vector<UIElement*> childs;
-        UIElement* parent;
+        UIElement* parent = nullptr;
         max::vec2<float> position;
         max::vec2<float> size;
         max::vec4<float> color;
         bool isVisible = true;
         bool canInteract = true;
 
+        //! own pending changes, subtreeDirty is set on every ancestor of a dirty element
+        uint8_t dirtyFlags = UI_DIRTY_ALL;
+        bool subtreeDirty = true;
+        //! the flags the current update pass is handling
+        uint8_t updateFlags = UI_DIRTY_NONE;
+        //! keeps the element updating while input is idle, for widgets that animate on their own.
+        //! updateFnc callbacks only run on frames their root updates, set this when one must run every frame
+        bool alwaysUpdate = false;
+        //! set by UIManager on the element under the mouse and all of its ancestors
+        bool hovered = false;
+        uint32_t hitHandle = UINT32_MAX;
+        //! set by UIManager for roots, false once the subtree settled
+        bool awake = true;
+        std::vector<UITextCommand> recordedText;
+        //! read by FlexLayout, ignore keeps the element out of every layout
+        LayoutStyle layoutStyle;
+
         UIElement(max::vec2<float> position,max::vec2<float> size,max::vec4<float> color = {1,1,1,1}):position(position),size(size),color(color){}
 
         inline void add(UIElement* element){
            element->parent = this;
            childs.push_back(element);
+           mark_dirty(UI_DIRTY_LAYOUT);
         }
         virtual void draw(UIRenderer* renderer) = 0;
         virtual void update(UIRenderer* uirenderer) = 0;
@@ -970,12 +1373,59 @@ private:
         virtual void reload() = 0;
         virtual ~UIElement() = default;
 
+        void mark_dirty(uint8_t flags = UI_DIRTY_VISUAL){
+            dirtyFlags |= flags;
+            subtreeDirty = true;
+            for(UIElement* up = parent; up && !up->subtreeDirty; up = up->parent){
+                up->subtreeDirty = true;
+            }
+        }
+        void set_position(const max::vec2<float>& value){
+            if(position == value) return;
+            position = value;
+            mark_dirty(UI_DIRTY_LAYOUT);
+        }
+        void set_size(const max::vec2<float>& value){
+            if(size == value) return;
+            size = value;
+            mark_dirty(UI_DIRTY_LAYOUT);
+            if(parent) parent->mark_dirty(UI_DIRTY_LAYOUT);
+        }
+        void set_color(const max::vec4<float>& value){
+            if(max::equalsv4(color, value)) return;
+            color = value;
+            mark_dirty(UI_DIRTY_VISUAL);
+        }
+
+        //! true while the element must run every frame regardless of input, e.g. mid drag
+        virtual bool is_active() const { return alwaysUpdate; }
+
+        //! hands the pending flags to this pass, marks made while updating wait for the next one
+        void begin_update(){
+            updateFlags = dirtyFlags;
+            dirtyFlags = UI_DIRTY_NONE;
+            subtreeDirty = false;
+            for(auto child:childs){
+                child->begin_update();
+            }
+        }
+        bool subtree_active() const {
+            if(is_active()) return true;
+            for(auto child:childs){
+                if(child->subtree_active()) return true;
+            }
+            return false;
+        }
+
         float old_A = 1.0f;
         void set_visible(bool visible) {
+            if(isVisible == visible) return;
             isVisible = visible;
+            mark_dirty(UI_DIRTY_VISUAL);
         }
 
         void set_interact(bool interact){
+            if(canInteract != interact) mark_dirty(UI_DIRTY_VISUAL);
             canInteract = interact;
             for(auto child:childs){
                 child->set_interact(interact);
@@ -984,43 +1434,218 @@ private:
     };
 
 
+    using UIBatchRenderer = QuadBatchRenderer<UIVertex::Data>;
+
+    //! glyph quads reused across frames. slots are appended to the batch in geometric steps and,
+    //! while they sit at its tail in order, the unused ones are cut off with the draw limit
     struct GlyphPool {
         std::vector<std::shared_ptr<UIGlyph>> pool;
         size_t cursor = 0;
-    
+        // slots below this were drawn last frame, the fallback hides only the ones left behind
+        size_t lastCursor = 0;
+        // the tail check reruns only when the batch was rebuilt or the pool grew
+        size_t seenRebuild = SIZE_MAX, seenSize = 0;
+        bool isTail = false;
+
         void reset() {
             cursor = 0;
         }
-    
-        std::shared_ptr<UIGlyph> getGlyph(std::unique_ptr<AbstractBatchRenderer<UIVertex::Data>>& renderer) {
-            if (cursor >= pool.size()) {
-                std::cout<<"new"<<std::endl;
+
+        //! makes sure count more glyphs can be taken this frame, with at most one append
+        void reserve(UIBatchRenderer& renderer, size_t count) {
+            if (cursor + count <= pool.size()) return;
+            size_t target = (std::max<size_t>)({cursor + count, pool.size() * 2, 64});
+            std::vector<std::shared_ptr<IRenderable>> added;
+            added.reserve(target - pool.size());
+            while (pool.size() < target) {
                 pool.push_back(std::make_shared<UIGlyph>());
-                renderer->addRenderable(pool[cursor]);
-                renderer->reload();
-                return pool[cursor++];
+                added.push_back(pool.back());
             }
+            renderer.appendRenderables(added);
+        }
+
+        std::shared_ptr<UIGlyph>& getGlyph(UIBatchRenderer& renderer) {
+            reserve(renderer, 1);
             return pool[cursor++];
         }
-    
-        void finalizeFrame() {
-            for (size_t i = cursor; i < pool.size(); ++i) {
-                pool[i]->scale = {0.0f,0.0f};
-                pool[i]->dirty = true;
+
+        void finalizeFrame(UIBatchRenderer& renderer) {
+            if (seenRebuild != renderer.getRebuildCount() || seenSize != pool.size()) {
+                bool wasTail = isTail;
+                seenRebuild = renderer.getRebuildCount();
+                seenSize = pool.size();
+                size_t base = renderer.getQuadCount() - pool.size();
+                isTail = renderer.getQuadCount() >= pool.size();
+                for (size_t i = 0; isTail && i < pool.size(); i++) {
+                    isTail = pool[i]->vertexOffsetInBuffer == (base + i) * 4;
+                }
+                // slots the draw limit used to hide are on screen now
+                if (wasTail && !isTail) lastCursor = pool.size();
+            }
+
+            if (isTail) {
+                renderer.setDrawLimit(renderer.getQuadCount() - pool.size() + cursor);
+            } else {
+                renderer.setDrawLimit(SIZE_MAX);
+                for (size_t i = cursor; i < lastCursor; ++i) {
+                    pool[i]->scale = {0.0f,0.0f};
+                    pool[i]->dirty = true;
+                }
+            }
+            lastCursor = cursor;
+        }
+    };
+    //! glyph quads of one (text, font, scale) relative to the pen position, text is UTF-8
+    struct TextLayout {
+        struct Quad {
+            max::vec2<float> center;
+            max::vec2<float> size;
+            uint32_t codepoint;
+            int page;
+        };
+        std::vector<Quad> quads;
+        max::vec2<float> size{0.0f, 0.0f};
+        bool hasHeight = false;
+        //! false while some glyph is still being rasterized
+        bool complete = true;
+        uint64_t glyphVersion = 0;
+        uint64_t uvVersion = 0;
+
+        static TextLayout build(std::string_view text, UIFont& font, max::vec2<float> scale) {
+            TextLayout layout;
+            layout.quads.reserve(text.size());
+            float cursorX = 0.0f;
+            for (size_t i = 0; i < text.size();) {
+                uint32_t c = utf8Next(text, i);
+                const Character* ch = font.resolve(c);
+                if (!ch) {
+                    if (font.glyphPending(c)) layout.complete = false;
+                    continue;
+                }
+
+                float xpos = cursorX + ch->bearing.x * scale.x;
+                float ypos = -(float)(ch->size.y - ch->bearing.y);
+                float w = ch->size.x * scale.x;
+                float h = ch->size.y * scale.y;
+
+                layout.quads.push_back({{xpos + w / 2.0f, ypos + h / 2.0f}, {w, h}, c, ch->page});
+                layout.size.y = h;
+                layout.hasHeight = true;
+                cursorX += (ch->advance >> 6) * scale.x;
             }
-            pool.back()->scale = {0,0};
+            layout.size.x = cursorX;
+            layout.glyphVersion = font.glyphs.version;
+            layout.uvVersion = font.glyphs.uvVersion;
+            return layout;
+        }
+    };
+
+    struct TextRunKeyView {
+        std::string_view text;
+        const GlyphTable* glyphs;
+        float scaleX, scaleY;
+    };
+    struct TextRunKey {
+        std::string text;
+        const GlyphTable* glyphs;
+        float scaleX, scaleY;
+    };
+    struct TextRunKeyHash {
+        using is_transparent = void;
+        size_t operator()(const TextRunKeyView& k) const {
+            size_t h = std::hash<std::string_view>{}(k.text);
+            h ^= std::hash<const void*>{}(k.glyphs) + 0x9e3779b9 + (h << 6) + (h >> 2);
+            h ^= std::hash<float>{}(k.scaleX) + 0x9e3779b9 + (h << 6) + (h >> 2);
+            h ^= std::hash<float>{}(k.scaleY) + 0x9e3779b9 + (h << 6) + (h >> 2);
+            return h;
+        }
+        size_t operator()(const TextRunKey& k) const {
+            return (*this)(TextRunKeyView{k.text, k.glyphs, k.scaleX, k.scaleY});
+        }
+    };
+    struct TextRunKeyEqual {
+        using is_transparent = void;
+        static TextRunKeyView view(const TextRunKey& k) { return {k.text, k.glyphs, k.scaleX, k.scaleY}; }
+        static const TextRunKeyView& view(const TextRunKeyView& k) { return k; }
+        template<typename A, typename B>
+        bool operator()(const A& a, const B& b) const {
+            TextRunKeyView x = view(a), y = view(b);
+            return x.text == y.text && x.glyphs == y.glyphs && x.scaleX == y.scaleX && x.scaleY == y.scaleY;
         }
     };
+
+    //! cached layout plus where each same-frame occurrence sat in the glyph pool
+    struct TextRun {
+        struct Placement {
+            size_t firstSlot = SIZE_MAX;
+            uint64_t frame = 0;
+            max::vec2<float> pos;
+            max::vec4<float> color;
+            int txLoc = 0;
+        };
+        TextLayout layout;
+        std::vector<Placement> placements;
+        uint64_t frame = 0;
+        uint64_t touchedFrame = 0;
+        size_t used = 0;
+    };
+
     class UIRenderer {
        GlyphPool pool{};
+       std::unordered_map<TextRunKey, TextRun, TextRunKeyHash, TextRunKeyEqual> textRuns;
+       uint64_t frameIndex = 1;
+       std::vector<UITextCommand>* recording = nullptr;
+
+       TextRun& textRun(const std::string& text, UIFont& font, max::vec2<float> scale) {
+            const GlyphTable* glyphs = &font.glyphs;
+            auto it = textRuns.find(TextRunKeyView{text, glyphs, scale.x, scale.y});
+            if (it != textRuns.end()) {
+                TextLayout& layout = it->second.layout;
+                // dynamic glyphs landed or were evicted since the layout was built
+                if (!layout.complete || layout.glyphVersion != font.glyphs.version) {
+                    layout = TextLayout::build(text, font, scale);
+                    for (auto& placement : it->second.placements) placement.firstSlot = SIZE_MAX;
+                } else if (layout.uvVersion != font.glyphs.uvVersion) {
+                    // same metrics, only atlas positions moved, the quads stand and only their vertices refresh
+                    layout.uvVersion = font.glyphs.uvVersion;
+                    for (auto& placement : it->second.placements) placement.firstSlot = SIZE_MAX;
+                }
+                return it->second;
+            }
+            TextRun run;
+            run.layout = TextLayout::build(text, font, scale);
+            return textRuns.emplace(TextRunKey{text, glyphs, scale.x, scale.y}, std::move(run)).first->second;
+       }
+
+       // keeps glyphs of on-screen runs fresh in the atlas LRU without touching them every frame
+       static constexpr uint64_t glyphTouchInterval = 60;
+       void touchRunGlyphs(TextRun& run, UIFont& font) {
+            if (!font.isDynamic() || frameIndex - run.touchedFrame < glyphTouchInterval) return;
+            run.touchedFrame = frameIndex;
+            for (const auto& quad : run.layout.quads) font.touchGlyph(quad.codepoint);
+       }
+
+       // runs unused for this many frames drop their layout
+       static constexpr uint64_t textRunLifetime = 600;
+       void evictTextRuns() {
+            if (frameIndex % 256 != 0) return;
+            for (auto it = textRuns.begin(); it != textRuns.end();) {
+                if (frameIndex - it->second.frame > textRunLifetime) it = textRuns.erase(it);
+                else ++it;
+            }
+       }
        public: 
-        std::unique_ptr<AbstractBatchRenderer<UIVertex::Data>> renderer;
+        std::unique_ptr<UIBatchRenderer> renderer;
         std::unique_ptr<IShader> shader;
         max::vec2<float> screenSize;
         
         
         std::vector<UIFont*> fonts{};
 
+        //! headless, no shader and no GL objects. updates, layout and text placement run but nothing is drawn
+        explicit UIRenderer(max::vec2<float> screenSize)
+            : renderer(std::make_unique<UIBatchRenderer>(10000/4, (10000/4)*3/2, nullptr, nullptr)), screenSize(screenSize) {}
+
         UIRenderer(max::vec2<float> screenSize,std::vector<GLint>& textures)
             : screenSize(screenSize) {
 
@@ -1030,7 +1655,7 @@ private:
                 &textures
             );
 
-            renderer = std::make_unique<AbstractBatchRenderer<UIVertex::Data>>(
+            renderer = std::make_unique<UIBatchRenderer>(
                 10000/4, (10000/4)*3/2,
                 []() {
                     UIVertex dummy(0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
@@ -1048,60 +1673,79 @@ private:
             renderer->reload();
         }
         void begin() {
+            for (auto font : fonts) font->updateGlyphs();
             pool.reset();
+            frameIndex++;
+            evictTextRuns();
         }
+        size_t cachedTextRuns() const { return textRuns.size(); }
 
-         void drawText(const std::string& text, max::vec2<float> position, max::vec2<float> scale,max::vec4<float> color={1,1,1,1}, int fontLoc = 0, int fonttxLoc = 0,max::vec2<float>* totalTextSize = nullptr) {
-            float cursorX = position.x;
-            for (int i = 0; i < text.size(); i++) {
-                auto it = fonts[fontLoc]->chars.find(text[i]);
-                if (it == fonts[fontLoc]->chars.end()) continue; 
-        
-                const Character& ch = it->second;
-        
-                float xpos = cursorX + ch.bearing.x * scale.x;
-                float ypos = position.y - (ch.size.y - ch.bearing.y);
-        
-                float w = ch.size.x * scale.x;
-                float h = ch.size.y * scale.y;
+        //! drawText calls are also appended to into until record(nullptr)
+        void record(std::vector<UITextCommand>* into){
+            recording = into;
+        }
+        void replay(const std::vector<UITextCommand>& commands){
+            for(const auto& cmd:commands){
+                drawText(cmd.text, cmd.position, cmd.scale, cmd.color, cmd.fontLoc, cmd.fonttxLoc);
+            }
+        }
 
-               
+         void drawText(const std::string& text, max::vec2<float> position, max::vec2<float> scale,max::vec4<float> color={1,1,1,1}, int fontLoc = 0, int fonttxLoc = 0,max::vec2<float>* totalTextSize = nullptr) {
+            if (recording) recording->push_back({text, position, scale, color, fontLoc, fonttxLoc});
+            UIFont& font = *fonts[fontLoc];
+            const GlyphTable* glyphs = &font.glyphs;
+            TextRun& run = textRun(text, font, scale);
+            touchRunGlyphs(run, font);
+            if (run.frame != frameIndex) {
+                run.frame = frameIndex;
+                run.used = 0;
+            }
+            if (run.used == run.placements.size()) run.placements.emplace_back();
+            TextRun::Placement& placement = run.placements[run.used++];
 
-                if(totalTextSize)
-                 totalTextSize->y = h;
+            const TextLayout& layout = run.layout;
+            if (totalTextSize) {
+                totalTextSize->x = layout.size.x;
+                if (layout.hasHeight) totalTextSize->y = layout.size.y;
+            }
 
-        
+            // drawn into the same slots last frame with the same pen and colour, nothing to touch
+            size_t first = pool.cursor;
+            if (placement.firstSlot == first && placement.frame + 1 == frameIndex &&
+                placement.pos == position && max::equalsv4(placement.color, color) && placement.txLoc == fonttxLoc &&
+                first + layout.quads.size() <= pool.pool.size()) {
+                pool.cursor += layout.quads.size();
+                placement.frame = frameIndex;
+                return;
+            }
 
-                auto glyph = pool.getGlyph(renderer);
+            pool.reserve(*renderer, layout.quads.size());
+            for (const auto& quad : layout.quads) {
+                max::vec2<float> center = position + quad.center;
+                int txLoc = fonttxLoc + quad.page;
+                auto& glyph = pool.getGlyph(*renderer);
                 if(
-                glyph->pos == max::vec2<float>{xpos + w / 2.0f, ypos + h / 2.0f}
-                &&glyph->scale == max::vec2<float>{w, h}
-                &&glyph->character == text[i]
+                glyph->pos == center
+                &&glyph->scale == quad.size
+                &&glyph->character == quad.codepoint
+                &&glyph->glyphs == glyphs
+                &&glyph->glyphVersion == layout.uvVersion
                 &&max::equalsv4(glyph->color, color)
-                &&glyph->txLoc == fonttxLoc
+                &&glyph->txLoc == txLoc
                 ){
-                    cursorX += (ch.advance >> 6) * scale.x;
                     continue;
-                }else{
-                    glyph->chars = fonts[fontLoc]->chars;
-                    glyph->pos = max::vec2<float>{xpos + w / 2.0f, ypos + h / 2.0f};
-                    glyph->scale = max::vec2<float>{w, h};
-                    glyph->character = text[i];
-                   
-                    glyph->color = color;
-                    glyph->txLoc = fonttxLoc;
-    
-                    glyph->dirty = true;
                 }
-                
+                glyph->glyphs = glyphs;
+                glyph->glyphVersion = layout.uvVersion;
+                glyph->pos = center;
+                glyph->scale = quad.size;
+                glyph->character = quad.codepoint;
+                glyph->color = color;
+                glyph->txLoc = txLoc;
+                glyph->dirty = true;
                 glyph->visible = true;
-        
-                cursorX += (ch.advance >> 6) * scale.x;
-
             }
-             if(totalTextSize){
-                 totalTextSize->x = cursorX-position.x;
-             }
+            placement = {first, frameIndex, position, color, fonttxLoc};
         }
         
         void drawElement(std::shared_ptr<UIElement> element){
@@ -1117,6 +1761,7 @@ private:
         
         int onetimereload = 1;
         void end(Camera2D *viewPortCam) {
+            pool.finalizeFrame(*renderer);
             renderer->updateDirtyRenderables();
 
             float projection[16] = {
@@ -1127,8 +1772,6 @@ private:
             };
 
             renderer->render(projection);
-
-            pool.finalizeFrame();
         }
 
         void dispose(){
@@ -1168,9 +1811,118 @@ private:
             }
         }
 
+        struct InputSnapshot {
+            int x = INT32_MIN, y = INT32_MIN;  // y is inverted, same space as the widget rects
+            bool press = false;
+            bool justPress = false;
+        };
+        //! read once per frame, widgets use this instead of asking the mouse module
+        InputSnapshot input;
+        size_t updatedLastFrame = 0;
+
+        //! rects of every tracked interactable, resolves the hovered one per input change
+        SpatialGrid hitGrid{64.0f};
+        std::vector<UIElement*> hitOwners;
+        std::vector<uint32_t> hitScratch;
+        UIElement* hoveredElement = nullptr;
+
+        static AABB2D hit_bounds(const UIElement* element){
+            max::vec2<float> half = element->size * 0.5f;
+            return {element->position.x - half.x, element->position.y - half.y,
+                    element->position.x + half.x, element->position.y + half.y};
+        }
+        static int depth(const UIElement* element){
+            int d = 0;
+            for(auto up = element->parent; up; up = up->parent) d++;
+            return d;
+        }
+
+        void track(UIElement* element){
+            if(element->hitHandle != UINT32_MAX) return;
+            element->hitHandle = hitGrid.insert(hit_bounds(element));
+            if(hitOwners.size() <= element->hitHandle) hitOwners.resize(element->hitHandle + 1, nullptr);
+            hitOwners[element->hitHandle] = element;
+        }
+        void untrack(UIElement* element){
+            if(element->hitHandle == UINT32_MAX) return;
+            if(hoveredElement == element) set_hovered(nullptr);
+            hitGrid.remove(element->hitHandle);
+            hitOwners[element->hitHandle] = nullptr;
+            element->hitHandle = UINT32_MAX;
+        }
+        //! grid update only re-buckets elements whose rect crossed a cell
+        void refresh_hit_index(){
+            for(auto element:hitOwners){
+                if(element) hitGrid.update(element->hitHandle, hit_bounds(element));
+            }
+        }
+
+        //! deepest visible interactable under the point, later registrations win ties
+        UIElement* pick(int x, int y){
+            hitScratch.clear();
+            AABB2D point{(float)x, (float)y, (float)x, (float)y};
+            hitGrid.query(point, hitScratch);
+            UIElement* best = nullptr;
+            int bestDepth = -1;
+            uint32_t bestHandle = 0;
+            for(uint32_t handle:hitScratch){
+                UIElement* element = hitOwners[handle];
+                if(!element || !element->isVisible || !element->canInteract) continue;
+                int d = depth(element);
+                if(d > bestDepth || (d == bestDepth && handle > bestHandle)){
+                    best = element;
+                    bestDepth = d;
+                    bestHandle = handle;
+                }
+            }
+            return best;
+        }
+
+        //! flips hovered on the old and new element and their ancestors, only those get dirtied
+        void set_hovered(UIElement* element){
+            if(element == hoveredElement) return;
+            for(auto up = hoveredElement; up; up = up->parent){
+                up->hovered = false;
+                up->mark_dirty(UI_DIRTY_VISUAL);
+            }
+            hoveredElement = element;
+            for(auto up = hoveredElement; up; up = up->parent){
+                up->hovered = true;
+                up->mark_dirty(UI_DIRTY_VISUAL);
+            }
+        }
+
+        //! roots that are clean and settled only replay their text
         void update(UIRenderer* uirenderer){
+            InputSnapshot next;
+            next.x = Omnix::Helpers::np_get_data<int,IDataProvider::__variants>("OmnixMouseModule", {OMNIX_MOUSE_POS_X});
+            next.y = Omnix::Helpers::np_get_data<int,IDataProvider::__variants>("OmnixMouseModule", {OMNIX_MOUSE_POS_Y,OMNIX_INVERTED});
+            next.press = Omnix::Helpers::np_get_data<bool,IDataProvider::__variants>("OmnixMouseModule", {OMNIX_PRESS,OMNIX_MOUSE_LEFT_BUTTON});
+            next.justPress = next.press && !input.press;
+            bool moved = next.x != input.x || next.y != input.y;
+            bool pressChanged = next.press != input.press;
+            input = next;
+
+            if(moved) set_hovered(pick(input.x, input.y));
+            if(pressChanged && hoveredElement) hoveredElement->mark_dirty(UI_DIRTY_VISUAL);
+
+            updatedLastFrame = 0;
             for(auto element:elements){
+                if(!element->subtreeDirty && !element->awake){
+                    uirenderer->replay(element->recordedText);
+                    continue;
+                }
+                element->recordedText.clear();
+                element->begin_update();
+                uirenderer->record(&element->recordedText);
                 element->update(uirenderer);
+                uirenderer->record(nullptr);
+                element->awake = element->subtree_active();
+                updatedLastFrame++;
+            }
+            if(updatedLastFrame){
+                refresh_hit_index();
+                set_hovered(pick(input.x, input.y));
             }
         }
 
@@ -1219,6 +1971,10 @@ private:
             __cl_holder = color;
             __tx_holder = this->txLoc;
             __txc_holder = this->txCoords;
+            if(manager) manager->track(this);
+        }
+        ~DefaultButton(){
+            if(manager) manager->untrack(this);
         }
         void draw(t2d::ui::UIRenderer* uirenderer) override{
             if(!isVisible) return;
@@ -1227,13 +1983,11 @@ private:
         };
         void update(UIRenderer* uirenderer) override{
             if(canInteract){
-              int mousex = Omnix::Helpers::np_get_data<int,IDataProvider::__variants>("OmnixMouseModule", {OMNIX_MOUSE_POS_X});
-              int mousey = Omnix::Helpers::np_get_data<int,IDataProvider::__variants>("OmnixMouseModule", {OMNIX_MOUSE_POS_Y,OMNIX_INVERTED});
-              
-              bool check = max::math::inside_region(mousex,mousey, position.x-(size/2).x, position.y+(size/2).y, position.x+(size/2).x, position.y-(size/2).y);
+              // resolved once per frame by UIManager
+              bool check = hovered;
               if(check){
-                  bool isClicked = Omnix::Helpers::np_get_data<bool,IDataProvider::__variants>("OmnixMouseModule", {OMNIX_JUST_PRESS,OMNIX_MOUSE_LEFT_BUTTON});
-                  bool holding = Omnix::Helpers::np_get_data<bool,IDataProvider::__variants>("OmnixMouseModule", {OMNIX_PRESS,OMNIX_MOUSE_LEFT_BUTTON});
+                  bool isClicked = manager->input.justPress;
+                  bool holding = manager->input.press;
                   if(isClicked){
                       color = clickColor;
                       this->txLoc = clickTxID;
@@ -1265,8 +2019,8 @@ private:
                       this->txCoords = hoverTXCoords;
                       auto __id = get_id();
                       auto __ouie = Omnix::Defaults::OmnixUIEvent{OMNIX_UI_ELEMENT,OMNIX_UI_ELEMENT_BUTTON,OMNIX_UI_ELEMENT_RELEASE,__id};
-                      manager->publish_event(&__ouie);
                       if(last!=1){
+                          manager->publish_event(&__ouie);
                           renderable->dirt();
                       }
                       last = 1;
@@ -1277,8 +2031,8 @@ private:
                   this->txCoords = __txc_holder;
                   auto __id = get_id();
                   auto __ouie = Omnix::Defaults::OmnixUIEvent{OMNIX_UI_ELEMENT,OMNIX_UI_ELEMENT_BUTTON,OMNIX_UI_ELEMENT_RELEASE,__id};
-                  manager->publish_event(&__ouie);
                   if(last!=0){
+                      manager->publish_event(&__ouie);
                       renderable->dirt();
                   }
                   last = 0;
@@ -1293,11 +2047,7 @@ private:
             } else {
                 color.w = 0.0f;
             }
-            renderable->pos = position;
-            renderable->scale = size;
-            renderable->txCoords = txCoords;
-            renderable->txid(txLoc);
-            renderable->color = color;
+            renderable->sync(position, size, color, txLoc, txCoords);
 
 
             if(updateFnc){
@@ -1307,8 +2057,9 @@ private:
         }
         float old_A = 0;
         void set_visible(const bool& _1){
-            isVisible = _1;
+            UIElement::set_visible(_1);
         }
+        bool is_active() const override { return alwaysUpdate || last == 2; }
         void reload(){
             renderable->pos = position;
             renderable->color = color;
@@ -1347,7 +2098,7 @@ private:
     };
 
     struct UIFrame:public UIElement{
-        UILayout* layout;
+        UILayout* layout = nullptr;
         std::function<void(UIFrame* self)> updateFnc;
         std::shared_ptr<E_UIQuadBase> renderable;
         int txLoc = -1;
@@ -1361,7 +2112,7 @@ private:
             }
         }
         void __fullReload(){
-            layout->apply(childs, position, size);
+            if(layout) layout->apply(childs, position, size);
             for(auto child:childs){
                 child->reload();
             }
@@ -1373,26 +2124,29 @@ private:
                 child->set_visible(visible);
             }
         }
+        //! the layout is re-applied on the next update, after the caller wrote through the reference
         max::vec2<float>& resize(){
-            __fullReload();
+            mark_dirty(UI_DIRTY_LAYOUT);
             return size;
         }
         max::vec2<float>& repos(){
-            __fullReload();
+            mark_dirty(UI_DIRTY_LAYOUT);
             return position;
         }
         void update(UIRenderer* uirenderer) override{
             if(updateFnc)
              updateFnc(this);
 
+            if((updateFlags & UI_DIRTY_LAYOUT) && layout){
+                layout->apply(childs, position, size);
+            }
+
             if (isVisible) {
                 color.w = 1.0f;
             } else {
                 color.w = 0.0f;
             }
-            renderable->pos = position;
-            renderable->scale = size;
-            renderable->color = color;
+            renderable->sync(position, size, color, txLoc, renderable->txCoords);
             for(auto child:childs){
                 child->update(uirenderer);
             }
@@ -1409,7 +2163,9 @@ private:
     };
     class UIFlip:public DefaultButton{
        public:
-       UIFlip(max::vec2<float> scale,max::vec4<float> color):DefaultButton({}, scale, color){}
+       UIFlip(max::vec2<float> scale,max::vec4<float> color):DefaultButton({}, scale, color){
+           layoutStyle.ignore = true;
+       }
        bool flip = false;
        void init(){
            position = parent->position+max::vec2<float>{0,parent->size.y/2};
@@ -1451,10 +2207,7 @@ private:
             if (children.empty()) return;
             int realsize = 0;
             for(auto child:children){
-                if(dynamic_cast<UIFlip*>(child)){
-                    continue;
-                }
-                realsize++;
+                if(!child->layoutStyle.ignore) realsize++;
             }
 
             float ysize = frameSize.y/(realsize+1);
@@ -1462,7 +2215,7 @@ private:
 
             int count = 1;
             for(auto child:children){
-                if(dynamic_cast<UIFlip*>(child)){
+                if(child->layoutStyle.ignore){
                     continue;
                 }
                 child->position = startPos-max::vec2<float>{0,(ysize*count)};
@@ -1471,6 +2224,62 @@ private:
         }
     };
 
+    //! flexbox layout over LayoutTree, children are styled through UIElement::layoutStyle
+    //! measurements are cached, a frame whose children, styles and size did not change costs a few compares
+    struct FlexLayout : public UILayout {
+        LayoutStyle container;
+        LayoutTree tree;
+        struct Item {
+            UIElement* element;
+            //! the size the element had before the layout stretched or grew it
+            max::vec2<float> natural, written;
+        };
+        std::vector<Item> items;
+        max::vec2<float> lastPos;
+
+        FlexLayout(const LayoutStyle& container = {}) : container(container) {}
+
+        void apply(std::vector<UIElement*>& children, const max::vec2<float>& framePos, const max::vec2<float>& frameSize) override {
+            bool rebuild = items.size() != children.size();
+            for(size_t i = 0; !rebuild && i < children.size(); i++){
+                rebuild = items[i].element != children[i];
+            }
+            if(rebuild){
+                tree.clear();
+                items.clear();
+                for(auto child:children){
+                    tree.add(0, child->layoutStyle, child->size.x, child->size.y);
+                    items.push_back({child, child->size, child->size});
+                }
+            }
+
+            tree.setStyle(0, container);
+            for(size_t i = 0; i < items.size(); i++){
+                Item& item = items[i];
+                if(item.element->size != item.written) item.natural = item.element->size;
+                tree.setStyle(static_cast<int>(i) + 1, item.element->layoutStyle);
+                tree.setIntrinsic(static_cast<int>(i) + 1, item.natural.x, item.natural.y);
+            }
+            if(!tree.layout(frameSize.x, frameSize.y) && framePos == lastPos) return;
+            lastPos = framePos;
+
+            max::vec2<float> topLeft = framePos + max::vec2<float>{-frameSize.x/2, frameSize.y/2};
+            for(size_t i = 0; i < items.size(); i++){
+                UIElement* child = items[i].element;
+                if(child->layoutStyle.ignore) continue;
+                const LayoutRect& rect = tree.rect(static_cast<int>(i) + 1);
+                max::vec2<float> size{rect.width, rect.height};
+                max::vec2<float> pos = topLeft + max::vec2<float>{rect.x + rect.width/2, -(rect.y + rect.height/2)};
+                items[i].written = size;
+                if(child->size == size && child->position == pos) continue;
+                // written directly, set_size would send the frame back through the layout next frame
+                child->size = size;
+                child->position = pos;
+                child->mark_dirty(UI_DIRTY_LAYOUT);
+            }
+        }
+    };
+
     
 
     struct UIAdjusterButton:public DefaultButton{
@@ -1499,14 +2308,11 @@ private:
             if(!canInteract) return;
 
 
-            int mousex = Omnix::Helpers::np_get_data<int,IDataProvider::__variants>("OmnixMouseModule", {OMNIX_MOUSE_POS_X});
-            int mousey = Omnix::Helpers::np_get_data<int,IDataProvider::__variants>("OmnixMouseModule", {OMNIX_MOUSE_POS_Y,OMNIX_INVERTED});
-    
-            
-            bool check = max::math::inside_region(mousex,mousey, position.x-(size/2).x, position.y+(size/2).y, position.x+(size/2).x, position.y-(size/2).y);
+            // resolved once per frame by UIManager
+            bool check = hovered;
             if(check){
-                bool isClicked = Omnix::Helpers::np_get_data<bool,IDataProvider::__variants>("OmnixMouseModule", {OMNIX_JUST_PRESS,OMNIX_MOUSE_LEFT_BUTTON});
-                bool holding = Omnix::Helpers::np_get_data<bool,IDataProvider::__variants>("OmnixMouseModule", {OMNIX_PRESS,OMNIX_MOUSE_LEFT_BUTTON});
+                bool isClicked = manager->input.justPress;
+                bool holding = manager->input.press;
                 if(isClicked){
                     color = clickColor;
                     this->txLoc = clickTxID;
@@ -1538,8 +2344,8 @@ private:
                     this->txCoords = hoverTXCoords;
                     auto __id = get_id();
                     auto __ouie = Omnix::Defaults::OmnixUIEvent{OMNIX_UI_ELEMENT,OMNIX_UI_ELEMENT_ADJUSTERBUTTON,OMNIX_UI_ELEMENT_RELEASE,__id};
-                    manager->publish_event(&__ouie);
                     if(last!=1){
+                        manager->publish_event(&__ouie);
                         renderable->dirt();
                     }
                     last = 1;
@@ -1550,19 +2356,15 @@ private:
                 this->txCoords = __txc_holder;
                 auto __id = get_id();
                 auto __ouie = Omnix::Defaults::OmnixUIEvent{OMNIX_UI_ELEMENT,OMNIX_UI_ELEMENT_ADJUSTERBUTTON,OMNIX_UI_ELEMENT_RELEASE,__id};
-                manager->publish_event(&__ouie);
                 if(last!=0){
+                    manager->publish_event(&__ouie);
                     renderable->dirt();
                 }
                 last = 0;
             }
 
 
-            renderable->pos = position;
-            renderable->scale = size;
-            renderable->txCoords = txCoords;
-            renderable->txid(txLoc);
-            renderable->color = color;
+            renderable->sync(position, size, color, txLoc, txCoords);
 
 
             if(updateFnc){
@@ -1577,6 +2379,7 @@ private:
             renderable->color = color;
             renderable->dirt();
         }
+        bool is_active() const override { return DefaultButton::is_active() || dragging; }
     };
 
 
@@ -1676,7 +2479,6 @@ private:
                             }
                         }
                         uirenderer->drawText(self->buttonText, self->buttonTextPos, self->buttonTextScaleModifier);
-                        self->renderable->dirt();
                     }
        
     ){
@@ -1734,11 +2536,10 @@ private:
         }
 
         void update(UIRenderer* uirenderer) override{
-            renderable->pos = position;
-            renderable->scale = size;
             if(updateFnc){
                 updateFnc(this);
             }
+            renderable->sync(position, size, color, txLoc, txCoords);
         }
 
         void reload(){
@@ -1842,6 +2643,8 @@ private:
                     manager
                     );
             }
+            // not a child, but hovering it should still reach the slider and its frame
+            thumb->parent = this;
         };
 
         void draw(t2d::ui::UIRenderer *uirenderer) override{
@@ -1853,14 +2656,11 @@ private:
         void update(UIRenderer *uirenderer) override {
             if(canInteract){
 
-            int mousex = Omnix::Helpers::np_get_data<int,IDataProvider::__variants>("OmnixMouseModule", {OMNIX_MOUSE_POS_X});
-            int mousey = Omnix::Helpers::np_get_data<int,IDataProvider::__variants>("OmnixMouseModule", {OMNIX_MOUSE_POS_Y,OMNIX_INVERTED});
-    
-            
-            bool check = max::math::inside_region(mousex,mousey, position.x-(size/2).x, position.y+(size/2).y, position.x+(size/2).x, position.y-(size/2).y);
+            // resolved once per frame by UIManager
+            bool check = hovered;
             if(check){
-                bool isClicked = Omnix::Helpers::np_get_data<bool,IDataProvider::__variants>("OmnixMouseModule", {OMNIX_JUST_PRESS,OMNIX_MOUSE_LEFT_BUTTON});
-                bool holding = Omnix::Helpers::np_get_data<bool,IDataProvider::__variants>("OmnixMouseModule", {OMNIX_PRESS,OMNIX_MOUSE_LEFT_BUTTON});
+                bool isClicked = manager->input.justPress;
+                bool holding = manager->input.press;
                 if(isClicked){
                     auto __id = get_id();
                     auto __ouie = Omnix::Defaults::OmnixUIEvent{OMNIX_UI_ELEMENT,OMNIX_UI_ELEMENT_SLIDER,OMNIX_UI_ELEMENT_CLICK,__id};
@@ -1890,8 +2690,8 @@ private:
                 this->txCoords = __txc_holder;
                 auto __id = get_id();
                 auto __ouie = Omnix::Defaults::OmnixUIEvent{OMNIX_UI_ELEMENT,OMNIX_UI_ELEMENT_SLIDER,OMNIX_UI_ELEMENT_RELEASE,__id};
-                manager->publish_event(&__ouie);
                 if(last!=0){
+                    manager->publish_event(&__ouie);
                     renderable->dirt();
                 }
                 last = 0;
@@ -1911,7 +2711,6 @@ private:
             int range = maxVal - minVal;
             
             float pixelsPerStep = static_cast<float>(pixelRange) / (range / step);
-            std::cout<<pixelsPerStep<<std::endl;
             
             if (dragging) {
                 bool isMouseHeld = Omnix::Helpers::np_get_data<bool, IDataProvider::__variants>(
@@ -1975,15 +2774,12 @@ private:
                 color.w = 0.0f;
             }
 
-            renderable->pos = position;
-            renderable->scale = size;
-            renderable->txCoords = txCoords;
-            renderable->txid(txLoc);
-            renderable->color = color;
+            renderable->sync(position, size, color, txLoc, txCoords);
 
-            thumb->reload();
+            thumb->renderable->sync(thumb->position, thumb->size, thumb->color, thumb->txLoc, thumb->txCoords);
 
         }
+        bool is_active() const override { return DefaultButton::is_active() || dragging; }
     };
 
     template <typename datatype = float>
@@ -2091,14 +2887,11 @@ private:
              if(!canInteract) return;
 
 
-            int mousex = Omnix::Helpers::np_get_data<int,IDataProvider::__variants>("OmnixMouseModule", {OMNIX_MOUSE_POS_X});
-            int mousey = Omnix::Helpers::np_get_data<int,IDataProvider::__variants>("OmnixMouseModule", {OMNIX_MOUSE_POS_Y,OMNIX_INVERTED});
-    
-            
-            bool check = max::math::inside_region(mousex,mousey, position.x-(size/2).x, position.y+(size/2).y, position.x+(size/2).x, position.y-(size/2).y);
+            // resolved once per frame by UIManager
+            bool check = hovered;
             if(check){
-                bool isClicked = Omnix::Helpers::np_get_data<bool,IDataProvider::__variants>("OmnixMouseModule", {OMNIX_JUST_PRESS,OMNIX_MOUSE_LEFT_BUTTON});
-                bool holding = Omnix::Helpers::np_get_data<bool,IDataProvider::__variants>("OmnixMouseModule", {OMNIX_PRESS,OMNIX_MOUSE_LEFT_BUTTON});
+                bool isClicked = manager->input.justPress;
+                bool holding = manager->input.press;
                 if(isClicked){
                     color = clickColor;
                     auto __id = get_id();
@@ -2124,8 +2917,8 @@ private:
                     color = hoverColor;
                     auto __id = get_id();
                     auto __ouie = Omnix::Defaults::OmnixUIEvent{OMNIX_UI_ELEMENT,OMNIX_UI_ELEMENT_CHECKBOX,OMNIX_UI_ELEMENT_RELEASE,__id};
-                    manager->publish_event(&__ouie);
                     if(last!=1){
+                        manager->publish_event(&__ouie);
                         renderable->dirt();
                     }
                     last = 1;
@@ -2134,8 +2927,8 @@ private:
                 color = __cl_holder;
                 auto __id = get_id();
                 auto __ouie = Omnix::Defaults::OmnixUIEvent{OMNIX_UI_ELEMENT,OMNIX_UI_ELEMENT_CHECKBOX,OMNIX_UI_ELEMENT_RELEASE,__id};
-                manager->publish_event(&__ouie);
                 if(last!=0){
+                    manager->publish_event(&__ouie);
                     renderable->dirt();
                 }
                 last = 0;
@@ -2169,11 +2962,7 @@ private:
 
             lastCheck = isChecked;
 
-            renderable->pos = position;
-            renderable->scale = size;
-            renderable->txCoords = txCoords;
-            renderable->txid(txLoc);
-            renderable->color = color;
+            renderable->sync(position, size, color, txLoc, txCoords);
         }
     };
 
@@ -2185,33 +2974,25 @@ private:
 
         
         void update(UIRenderer* uirenderer){
-            if(Omnix::Helpers::np_get_data<bool,IDataProvider::__variants>("OmnixMouseModule", {OMNIX_PRESS,OMNIX_MOUSE_LEFT_BUTTON})){
-                dragging = true;
-            }
+            dragging = Omnix::Helpers::np_get_data<bool,IDataProvider::__variants>("OmnixMouseModule", {OMNIX_PRESS,OMNIX_MOUSE_LEFT_BUTTON});
+            if(!dragging) return;
 
             int mx = Omnix::Helpers::np_get_data<int,IDataProvider::__variants>("OmnixMouseModule", {OMNIX_MOUSE_POS_X});
             int my = Omnix::Helpers::np_get_data<int,IDataProvider::__variants>("OmnixMouseModule", {OMNIX_MOUSE_POS_Y});
 
             if(max::math::auto_inside_region(mx, my, parent->position, parent->size)){
-                auto _self = this;
-                if (_self->dragging) {
-                bool isMouseHeld = Omnix::Helpers::np_get_data<bool, IDataProvider::__variants>("OmnixMouseModule", {OMNIX_PRESS,OMNIX_MOUSE_LEFT_BUTTON});
-                if (!isMouseHeld) {
-                        _self->dragging = false;
-                    } else {
-                        float deltaX = Omnix::Helpers::np_get_data<int, IDataProvider::__variants>("OmnixMouseModule", {OMNIX_MOUSE_DX});
-                        float deltaY = Omnix::Helpers::np_get_data<int, IDataProvider::__variants>("OmnixMouseModule", {OMNIX_MOUSE_DY});
-                        
-                        _self->parent->position.x += deltaX;
-                        _self->parent->position.y -= deltaY;
-                        
-                        _self->parent->reload();
-                    }
-                }
+                float deltaX = Omnix::Helpers::np_get_data<int, IDataProvider::__variants>("OmnixMouseModule", {OMNIX_MOUSE_DX});
+                float deltaY = Omnix::Helpers::np_get_data<int, IDataProvider::__variants>("OmnixMouseModule", {OMNIX_MOUSE_DY});
+                
+                parent->position.x += deltaX;
+                parent->position.y -= deltaY;
+                
+                parent->reload();
             }
         }
         void draw(UIRenderer* renderer){}
         void reload(){}
+        bool is_active() const override { return alwaysUpdate || dragging; }
     };
     static inline UICheckBox* newCheckBox(
         max::vec2<float> startPos,
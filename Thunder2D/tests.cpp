@@ -0,0 +1,1040 @@
+#include "include/batch.h"
+#include "include/t2dtilemap.h"
+#include "include/t2dglyphatlas.h"
+#include "include/t2datlas.h"
+#include "include/t2dlayout.h"
+#define STB_IMAGE_IMPLEMENTATION
+#include "texture.h"
+#include "imageops.h"
+#include "enginetexture.h"
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "framecapture.h"
+#include "test_utils.h"
+#include "time_utils.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <random>
+
+static int t2dFailures = 0;
+#define T2D_CHECK(cond)\
+if(!(cond)){\
+    std::cerr<<"[T2D_CHECK] "<<__FILE__<<":"<<__LINE__<<" "<<#cond<<std::endl;\
+    t2dFailures++;\
+}\
+
+static bool nearly(float a,float b,float eps = 0.0001f){
+    return std::fabs(a-b) < eps;
+}
+
+TEST(t2dInstanceExpansion){
+    std::array<max::vec2<float>, 4> mirrored = {
+        max::vec2<float>{0.5f,0.25f},
+        max::vec2<float>{0.25f,0.25f},
+        max::vec2<float>{0.25f,0.5f},
+        max::vec2<float>{0.5f,0.5f}
+    };
+    float rotations[] = {0.0f, 0.3f, -1.2f, 3.14159f};
+
+    for(float rotation:rotations){
+        for(int mirror = 0; mirror < 2; mirror++){
+            Sprite sprite{{120.0f,-40.0f},{32.0f,48.0f},3,{0.2f,0.4f,0.6f,1.0f}};
+            sprite.rotation = rotation;
+            if(mirror) sprite.txCoords = mirrored;
+
+            auto reference = sprite.generateVertices();
+            SpriteInstance instance{};
+            T2D_CHECK(sprite.fillInstance(instance));
+            auto expanded = expandSpriteInstance(instance);
+
+            for(int i = 0; i < 4; i++){
+                auto* ref = static_cast<SpriteVertex::Data*>(reference[i]->getData());
+                T2D_CHECK(nearly(ref->x, expanded[i].x));
+                T2D_CHECK(nearly(ref->y, expanded[i].y));
+                T2D_CHECK(nearly(ref->u, expanded[i].u));
+                T2D_CHECK(nearly(ref->v, expanded[i].v));
+                T2D_CHECK(nearly(ref->r, expanded[i].r));
+                T2D_CHECK(nearly(ref->a, expanded[i].a));
+                T2D_CHECK(ref->textureID == expanded[i].textureID);
+            }
+        }
+    }
+    return BoltTestResult::CALCULATED;
+};
+
+static std::vector<uint32_t> bruteForceQuery(const std::vector<AABB2D>& boxes,const std::vector<bool>& alive,const AABB2D& area){
+    std::vector<uint32_t> out;
+    for(uint32_t i = 0; i < boxes.size(); i++){
+        if(alive[i] && boxes[i].overlaps(area)) out.push_back(i);
+    }
+    return out;
+}
+
+TEST(t2dGridMatchesBruteForce){
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> coord(-2000.0f, 2000.0f);
+    std::uniform_real_distribution<float> extent(1.0f, 300.0f);
+
+    SpatialGrid grid(128.0f);
+    std::vector<AABB2D> boxes;
+    std::vector<bool> alive;
+    auto randomBox = [&](){
+        float x = coord(rng), y = coord(rng);
+        return AABB2D{x, y, x + extent(rng), y + extent(rng)};
+    };
+
+    for(int i = 0; i < 2000; i++){
+        boxes.push_back(randomBox());
+        alive.push_back(true);
+        T2D_CHECK(grid.insert(boxes.back()) == i);
+    }
+    for(int i = 0; i < 2000; i += 3){
+        boxes[i] = randomBox();
+        grid.update(i, boxes[i]);
+    }
+    for(int i = 1; i < 2000; i += 7){
+        alive[i] = false;
+        grid.remove(i);
+    }
+
+    std::vector<uint32_t> result;
+    for(int q = 0; q < 50; q++){
+        AABB2D area = randomBox();
+        area.maxX += q * 40.0f;
+        result.clear();
+        grid.query(area, result);
+        std::sort(result.begin(), result.end());
+        T2D_CHECK(result == bruteForceQuery(boxes, alive, area));
+    }
+
+    // zoomed out past every occupied cell
+    result.clear();
+    grid.query({-1e6f, -1e6f, 1e6f, 1e6f}, result);
+    T2D_CHECK(result.size() == grid.size());
+    return BoltTestResult::CALCULATED;
+};
+
+TEST(t2dCullingBenchmark){
+    const int tiles = 1000;
+    const float tileSize = 16.0f;
+
+    std::vector<std::shared_ptr<Sprite>> sprites;
+    sprites.reserve(tiles * tiles);
+    for(int y = 0; y < tiles; y++){
+        for(int x = 0; x < tiles; x++){
+            sprites.push_back(std::make_shared<Sprite>(max::vec2<float>{x * tileSize + tileSize / 2, y * tileSize + tileSize / 2},
+                                                       max::vec2<float>{tileSize, tileSize}, 0));
+        }
+    }
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+    SpatialGrid grid(tileSize * 8);
+    std::vector<AABB2D> boxes;
+    std::vector<bool> alive(sprites.size(), true);
+    boxes.reserve(sprites.size());
+    for(auto& sprite:sprites){
+        boxes.push_back(sprite->getBounds());
+        grid.insert(boxes.back());
+    }
+    auto t1 = std::chrono::high_resolution_clock::now();
+
+    // 1600x1600 viewport over a 16000x16000 world is 1% of the tiles
+    Camera2D cam(1600, 1600);
+    cam.setPosition({8000.0f, 8000.0f});
+    AABB2D view = cam.getViewBounds();
+    T2D_CHECK(nearly(view.minX, 8000.0f, 0.5f) && nearly(view.maxX, 9600.0f, 0.5f));
+
+    const int frames = 60;
+    std::vector<uint32_t> visible;
+    auto t2 = std::chrono::high_resolution_clock::now();
+    for(int i = 0; i < frames; i++){
+        visible.clear();
+        grid.query(view, visible);
+    }
+    auto t3 = std::chrono::high_resolution_clock::now();
+    std::vector<uint32_t> reference;
+    for(int i = 0; i < frames; i++){
+        reference = bruteForceQuery(boxes, alive, view);
+    }
+    auto t4 = std::chrono::high_resolution_clock::now();
+
+    std::sort(visible.begin(), visible.end());
+    T2D_CHECK(visible == reference);
+    T2D_CHECK(visible.size() > tiles * tiles / 200 && visible.size() < tiles * tiles / 50);
+
+    using ms = std::chrono::duration<double, std::milli>;
+    std::cout<<"culling "<<sprites.size()<<" sprites, visible "<<visible.size()
+             <<" | build "<<ms(t1 - t0).count()<<"ms"
+             <<" | grid query "<<ms(t3 - t2).count() / frames<<"ms"
+             <<" | brute force "<<ms(t4 - t3).count() / frames<<"ms"<<std::endl;
+    return BoltTestResult::CALCULATED;
+};
+
+TEST(t2dChunkMeshing){
+    TileChunkData data;
+    int solidCount = 0;
+    for(int x = 0; x < T2D_CHUNK_SIZE; x++){
+        data.flags[TileChunkData::index(x,0)] = T2D_TILE_VISIBLE | T2D_TILE_SOLID;
+        solidCount++;
+    }
+    for(int y = 1; y < 6; y++){
+        data.flags[TileChunkData::index(3,y)] = T2D_TILE_VISIBLE | T2D_TILE_SOLID;
+        solidCount++;
+    }
+    int tile = TileChunkData::index(10,10);
+    data.flags[tile] = T2D_TILE_VISIBLE;
+    data.textureIDs[tile] = 9;
+    data.colors[tile] = packTileColor({0.2f,0.4f,0.6f,1.0f});
+    data.flags[TileChunkData::index(12,12)] = T2D_TILE_VISIBLE;
+    data.textureIDs[TileChunkData::index(12,12)] = 2;
+
+    TileMeshInfo info;
+    info.tileSize = 16.0f;
+    info.origin = {100.0f, -50.0f};
+    info.textureSlots = 8;
+    TileChunkMesh mesh = buildChunkMesh(data, 2, -1, info);
+
+    // untextured tiles share the draw of the lowest texture window
+    T2D_CHECK(mesh.vertices.size() == (solidCount + 2) * 4);
+    T2D_CHECK(mesh.ranges.size() == 2);
+    T2D_CHECK(mesh.ranges[0].textureBase == 0 && mesh.ranges[0].quadCount == solidCount + 1);
+    T2D_CHECK(mesh.ranges[1].textureBase == 8 && mesh.ranges[1].firstQuad == solidCount + 1);
+
+    int covered = 0;
+    for(auto& rect:mesh.solids) covered += rect.width * rect.height;
+    T2D_CHECK(covered == solidCount);
+    T2D_CHECK(mesh.solids.size() == 2);
+
+    // the textured tile must match the equivalent standalone sprite
+    float tileX = 100.0f + (2 * T2D_CHUNK_SIZE + 10) * 16.0f + 8.0f;
+    float tileY = -50.0f + (-1 * T2D_CHUNK_SIZE + 10) * 16.0f + 8.0f;
+    Sprite sprite{{tileX,tileY},{16.0f,16.0f},9,{0.2f,0.4f,0.6f,1.0f}};
+    auto reference = sprite.generateVertices();
+    for(int i = 0; i < 4; i++){
+        auto* ref = static_cast<SpriteVertex::Data*>(reference[i]->getData());
+        const auto& got = mesh.vertices[(solidCount + 1) * 4 + i];
+        T2D_CHECK(nearly(ref->x, got.x) && nearly(ref->y, got.y));
+        T2D_CHECK(nearly(ref->u, got.u) && nearly(ref->v, got.v));
+        T2D_CHECK(nearly(ref->b, got.b, 1.0f/255.0f));
+        T2D_CHECK(ref->textureID == got.textureID);
+    }
+    return BoltTestResult::CALCULATED;
+};
+
+TEST(t2dChunkMeshingOnWorkers){
+    TileMeshInfo info;
+    std::vector<TileChunkData> chunks(64);
+    std::mt19937 rng(11);
+    for(auto& chunk:chunks){
+        for(int i = 0; i < T2D_CHUNK_TILES; i++){
+            chunk.flags[i] = rng() % 3 == 0 ? (T2D_TILE_VISIBLE | T2D_TILE_SOLID) : (rng() % 2 ? T2D_TILE_VISIBLE : T2D_TILE_EMPTY);
+            chunk.textureIDs[i] = static_cast<int16_t>(rng() % 20) - 1;
+        }
+    }
+
+    std::vector<size_t> parallelCounts(chunks.size());
+    std::vector<size_t> parallelRects(chunks.size());
+    {
+        WorkerPool pool(4);
+        for(size_t i = 0; i < chunks.size(); i++){
+            pool.submit([&, i]{
+                TileChunkMesh mesh = buildChunkMesh(chunks[i], (int)i, 0, info);
+                parallelCounts[i] = mesh.vertices.size();
+                parallelRects[i] = mesh.solids.size();
+            });
+        }
+        pool.stop();
+    }
+    for(size_t i = 0; i < chunks.size(); i++){
+        TileChunkMesh mesh = buildChunkMesh(chunks[i], (int)i, 0, info);
+        T2D_CHECK(mesh.vertices.size() == parallelCounts[i]);
+        T2D_CHECK(mesh.solids.size() == parallelRects[i]);
+    }
+    return BoltTestResult::CALCULATED;
+};
+
+//! square glyphs whose size depends on the codepoint, every pixel holds the low byte
+class FakeGlyphRasterizer : public IGlyphRasterizer {
+    public:
+    std::atomic<int> calls = 0;
+    bool rasterize(uint32_t codepoint, GlyphBitmap& out) override {
+        calls++;
+        if(codepoint == 0xE000) return false;
+        out.width = out.height = 8 + static_cast<int>(codepoint % 5) * 4;
+        out.bearingX = 1;
+        out.bearingY = out.height;
+        out.advance = (out.width + 2) << 6;
+        out.pixels.assign(static_cast<size_t>(out.width) * out.height, static_cast<uint8_t>(codepoint & 0xFF));
+        return true;
+    }
+};
+
+TEST(t2dUtf8Decode){
+    auto cps = utf8Decode("A\xC3\xA7\xE2\x82\xAC\xF0\x9F\x98\x80");
+    T2D_CHECK(cps.size() == 4);
+    T2D_CHECK(cps[0] == 'A' && cps[1] == 0xE7 && cps[2] == 0x20AC && cps[3] == 0x1F600);
+
+    // truncated, overlong and surrogate sequences
+    auto bad = utf8Decode("\xE2\x82" "B" "\xC0\xAF" "\xED\xA0\x80");
+    T2D_CHECK(bad.size() == 4);
+    T2D_CHECK(bad[0] == T2D_REPLACEMENT_CHAR && bad[1] == 'B');
+    T2D_CHECK(bad[2] == T2D_REPLACEMENT_CHAR && bad[3] == T2D_REPLACEMENT_CHAR);
+    return BoltTestResult::CALCULATED;
+};
+
+TEST(t2dGlyphAtlasPackAndEvict){
+    FakeGlyphRasterizer raster;
+    GlyphAtlas atlas(64, 2);
+
+    // packed glyphs never overlap and carry their pixels
+    std::vector<const AtlasGlyph*> placed;
+    for(uint32_t cp = 0x400; cp < 0x40A; cp++){
+        GlyphBitmap bitmap;
+        raster.rasterize(cp, bitmap);
+        const AtlasGlyph* glyph = atlas.insert(glyphAtlasKey(1, 16, cp), bitmap);
+        T2D_CHECK(glyph != nullptr);
+        if(!glyph) continue;
+        const auto& page = atlas.getPages()[glyph->page];
+        T2D_CHECK(page.pixels[static_cast<size_t>(glyph->y) * 64 + glyph->x] == (cp & 0xFF));
+        T2D_CHECK(page.dirty());
+        placed.push_back(glyph);
+    }
+    for(size_t i = 0; i < placed.size(); i++){
+        for(size_t j = i + 1; j < placed.size(); j++){
+            const AtlasGlyph& a = *placed[i];
+            const AtlasGlyph& b = *placed[j];
+            bool apart = a.page != b.page || a.x + a.width <= b.x || b.x + b.width <= a.x ||
+                         a.y + a.height <= b.y || b.y + b.height <= a.y;
+            T2D_CHECK(apart);
+        }
+    }
+    T2D_CHECK(atlas.evictionCount() == 0);
+
+    // keep the first glyph hot while flooding the atlas
+    uint64_t hot = glyphAtlasKey(1, 16, 0x400);
+    for(uint32_t cp = 0x500; cp < 0x600; cp++){
+        atlas.nextTick();
+        atlas.find(hot);
+        GlyphBitmap bitmap;
+        raster.rasterize(cp, bitmap);
+        T2D_CHECK(atlas.insert(glyphAtlasKey(1, 16, cp), bitmap) != nullptr);
+    }
+    T2D_CHECK(atlas.getPages().size() == 2);
+    T2D_CHECK(atlas.evictionCount() > 0);
+    T2D_CHECK(atlas.getGeneration() > 0);
+    T2D_CHECK(atlas.find(hot) != nullptr);
+    T2D_CHECK(atlas.find(glyphAtlasKey(1, 16, 0x5FF)) != nullptr);
+
+    GlyphBitmap huge;
+    huge.width = huge.height = 80;
+    huge.pixels.assign(80 * 80, 1);
+    T2D_CHECK(atlas.insert(glyphAtlasKey(1, 16, 0x700), huge) == nullptr);
+    return BoltTestResult::CALCULATED;
+};
+
+TEST(t2dGlyphCacheAsync){
+    auto raster = std::make_shared<FakeGlyphRasterizer>();
+    auto atlas = std::make_shared<GlyphAtlas>(256, 2);
+    GlyphCache cache(atlas, raster, 1, 16, true);
+
+    std::vector<uint32_t> text = utf8Decode("\xD0\x9F\xD1\x80\xD0\xB8\xD0\xB2\xD0\xB5\xD1\x82 \xE4\xB8\x96\xE7\x95\x8C");
+    for(uint32_t cp : text) cache.get(cp);
+    for(uint32_t cp : text) cache.get(cp);
+    cache.get(0xE000);
+    cache.flush();
+
+    // every distinct codepoint was rasterized exactly once, off the calling thread
+    std::vector<uint32_t> distinct = text;
+    std::sort(distinct.begin(), distinct.end());
+    distinct.erase(std::unique(distinct.begin(), distinct.end()), distinct.end());
+    T2D_CHECK(raster->calls == static_cast<int>(distinct.size()) + 1);
+    for(uint32_t cp : text) T2D_CHECK(cache.get(cp) != nullptr);
+    T2D_CHECK(cache.get(0xE000) == nullptr);
+    T2D_CHECK(cache.isMissing(0xE000));
+    T2D_CHECK(cache.pendingCount() == 0);
+    T2D_CHECK(atlas->glyphCount() == distinct.size());
+
+    // a second size of the same font gets its own entries
+    GlyphCache bigger(atlas, raster, 1, 32, false);
+    T2D_CHECK(bigger.get(text[0]) != nullptr);
+    T2D_CHECK(atlas->glyphCount() == distinct.size() + 1);
+    return BoltTestResult::CALCULATED;
+};
+
+static std::vector<SdfSegment> sdfSquare(float x0,float y0,float x1,float y1,bool clockwise){
+    std::vector<max::vec2<float>> pts = {{x0,y0},{x1,y0},{x1,y1},{x0,y1}};
+    if(clockwise) std::reverse(pts.begin(), pts.end());
+    std::vector<SdfSegment> segments;
+    for(size_t i = 0; i < pts.size(); i++){
+        auto a = pts[i], b = pts[(i + 1) % pts.size()];
+        segments.push_back({a.x, a.y, b.x, b.y});
+    }
+    return segments;
+}
+
+TEST(t2dSdfFromOutline){
+    GlyphBitmap ccw, cw;
+    ccw.width = cw.width = 20;
+    ccw.height = cw.height = 20;
+    buildSdf(sdfSquare(5,5,15,15,false), 0, 0, 4, ccw);
+    buildSdf(sdfSquare(5,5,15,15,true), 0, 0, 4, cw);
+    auto at = [](const GlyphBitmap& b,int x,int y){ return (int)b.pixels[y * b.width + x]; };
+
+    T2D_CHECK(ccw.pixels == cw.pixels);
+    T2D_CHECK(at(ccw,10,10) == 255);
+    T2D_CHECK(at(ccw,0,0) == 0);
+    // pixel centres half a pixel either side of the edge straddle the midpoint evenly
+    T2D_CHECK(at(ccw,5,10) > 128 && at(ccw,4,10) < 128);
+    T2D_CHECK(at(ccw,5,10) + at(ccw,4,10) == 255);
+    // 2.5 pixels inside with a spread of 4
+    T2D_CHECK(std::abs(at(ccw,7,10) - 207) <= 1);
+    for(int x = 0; x < 10; x++) T2D_CHECK(at(ccw,x,10) <= at(ccw,x + 1,10));
+
+    // an opposite wound inner contour punches a hole
+    auto ring = sdfSquare(2,2,18,18,false);
+    auto hole = sdfSquare(7,7,13,13,true);
+    ring.insert(ring.end(), hole.begin(), hole.end());
+    GlyphBitmap donut;
+    donut.width = donut.height = 20;
+    buildSdf(ring, 0, 0, 4, donut);
+    T2D_CHECK(at(donut,10,10) < 128);
+    T2D_CHECK(at(donut,4,10) > 128);
+    return BoltTestResult::CALCULATED;
+};
+
+TEST(t2dFlexLayout){
+    auto same = [](const LayoutRect& r, float x, float y, float w, float h){
+        return nearly(r.x, x) && nearly(r.y, y) && nearly(r.width, w) && nearly(r.height, h);
+    };
+
+    // centred row with a gap, single line items are centred on the cross axis
+    LayoutTree row;
+    LayoutStyle container;
+    container.justify = FlexJustify::CENTER;
+    container.alignItems = FlexAlign::CENTER;
+    container.gap = 10;
+    row.setStyle(0, container);
+    int a = row.add(0, {}, 50, 20);
+    int b = row.add(0, {}, 30, 40);
+    T2D_CHECK(row.layout(200, 100));
+    T2D_CHECK(same(row.rect(a), 55, 40, 50, 20));
+    T2D_CHECK(same(row.rect(b), 115, 30, 30, 40));
+
+    // nothing changed, no pass runs
+    size_t measures = row.measureCount(), arranges = row.arrangeCount();
+    T2D_CHECK(!row.layout(200, 100));
+    T2D_CHECK(row.measureCount() == measures && row.arrangeCount() == arranges);
+    // a new intrinsic size re-measures only the leaf and its ancestors
+    row.setIntrinsic(b, 30, 60);
+    T2D_CHECK(row.layout(200, 100));
+    T2D_CHECK(row.measureCount() == measures + 2);
+    T2D_CHECK(same(row.rect(b), 115, 20, 30, 60));
+
+    // wrapping column of fixed and percentage sized items with padding
+    LayoutTree column;
+    LayoutStyle columnStyle;
+    columnStyle.direction = FlexDirection::COLUMN;
+    columnStyle.wrap = true;
+    columnStyle.padding = 5;
+    column.setStyle(0, columnStyle);
+    LayoutStyle half;
+    half.width = LayoutLength::px(40);
+    half.height = LayoutLength::percent(50);
+    int c0 = column.add(0, half), c1 = column.add(0, half), c2 = column.add(0, half);
+    column.layout(100, 110);
+    T2D_CHECK(same(column.rect(c0), 5, 5, 40, 50));
+    T2D_CHECK(same(column.rect(c1), 5, 55, 40, 50));
+    T2D_CHECK(same(column.rect(c2), 45, 5, 40, 50));
+    // percentages follow the container
+    column.layout(100, 210);
+    T2D_CHECK(same(column.rect(c1), 5, 105, 40, 100));
+
+    // grow shares the free space, stretch fills the cross axis, ignored items keep out
+    LayoutTree grow;
+    LayoutStyle growStyle;
+    growStyle.alignItems = FlexAlign::STRETCH;
+    grow.setStyle(0, growStyle);
+    LayoutStyle one, three, skip;
+    one.grow = 1;
+    three.grow = 3;
+    skip.ignore = true;
+    int g0 = grow.add(0, {}, 20, 10);
+    int g1 = grow.add(0, one, 10, 10);
+    int g2 = grow.add(0, skip, 500, 500);
+    int g3 = grow.add(0, three, 10, 10);
+    grow.layout(120, 30);
+    T2D_CHECK(same(grow.rect(g0), 0, 0, 20, 30));
+    T2D_CHECK(same(grow.rect(g1), 20, 0, 30, 30));
+    T2D_CHECK(same(grow.rect(g3), 50, 0, 70, 30));
+    T2D_CHECK(same(grow.rect(g2), 0, 0, 0, 0));
+
+    // nested containers size to their content
+    LayoutTree nested;
+    LayoutStyle inner;
+    inner.direction = FlexDirection::COLUMN;
+    inner.gap = 2;
+    int box = nested.add(0, inner);
+    nested.add(box, {}, 30, 10);
+    int last = nested.add(box, {}, 40, 10);
+    int after = nested.add(0, {}, 5, 5);
+    nested.layout(300, 300);
+    T2D_CHECK(same(nested.rect(box), 0, 0, 40, 22));
+    T2D_CHECK(same(nested.rect(last), 0, 12, 40, 10));
+    T2D_CHECK(same(nested.rect(after), 40, 0, 5, 5));
+
+    // a window resize with thousands of items stays cheap when only the root moved
+    LayoutTree big;
+    LayoutStyle wrapRow;
+    wrapRow.wrap = true;
+    big.setStyle(0, wrapRow);
+    for(int i = 0; i < 5000; i++) big.add(0, {}, 16, 16);
+    big.layout(800, 600);
+    measures = big.measureCount();
+    big.layout(800, 600);
+    T2D_CHECK(big.measureCount() == measures);
+    big.layout(1600, 600);
+    T2D_CHECK(big.measureCount() == measures + 1);
+    T2D_CHECK(same(big.rect(101), 0, 16, 16, 16));
+    return BoltTestResult::CALCULATED;
+};
+
+TEST(t2dAsyncTextureStartup){
+    const char* names[] = {"char_1.png", "char_2.png", "pirate.png", "selectorSprite.png", "ssheet.png"};
+    const int copies = 100;
+    std::vector<std::string> paths;
+    for(int i = 0; i < copies; i++){
+        for(auto name:names) paths.push_back(std::string("resources/textures/") + name);
+    }
+    TextureLoadOptions options;
+    options.force_data_RGBA = {255, 255, 255, 0};
+
+    // what the scene used to block on, every decode back to back on one thread
+    auto t0 = std::chrono::high_resolution_clock::now();
+    std::vector<max::vec2<int>> sizes;
+    for(const auto& path:paths){
+        TexturePixels pixels = Texture::decode(path, options);
+        T2D_CHECK(pixels);
+        sizes.push_back({pixels.width, pixels.height});
+    }
+    auto t1 = std::chrono::high_resolution_clock::now();
+
+    AsyncTextureLoader loader;
+    std::atomic<size_t> uploaded = 0;
+    loader.uploadFnc = [&](Texture&, const TexturePixels& pixels){
+        uploaded++;
+        return static_cast<bool>(pixels);
+    };
+    std::vector<TextureHandle> handles;
+    for(const auto& path:paths) handles.push_back(loader.load(path, options));
+    auto t2 = std::chrono::high_resolution_clock::now();
+    size_t frames = 0;
+    while(loader.pending() > 0){
+        if(loader.pumpUploads(0.5) > 0) frames++;
+        else std::this_thread::yield();
+    }
+    auto t3 = std::chrono::high_resolution_clock::now();
+
+    T2D_CHECK(uploaded == paths.size() && loader.uploadCount() == paths.size());
+    for(const auto& handle:handles) T2D_CHECK(handle.ready() && !handle.failed());
+    TextureHandle missing = loader.load("resources/textures/missing.png");
+    loader.finish();
+    T2D_CHECK(missing.failed() && !missing.ready());
+
+    // same decode on the worker as on the caller
+    TexturePixels serial = Texture::decode(paths[2], options);
+    TexturePixels threaded;
+    {
+        WorkerPool pool(1);
+        pool.submit([&]{ threaded = Texture::decode(paths[2], options); });
+        pool.stop();
+    }
+    T2D_CHECK(serial && threaded && serial.width == threaded.width && serial.height == threaded.height);
+    T2D_CHECK(std::equal(serial.data.get(), serial.data.get() + serial.width * serial.height * 4, threaded.data.get()));
+
+    using ms = std::chrono::duration<double, std::milli>;
+    std::cout<<"texture startup "<<paths.size()<<" images"
+             <<" | serial decode "<<ms(t1 - t0).count()<<"ms"
+             <<" | async submit "<<ms(t2 - t1).count()<<"ms"
+             <<" | async until all ready "<<ms(t3 - t1).count()<<"ms over "<<frames<<" upload pumps"
+             <<" on "<<std::thread::hardware_concurrency()<<" threads"<<std::endl;
+    return BoltTestResult::CALCULATED;
+};
+
+TEST(t2dImageOpsMatchScalar){
+    using namespace imageops;
+    std::vector<SimdLevel> levels{SimdLevel::SCALAR};
+    if(bestSimd() != SimdLevel::SCALAR) levels.push_back(SimdLevel::SSE2);
+    if(bestSimd() == SimdLevel::AVX2) levels.push_back(SimdLevel::AVX2);
+
+    // odd sizes leave tails for every vector width, keyed pixels are planted on purpose
+    const size_t width = 37, height = 23;
+    std::mt19937 rng(42);
+    std::vector<uint8_t> source(width * height * 4);
+    for(auto& b:source) b = static_cast<uint8_t>(rng());
+    for(size_t i = 0; i < source.size(); i += 4 * 3){
+        source[i] = 255; source[i + 1] = 0; source[i + 2] = 255;
+    }
+    const uint8_t clear[4] = {0, 0, 0, 0};
+
+    auto runAt = [&](const Pipeline& ops, SimdLevel level){
+        std::vector<uint8_t> image = source;
+        ops.run(image.data(), width, height, level);
+        return image;
+    };
+    Pipeline key, premul, bgra, flip, all;
+    key.colorKey(255, 0, 255, clear);
+    premul.premultiply();
+    bgra.swizzle(2, 1, 0, 3);
+    flip.flipVertically();
+    all.colorKey(255, 0, 255, clear).premultiply().swizzle(3, 2, 1, 0).flipVertically();
+
+    for(const Pipeline* ops:{&key, &premul, &bgra, &flip, &all}){
+        std::vector<uint8_t> reference = runAt(*ops, SimdLevel::SCALAR);
+        for(SimdLevel level:levels) T2D_CHECK(runAt(*ops, level) == reference);
+    }
+
+    // the scalar path itself against plain per-pixel definitions
+    std::vector<uint8_t> expected = source;
+    for(size_t i = 0; i < expected.size(); i += 4){
+        uint8_t* p = &expected[i];
+        if(p[0] == 255 && p[1] == 0 && p[2] == 255) std::fill(p, p + 4, 0);
+        for(int c = 0; c < 3; c++) p[c] = static_cast<uint8_t>(std::lround(p[c] * p[3] / 255.0));
+        std::swap(p[0], p[3]);
+        std::swap(p[1], p[2]);
+    }
+    std::vector<uint8_t> flipped(expected.size());
+    for(size_t y = 0; y < height; y++){
+        std::copy_n(&expected[(height - 1 - y) * width * 4], width * 4, &flipped[y * width * 4]);
+    }
+    T2D_CHECK(runAt(all, SimdLevel::SCALAR) == flipped);
+    return BoltTestResult::CALCULATED;
+};
+
+TEST(t2dImageOpsThroughput){
+    using namespace imageops;
+    const size_t width = 3840, height = 2160;
+    std::vector<uint8_t> image(width * height * 4);
+    std::mt19937 rng(7);
+    for(auto& b:image) b = static_cast<uint8_t>(rng() & 0xF0);
+    const uint8_t clear[4] = {0, 0, 0, 0};
+    const double megabytes = image.size() / (1024.0 * 1024.0);
+    using ms = std::chrono::duration<double, std::milli>;
+
+    std::vector<SimdLevel> levels{SimdLevel::SCALAR};
+    if(bestSimd() != SimdLevel::SCALAR) levels.push_back(SimdLevel::SSE2);
+    if(bestSimd() == SimdLevel::AVX2) levels.push_back(SimdLevel::AVX2);
+    for(SimdLevel level:levels){
+        std::cout<<"imageops 4K "<<simdName(level);
+        for(int op = 0; op < 4; op++){
+            Pipeline ops;
+            const char* name = "key";
+            if(op == 0) ops.colorKey(0, 0, 0, clear);
+            if(op == 1){ ops.premultiply(); name = "premultiply"; }
+            if(op == 2){ ops.swizzle(2, 1, 0, 3); name = "swizzle"; }
+            if(op == 3){ ops.flipVertically(); name = "flip"; }
+            auto t0 = std::chrono::high_resolution_clock::now();
+            ops.run(image.data(), width, height, level);
+            auto t1 = std::chrono::high_resolution_clock::now();
+            std::cout<<" | "<<name<<" "<<static_cast<int>(megabytes / (ms(t1 - t0).count() / 1000.0))<<"MB/s";
+        }
+        std::cout<<std::endl;
+    }
+    return BoltTestResult::CALCULATED;
+};
+
+TEST(t2dTextureCacheSharing){
+    size_t uploads = 0;
+    auto countUpload = [&](Texture&, const TexturePixels& pixels){
+        uploads++;
+        return static_cast<bool>(pixels);
+    };
+
+    // ten requests for one sheet cost one decode and one upload
+    TextureCache cache;
+    cache.uploadFnc = countUpload;
+    std::vector<TextureHandle> sheets;
+    for(int i = 0; i < 10; i++) sheets.push_back(cache.get("resources/textures/ssheet.png"));
+    T2D_CHECK(uploads == 1 && cache.size() == 1);
+    T2D_CHECK(cache.getStats().hits == 9 && cache.getStats().misses == 1);
+    T2D_CHECK(sheets[0].useCount() == 11);
+    T2D_CHECK(cache.getStats().residentBytes == 360 * 480 * 4 * 4 / 3);
+    // other options are another texture
+    TextureLoadOptions keyed;
+    keyed.force_data_RGBA = {255, 255, 255, 0};
+    TextureHandle keyedSheet = cache.get("resources/textures/ssheet.png", keyed);
+    T2D_CHECK(uploads == 2 && cache.size() == 2);
+
+    // the budget only takes textures nobody holds, least recently requested first
+    TextureCache small(400 * 1024);
+    small.uploadFnc = countUpload;
+    TextureHandle pirate = small.get("resources/textures/pirate.png");
+    small.get("resources/textures/char_1.png");
+    small.get("resources/textures/char_2.png");
+    T2D_CHECK(small.size() == 3);
+    TextureHandle sheet = small.get("resources/textures/ssheet.png");
+    T2D_CHECK(small.getStats().evictions == 2 && small.size() == 2);
+    T2D_CHECK(pirate.ready() && small.getStats().residentBytes > small.budgetBytes);
+    pirate = TextureHandle();
+    small.trim();
+    T2D_CHECK(small.size() == 1 && small.getStats().residentBytes == 360 * 480 * 4 * 4 / 3);
+
+    // a failed load is not cached, the next request tries the file again
+    namespace fs = std::filesystem;
+    fs::path late = fs::temp_directory_path() / "t2d_late_texture.png";
+    fs::remove(late);
+    TextureCache retry;
+    retry.uploadFnc = countUpload;
+    T2D_CHECK(retry.get(late.string()).failed());
+    fs::copy_file("resources/textures/pirate.png", late);
+    TextureHandle arrived = retry.get(late.string());
+    T2D_CHECK(arrived.ready() && retry.getStats().misses == 2 && retry.getStats().hits == 0 && retry.size() == 1);
+    fs::remove(late);
+
+    // async misses share the pending handle too
+    AsyncTextureLoader loader(2);
+    loader.uploadFnc = countUpload;
+    TextureCache streamed(256u << 20, &loader);
+    TextureHandle first = streamed.get("resources/textures/pirate.png");
+    TextureHandle second = streamed.get("resources/textures/pirate.png");
+    loader.finish();
+    T2D_CHECK(loader.loadCount() == 1 && first.ready() && second.ready());
+    T2D_CHECK(streamed.getStats().residentBytes == 160 * 320 * 4 * 4 / 3);
+    return BoltTestResult::CALCULATED;
+};
+
+TEST(t2dAtlasPacking){
+    // random rects never overlap and stay inside the bin
+    MaxRectsPacker packer(256, 256);
+    std::mt19937 rng(5);
+    std::vector<AtlasRect> used;
+    for(int i = 0; i < 200; i++){
+        AtlasRect r;
+        if(packer.insert(4 + rng() % 28, 4 + rng() % 28, r)) used.push_back(r);
+    }
+    T2D_CHECK(used.size() > 60 && packer.occupancy() > 0.7f);
+    for(size_t i = 0; i < used.size(); i++){
+        T2D_CHECK(used[i].x >= 0 && used[i].y >= 0 && used[i].x + used[i].width <= 256 && used[i].y + used[i].height <= 256);
+        for(size_t j = i + 1; j < used.size(); j++){
+            const AtlasRect& a = used[i];
+            const AtlasRect& b = used[j];
+            T2D_CHECK(a.x >= b.x + b.width || b.x >= a.x + a.width || a.y >= b.y + b.height || b.y >= a.y + a.height);
+        }
+    }
+
+    // a 20x10 image with a 6x4 opaque block at (3,2), colour encodes the pixel
+    auto makeImage = [](const std::string& name, int w, int h, AtlasRect opaque){
+        AtlasImage image{name, w, h, std::vector<uint8_t>(static_cast<size_t>(w) * h * 4, 0)};
+        for(int y = opaque.y; y < opaque.y + opaque.height; y++){
+            for(int x = opaque.x; x < opaque.x + opaque.width; x++){
+                uint8_t* p = &image.rgba[(static_cast<size_t>(y) * w + x) * 4];
+                p[0] = static_cast<uint8_t>(x); p[1] = static_cast<uint8_t>(y); p[2] = 7; p[3] = 255;
+            }
+        }
+        return image;
+    };
+    std::vector<AtlasImage> images{makeImage("ui/button", 20, 10, {3, 2, 6, 4})};
+    for(int i = 0; i < 30; i++) images.push_back(makeImage("tiles/" + std::to_string(i), 16, 16, {0, 0, 16, 16}));
+    AtlasBuildOptions options;
+    options.maxSize = 64;
+    AtlasManifest manifest = buildAtlas(images, options);
+    T2D_CHECK(manifest.sprites.size() == images.size() && manifest.pages.size() == 4);
+    for(const auto& page:manifest.pages){
+        T2D_CHECK((page.width & (page.width - 1)) == 0 && (page.height & (page.height - 1)) == 0 && page.width <= 64);
+    }
+
+    const AtlasSprite* button = manifest.find("ui/button");
+    T2D_CHECK(button && button->width == 6 && button->height == 4 && button->offsetX == 3 && button->offsetY == 2);
+    T2D_CHECK(button->sourceWidth == 20 && button->sourceHeight == 10);
+    const AtlasPage& page = manifest.pages[button->page];
+    auto at = [&](int x, int y){ return &page.rgba[(static_cast<size_t>(y) * page.width + x) * 4]; };
+    T2D_CHECK(at(button->x, button->y)[0] == 3 && at(button->x, button->y)[1] == 2);
+    // the extruded ring repeats the edges, the corner takes the corner pixel
+    T2D_CHECK(at(button->x - 1, button->y + 2)[0] == 3 && at(button->x - 1, button->y + 2)[1] == 4);
+    T2D_CHECK(at(button->x + 6, button->y)[0] == 8);
+    T2D_CHECK(at(button->x - 1, button->y - 1)[0] == 3 && at(button->x - 1, button->y - 1)[1] == 2);
+    T2D_CHECK(at(button->x + 6, button->y + 4)[0] == 8 && at(button->x + 6, button->y + 4)[1] == 5);
+
+    // the binary manifest round trips and resolves names to flipped-v UVs
+    std::vector<uint8_t> bytes = manifest.serialize();
+    AtlasManifest loaded;
+    T2D_CHECK(loaded.deserialize(bytes.data(), bytes.size()));
+    const AtlasSprite* tile = loaded.find("tiles/29");
+    T2D_CHECK(tile && tile->width == 16 && loaded.pages.size() == manifest.pages.size());
+    auto uv = loaded.coords(*loaded.find("ui/button"));
+    const AtlasPage& loadedPage = loaded.pages[button->page];
+    T2D_CHECK(nearly(uv[0].x, button->x / float(loadedPage.width)));
+    T2D_CHECK(nearly(uv[2].y, 1.0f - button->y / float(loadedPage.height)));
+    T2D_CHECK(nearly(uv[0].y, 1.0f - (button->y + 4) / float(loadedPage.height)));
+    T2D_CHECK(!loaded.find("missing"));
+    T2D_CHECK(!loaded.deserialize(bytes.data(), bytes.size() - 3));
+    return BoltTestResult::CALCULATED;
+};
+
+TEST(t2dEngineTextureFormat){
+    namespace fs = std::filesystem;
+    // lz4 round trips repetitive, random and tiny inputs
+    std::mt19937 rng(9);
+    std::vector<std::vector<uint8_t>> inputs{{}, {1, 2, 3}, std::vector<uint8_t>(5000, 42), std::vector<uint8_t>(70000)};
+    for(auto& b:inputs.back()) b = static_cast<uint8_t>(rng() % 4);
+    for(const auto& input:inputs){
+        std::vector<uint8_t> packed = lz4::compress(input.data(), input.size());
+        std::vector<uint8_t> unpacked(input.size());
+        T2D_CHECK(lz4::decompress(packed.data(), packed.size(), unpacked.data(), unpacked.size()) && unpacked == input);
+    }
+    std::vector<uint8_t> flat = lz4::compress(inputs[2].data(), inputs[2].size());
+    T2D_CHECK(flat.size() < 64);
+    std::vector<uint8_t> sink(inputs[2].size());
+    T2D_CHECK(!lz4::decompress(flat.data(), flat.size() - 1, sink.data(), sink.size()));
+
+    // 5x3 image, the chain ends at 1x1 and level 1 is the box filtered base
+    std::vector<uint8_t> rgba(5 * 3 * 4);
+    for(size_t i = 0; i < rgba.size(); i++) rgba[i] = static_cast<uint8_t>(i * 3);
+    for(bool compressed:{false, true}){
+        std::vector<uint8_t> file = encodeEngineTexture(rgba.data(), 5, 3, {true, compressed}, 77);
+        EngineTextureView view;
+        T2D_CHECK(view.parse(file.data(), file.size()));
+        T2D_CHECK(view.levels.size() == 3 && view.header.sourceHash == 77);
+        T2D_CHECK(view.levels[1].width == 2 && view.levels[1].height == 1 && view.levels[2].width == 1);
+        T2D_CHECK(std::equal(rgba.begin(), rgba.end(), view.level(0)));
+        T2D_CHECK(view.level(1)[0] == (rgba[0] + rgba[4] + rgba[20] + rgba[24] + 2) / 4);
+        // uncompressed levels are read in place and stay upload aligned
+        if(!compressed) T2D_CHECK(view.level(0) == file.data() + engineTexturePayloadOffset(3));
+        T2D_CHECK(!view.parse(file.data(), file.size() - 1));
+    }
+
+    // the cache converts once, then again only when the source bytes change
+    fs::path dir = fs::temp_directory_path() / "t2d_otex_cache";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    fs::path source = dir / "pirate.png";
+    fs::copy_file("resources/textures/pirate.png", source);
+    EngineTextureCache cache((dir / "cache").string(), {true, true});
+    std::string first = cache.resolve(source.string());
+    T2D_CHECK(!first.empty() && cache.resolve(source.string()) == first && cache.conversions == 1);
+    { std::ofstream touch(source, std::ios::binary | std::ios::app); touch << "edited"; }
+    std::string second = cache.resolve(source.string());
+    T2D_CHECK(!second.empty() && second != first && cache.conversions == 2);
+    T2D_CHECK(!fs::exists(first) && fs::exists(second));
+    TextureLoadOptions unflipped;
+    unflipped.flipVertically = false;
+    std::string third = cache.resolve(source.string(), unflipped);
+    T2D_CHECK(!third.empty() && third != second && cache.conversions == 3);
+    // entries for other options, or another source with the same stem, are left alone
+    T2D_CHECK(fs::exists(second) && fs::exists(third));
+    fs::create_directories(dir / "other");
+    fs::copy_file("resources/textures/ssheet.png", dir / "other" / "pirate.png");
+    std::string other = cache.resolve((dir / "other" / "pirate.png").string());
+    T2D_CHECK(!other.empty() && other != second && fs::exists(second) && fs::exists(third));
+    // a truncated entry is not trusted as a hit
+    fs::resize_file(second, fs::file_size(second) / 2);
+    T2D_CHECK(cache.resolve(source.string()) == second && cache.conversions == 5);
+    EngineTextureView reopened;
+    T2D_CHECK(reopened.open(second));
+
+    // cold load, png decode plus cpu mips against mapping the baked chain
+    EngineTextureCache raw((dir / "raw").string(), {true, false});
+    std::string baked = raw.resolve("resources/textures/ssheet.png");
+    std::string packed = cache.resolve("resources/textures/ssheet.png");
+    const int loops = 50;
+    auto time = [&](auto&& fn){
+        auto start = std::chrono::steady_clock::now();
+        for(int i = 0; i < loops; i++) fn();
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / loops;
+    };
+    size_t bytes = 0;
+    double pngMs = time([&]{
+        TexturePixels pixels = Texture::decode("resources/textures/ssheet.png", {});
+        std::vector<uint8_t> chain = encodeEngineTexture(pixels.data.get(), pixels.width, pixels.height, {true, false});
+        bytes += chain.size();
+    });
+    double mappedMs = time([&]{
+        EngineTextureView view;
+        if(view.open(baked)) bytes += view.level(view.levels.size() - 1)[0];
+    });
+    double lz4Ms = time([&]{
+        EngineTextureView view;
+        if(view.open(packed)) bytes += view.level(0)[0];
+    });
+    T2D_CHECK(bytes > 0);
+    std::cout<<"otex cold load 360x480 | png decode + mips "<<pngMs<<"ms | mapped "<<mappedMs<<"ms ("<<fs::file_size(baked)
+             <<" bytes) | lz4 "<<lz4Ms<<"ms ("<<fs::file_size(packed)<<" bytes)"<<std::endl;
+    fs::remove_all(dir);
+    return BoltTestResult::CALCULATED;
+};
+
+TEST(t2dFrameCaptureEncode){
+    namespace fs = std::filesystem;
+    // qoi round trips runs, small deltas, index hits and alpha changes
+    const int w = 97, h = 61;
+    std::vector<uint8_t> image(static_cast<size_t>(w) * h * 4);
+    std::mt19937 rng(3);
+    for(int y = 0; y < h; y++){
+        for(int x = 0; x < w; x++){
+            uint8_t* p = &image[(static_cast<size_t>(y) * w + x) * 4];
+            bool noisy = y % 4 == 0;
+            p[0] = static_cast<uint8_t>(noisy ? rng() : x * 2);
+            p[1] = static_cast<uint8_t>(noisy ? rng() : y);
+            p[2] = static_cast<uint8_t>(x < 40 ? 9 : x + y);
+            p[3] = static_cast<uint8_t>(y % 7 == 0 ? rng() : 255);
+        }
+    }
+    std::vector<uint8_t> encoded = qoi::encode(image.data(), w, h);
+    std::vector<uint8_t> decoded;
+    int dw = 0, dh = 0;
+    T2D_CHECK(qoi::decode(encoded.data(), encoded.size(), decoded, dw, dh) && dw == w && dh == h && decoded == image);
+    T2D_CHECK(!qoi::decode(encoded.data(), 20, decoded, dw, dh));
+
+    // a readback is bottom-up, the written files are top-down
+    fs::path dir = fs::temp_directory_path() / "t2d_capture";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    FrameCapture capture;
+    capture.submitEncode(std::vector<uint8_t>(image), w, h, (dir / "shot.png").string(), CaptureFormat::PNG);
+    capture.submitEncode(std::vector<uint8_t>(image), w, h, (dir / "shot.qoi").string(), FrameCapture::formatFor("shot.qoi"));
+    capture.finish();
+    T2D_CHECK(capture.writtenCount() == 2 && capture.failureCount() == 0);
+    std::vector<uint8_t> flipped(image.size());
+    for(int y = 0; y < h; y++){
+        std::copy_n(&image[static_cast<size_t>(h - 1 - y) * w * 4], w * 4, &flipped[static_cast<size_t>(y) * w * 4]);
+    }
+    int pw = 0, ph = 0, pc = 0;
+    unsigned char* png = stbi_load((dir / "shot.png").string().c_str(), &pw, &ph, &pc, 4);
+    T2D_CHECK(png && pw == w && ph == h && std::equal(flipped.begin(), flipped.end(), png));
+    stbi_image_free(png);
+    std::ifstream qoiFile(dir / "shot.qoi", std::ios::binary);
+    std::vector<uint8_t> qoiBytes((std::istreambuf_iterator<char>(qoiFile)), std::istreambuf_iterator<char>());
+    T2D_CHECK(qoi::decode(qoiBytes.data(), qoiBytes.size(), decoded, dw, dh) && decoded == flipped);
+
+    // frame thread cost, the old copy + flip + png save against handing a readback to the worker
+    const int fw = 600, fh = 600, frames = 10;
+    std::vector<uint8_t> frame(static_cast<size_t>(fw) * fh * 4);
+    for(size_t i = 0; i < frame.size(); i++) frame[i] = static_cast<uint8_t>((i / 4 % fw) ^ (i / 4 / fw) ^ (i % 4 * 40));
+    auto start = std::chrono::steady_clock::now();
+    for(int i = 0; i < frames; i++){
+        std::vector<uint8_t> pixels(frame);
+        std::vector<uint8_t> rows(pixels.size());
+        for(int y = 0; y < fh; ++y) std::memcpy(&rows[static_cast<size_t>(y) * fw * 4], &pixels[static_cast<size_t>(fh - 1 - y) * fw * 4], fw * 4);
+        stbi_write_png((dir / "sync.png").string().c_str(), fw, fh, 4, rows.data(), fw * 4);
+    }
+    double syncMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / frames;
+    double submitMs[2];
+    double drainMs[2];
+    CaptureFormat formats[2] = {CaptureFormat::PNG, CaptureFormat::QOI};
+    // the submit cost alone, without the in-flight cap pushing back
+    capture.maxPendingEncodes = 0;
+    for(int f = 0; f < 2; f++){
+        start = std::chrono::steady_clock::now();
+        for(int i = 0; i < frames; i++){
+            std::string name = "frame_" + std::to_string(f) + "_" + std::to_string(i) + (f ? ".qoi" : ".png");
+            capture.submitEncode(std::vector<uint8_t>(frame), fw, fh, (dir / name).string(), formats[f]);
+        }
+        auto submitted = std::chrono::steady_clock::now();
+        capture.finish();
+        submitMs[f] = std::chrono::duration<double, std::milli>(submitted - start).count() / frames;
+        drainMs[f] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / frames;
+    }
+    // nothing is dropped, every submitted frame reaches the disk
+    T2D_CHECK(capture.writtenCount() == 2 + frames * 2 && capture.failureCount() == 0);
+
+    // the default cap bounds queued frames, blocking keeps them all and dropping counts the rest
+    FrameCapture bounded(2, 1);
+    T2D_CHECK(bounded.maxPendingEncodes == 2);
+    size_t peak = 0;
+    for(int i = 0; i < frames; i++){
+        bounded.submitEncode(std::vector<uint8_t>(frame), fw, fh, (dir / "bounded.qoi").string(), CaptureFormat::QOI);
+        peak = (std::max)(peak, bounded.pendingEncodes());
+    }
+    bounded.finish();
+    T2D_CHECK(peak <= 2 && bounded.writtenCount() == static_cast<size_t>(frames) && bounded.droppedCount() == 0);
+    bounded.dropWhenBusy = true;
+    size_t accepted = 0;
+    for(int i = 0; i < frames; i++){
+        if(bounded.submitEncode(std::vector<uint8_t>(frame), fw, fh, (dir / "dropped.png").string(), CaptureFormat::PNG)) accepted++;
+        T2D_CHECK(bounded.pendingEncodes() <= 2);
+    }
+    bounded.finish();
+    T2D_CHECK(accepted + bounded.droppedCount() == static_cast<size_t>(frames));
+    T2D_CHECK(bounded.writtenCount() == frames + accepted);
+    std::cout<<"capture 600x600 | sync save "<<syncMs<<"ms/frame | async png submit "<<submitMs[0]<<"ms, encode "<<drainMs[0]
+             <<"ms/frame | async qoi submit "<<submitMs[1]<<"ms, encode "<<drainMs[1]<<"ms/frame"<<std::endl;
+    fs::remove_all(dir);
+    return BoltTestResult::CALCULATED;
+};
+
+TEST(t2dCullPanRebuild){
+    // two sets of clean sprites, like the visible set before and after the camera pans.
+    // only the GL-free half of reload runs, there is no context here
+    auto makeSet = [](float x){
+        std::vector<std::shared_ptr<IRenderable>> set;
+        for(int i = 0; i < 3; i++){
+            auto sprite = std::make_shared<Sprite>(max::vec2<float>{x+i*40.0f,0.0f},max::vec2<float>{32.0f,32.0f},0,max::vec4<float>{1.0f,1.0f,1.0f,1.0f});
+            sprite->setClean();
+            sprite->vertexOffsetInBuffer = 99;
+            set.push_back(sprite);
+        }
+        return set;
+    };
+    auto left = makeSet(0.0f), right = makeSet(1000.0f);
+
+    QuadBatchRenderer<SpriteVertex::Data> quads(4096,6144,nullptr,nullptr);
+    quads.renderables = left;
+    T2D_CHECK(quads.prepareReload() && quads.getRebuildCount() == 1 && quads.getQuadCount() == 3);
+
+    // same size, nothing dirty, only the membership differs
+    quads.renderables = right;
+    T2D_CHECK(!quads.prepareReload() && quads.getRebuildCount() == 1);
+    quads.markMembershipChanged();
+    T2D_CHECK(quads.prepareReload() && quads.getRebuildCount() == 2 && quads.getQuadCount() == 3);
+    for(auto& renderable:right) T2D_CHECK(renderable->vertexOffsetInBuffer < 12 && !renderable->isDirty());
+    T2D_CHECK(!quads.prepareReload() && quads.getRebuildCount() == 2);
+
+    for(auto& renderable:left) renderable->vertexOffsetInBuffer = 99;
+    InstancedSpriteBatchRenderer instanced(64,nullptr);
+    instanced.renderables = left;
+    T2D_CHECK(!instanced.prepareReload());
+    instanced.markMembershipChanged();
+    T2D_CHECK(instanced.prepareReload());
+    for(auto& renderable:left) T2D_CHECK(renderable->vertexOffsetInBuffer < 3);
+    instanced.renderables = right;
+    for(auto& renderable:right) renderable->vertexOffsetInBuffer = 99;
+    instanced.markMembershipChanged();
+    T2D_CHECK(instanced.prepareReload());
+    for(auto& renderable:right) T2D_CHECK(renderable->vertexOffsetInBuffer < 3);
+    return BoltTestResult::CALCULATED;
+};
+
+int main(){
+    COLORIZED_MODE = true;
+    TIME_PROFILER_IS_ON = true;
+
+    BOLT_TEST(t2dTest1,"instance expansion matches Sprite::generateVertices",t2dInstanceExpansion);
+    BOLT_TEST(t2dTest2,"spatial grid matches brute force queries",t2dGridMatchesBruteForce);
+    BOLT_TEST(t2dTest3,"1000x1000 tile world culling benchmark",t2dCullingBenchmark);
+    BOLT_TEST(t2dTest4,"chunk meshing matches sprites and merges solids",t2dChunkMeshing);
+    BOLT_TEST(t2dTest5,"chunk meshing on worker threads",t2dChunkMeshingOnWorkers);
+    BOLT_TEST(t2dTest6,"utf-8 decoding and replacement",t2dUtf8Decode);
+    BOLT_TEST(t2dTest7,"glyph atlas packing and LRU eviction",t2dGlyphAtlasPackAndEvict);
+    BOLT_TEST(t2dTest8,"glyph cache rasterizes misses on a worker",t2dGlyphCacheAsync);
+    BOLT_TEST(t2dTest9,"signed distance field from outline segments",t2dSdfFromOutline);
+    BOLT_TEST(t2dTest10,"flex layout measure, arrange and caching",t2dFlexLayout);
+    BOLT_TEST(t2dTest11,"async texture loading startup benchmark",t2dAsyncTextureStartup);
+    BOLT_TEST(t2dTest12,"simd image ops match the scalar path",t2dImageOpsMatchScalar);
+    BOLT_TEST(t2dTest13,"4K image ops throughput per simd level",t2dImageOpsThroughput);
+    BOLT_TEST(t2dTest14,"texture cache shares handles and evicts over budget",t2dTextureCacheSharing);
+    BOLT_TEST(t2dTest15,"maxrects atlas packing, trimming, extrusion and manifest",t2dAtlasPacking);
+    BOLT_TEST(t2dTest16,"engine texture container, lz4, mapped loads and the content hash cache",t2dEngineTextureFormat);
+    BOLT_TEST(t2dTest17,"frame capture flips and encodes png and qoi on workers",t2dFrameCaptureEncode);
+    BOLT_TEST(t2dTest18,"panning over clean sprites re-uploads the new visible set",t2dCullPanRebuild);
+
+    std::ofstream fileStream{"profilerResults__thunder2d.json"};
+    runTests(std::cout,fileStream);
+    fileStream.close();
+
+    return t2dFailures == 0 ? 0 : 1;
+}
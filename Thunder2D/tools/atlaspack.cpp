@@ -0,0 +1,82 @@
+#define NOMINMAX
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stbi_write.h>
+#include "t2datlas.h"
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// t2datlaspack <output base> <image dir>... [--max N] [--padding N] [--extrude N] [--no-trim]
+// writes <output base>.t2da plus <output base>_<page>.png, sprites are named <dir>/<file stem>
+int main(int argc, char** argv) {
+    namespace fs = std::filesystem;
+    AtlasBuildOptions options;
+    std::vector<std::string> positional;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--max" && i + 1 < argc) options.maxSize = std::atoi(argv[++i]);
+        else if (arg == "--padding" && i + 1 < argc) options.padding = std::atoi(argv[++i]);
+        else if (arg == "--extrude" && i + 1 < argc) options.extrude = std::atoi(argv[++i]);
+        else if (arg == "--no-trim") options.trim = false;
+        else positional.push_back(arg);
+    }
+    if (positional.size() < 2) {
+        std::cerr << "usage: t2datlaspack <output base> <image dir>... [--max N] [--padding N] [--extrude N] [--no-trim]" << std::endl;
+        return 1;
+    }
+
+    std::vector<AtlasImage> images;
+    for (size_t d = 1; d < positional.size(); d++) {
+        fs::path dir = positional[d];
+        if (!fs::is_directory(dir)) {
+            std::cerr << "t2datlaspack: " << dir.string() << " is not a directory" << std::endl;
+            return 1;
+        }
+        std::vector<fs::path> files;
+        for (const auto& entry : fs::directory_iterator(dir)) {
+            if (entry.is_regular_file() && entry.path().extension() == ".png") files.push_back(entry.path());
+        }
+        // stable names and page layout between runs
+        std::sort(files.begin(), files.end());
+        std::string prefix = dir.filename().empty() ? dir.parent_path().filename().string() : dir.filename().string();
+        for (const auto& file : files) {
+            AtlasImage image;
+            int channels = 0;
+            unsigned char* data = stbi_load(file.string().c_str(), &image.width, &image.height, &channels, STBI_rgb_alpha);
+            if (!data) {
+                std::cerr << "t2datlaspack: failed to load " << file.string() << std::endl;
+                return 1;
+            }
+            image.rgba.assign(data, data + static_cast<size_t>(image.width) * image.height * 4);
+            stbi_image_free(data);
+            image.name = prefix + "/" + file.stem().string();
+            images.push_back(std::move(image));
+        }
+    }
+
+    AtlasManifest manifest = buildAtlas(images, options);
+    fs::path base = positional[0];
+    if (base.has_parent_path()) fs::create_directories(base.parent_path());
+    for (size_t i = 0; i < manifest.pages.size(); i++) {
+        AtlasPage& page = manifest.pages[i];
+        fs::path file = base.string() + "_" + std::to_string(i) + ".png";
+        page.file = file.filename().string();
+        if (!stbi_write_png(file.string().c_str(), page.width, page.height, 4, page.rgba.data(), page.width * 4)) {
+            std::cerr << "t2datlaspack: failed to write " << file.string() << std::endl;
+            return 1;
+        }
+        std::cout << page.file << " " << page.width << "x" << page.height << std::endl;
+    }
+    if (!manifest.save(base.string() + ".t2da")) {
+        std::cerr << "t2datlaspack: failed to write " << base.string() << ".t2da" << std::endl;
+        return 1;
+    }
+    std::cout << manifest.sprites.size() << " sprites of " << images.size() << " images on " << manifest.pages.size()
+              << " pages" << std::endl;
+    return manifest.sprites.size() == images.size() ? 0 : 1;
+}
@@ -0,0 +1,50 @@
+#define NOMINMAX
+#define STB_IMAGE_IMPLEMENTATION
+#include "enginetexture.h"
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// t2dtexconv <input image> <output .otex> [--no-mips] [--lz4] [--no-flip]
+// bakes decode, flip and the mip chain offline so runtime loads are a map plus an upload
+int main(int argc, char** argv) {
+    EngineTextureOptions format;
+    TextureLoadOptions options;
+    std::vector<std::string> positional;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--no-mips") format.mipmaps = false;
+        else if (arg == "--lz4") format.lz4 = true;
+        else if (arg == "--no-flip") options.flipVertically = false;
+        else positional.push_back(arg);
+    }
+    if (positional.size() != 2) {
+        std::cerr << "usage: t2dtexconv <input image> <output .otex> [--no-mips] [--lz4] [--no-flip]" << std::endl;
+        return 1;
+    }
+
+    MappedFile source(positional[0]);
+    TexturePixels pixels = Texture::decode(positional[0], options);
+    if (!source.isOpen() || !pixels) {
+        std::cerr << "t2dtexconv: failed to load " << positional[0] << std::endl;
+        return 1;
+    }
+    uint64_t hash = fnv1a64(source.data(), source.size());
+    std::vector<uint8_t> file = encodeEngineTexture(pixels.data.get(), pixels.width, pixels.height, format, hash);
+
+    std::filesystem::path out = positional[1];
+    if (out.has_parent_path()) std::filesystem::create_directories(out.parent_path());
+    std::ofstream stream(out, std::ios::binary);
+    stream.write(reinterpret_cast<const char*>(file.data()), file.size());
+    if (!stream) {
+        std::cerr << "t2dtexconv: failed to write " << out.string() << std::endl;
+        return 1;
+    }
+    EngineTextureView view;
+    view.parse(file.data(), file.size());
+    std::cout << out.filename().string() << " " << pixels.width << "x" << pixels.height << ", " << view.levels.size()
+              << " levels, " << file.size() << " bytes" << std::endl;
+    return 0;
+}
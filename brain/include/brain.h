@@ -4,14 +4,24 @@
 
 #include "BoltID.h"
 #include "boltlog.h"
+#include "brainpack.h"
+#include "mappedfile.h"
 #include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <deque>
 #include <functional>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <span>
 #include <stdexcept>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <unordered_map>
-#include <any>
+#include <utility>
 #include <fstream>
 #include <iostream>
 #include <token_utils.h>
@@ -22,117 +32,406 @@ namespace brain{
     namespace core
     {
     
-        struct ResourceMetadataBase {
-            std::string dataname;
-            virtual void format() = 0;
-            virtual ~ResourceMetadataBase() = default;
-        };
-        
-        template<typename T>
-        struct ResourceMetadata : ResourceMetadataBase {
-            T data{};
-            void format() override {}
+        //! process wide key table, a name becomes a small index once and lookups after that never compare strings
+        class MetadataKey {
+            struct Registry {
+                std::shared_mutex mutex;
+                std::unordered_map<std::string, uint32_t> indices;
+                std::deque<std::string> names;
+            };
+            static Registry& registry() {
+                static Registry instance;
+                return instance;
+            }
+
+            public:
+            static constexpr uint32_t NONE = UINT32_MAX;
+            uint32_t index = NONE;
+
+            MetadataKey() = default;
+            MetadataKey(const std::string& name) : index(intern(name)) {}
+            MetadataKey(const char* name) : index(intern(name)) {}
+
+            static uint32_t intern(const std::string& name) {
+                Registry& r = registry();
+                {
+                    std::shared_lock<std::shared_mutex> lock(r.mutex);
+                    auto it = r.indices.find(name);
+                    if (it != r.indices.end()) return it->second;
+                }
+                std::unique_lock<std::shared_mutex> lock(r.mutex);
+                auto it = r.indices.find(name);
+                if (it != r.indices.end()) return it->second;
+                if (r.names.size() >= NONE) throw std::runtime_error("Too many metadata keys: " + name);
+                uint32_t index = static_cast<uint32_t>(r.names.size());
+                r.names.push_back(name);
+                r.indices.emplace(name, index);
+                return index;
+            }
+
+            const std::string& name() const {
+                Registry& r = registry();
+                std::shared_lock<std::shared_mutex> lock(r.mutex);
+                return r.names.at(index);
+            }
+            bool valid() const { return index != NONE; }
+            bool operator==(const MetadataKey& other) const { return index == other.index; }
         };
 
-        struct BoolResourceMetadata:ResourceMetadata<std::atomic_bool>{
-            BoolResourceMetadata(const std::string& dataname,const bool& starter){
-                data.store(starter);
-                this->dataname = dataname;
+        enum class MetadataType : uint8_t { NONE, BOOL, INT, FLOAT, STRING };
+
+        template<typename T> struct MetadataTraits;
+        template<> struct MetadataTraits<bool> {
+            static constexpr MetadataType type = MetadataType::BOOL;
+            static uint32_t pack(bool v) { return v; }
+            static bool unpack(uint32_t v) { return v != 0; }
+        };
+        template<> struct MetadataTraits<int> {
+            static constexpr MetadataType type = MetadataType::INT;
+            static uint32_t pack(int v) { return static_cast<uint32_t>(v); }
+            static int unpack(uint32_t v) { return static_cast<int32_t>(v); }
+        };
+        template<> struct MetadataTraits<float> {
+            static constexpr MetadataType type = MetadataType::FLOAT;
+            static uint32_t pack(float v) {
+                uint32_t bits;
+                std::memcpy(&bits, &v, sizeof(bits));
+                return bits;
+            }
+            static float unpack(uint32_t v) {
+                float f;
+                std::memcpy(&f, &v, sizeof(f));
+                return f;
             }
-            void format() override{};
         };
-        struct StringResourceMetadata:ResourceMetadata<std::string>{
-            StringResourceMetadata(const std::string& dataname,const std::string& starter){
-                data = starter;
-                this->dataname = dataname;
+        template<> struct MetadataTraits<std::string> {
+            static constexpr MetadataType type = MetadataType::STRING;
+        };
+
+        //! one key and its tagged value in 16 bytes. the type sits in the low 3 bits of value,
+        //! scalars above it and strings as a pointer to an immutable heap copy
+        struct MetadataSlot {
+            static constexpr uint64_t TYPE_MASK = 7;
+            std::atomic<uint32_t> key = MetadataKey::NONE;
+            std::atomic<uint64_t> value = 0;
+
+            MetadataType type() const { return static_cast<MetadataType>(value.load(std::memory_order_acquire) & TYPE_MASK); }
+            static const std::string* text(uint64_t word) {
+                return static_cast<MetadataType>(word & TYPE_MASK) == MetadataType::STRING
+                    ? reinterpret_cast<const std::string*>(word & ~TYPE_MASK) : nullptr;
+            }
+
+            //! debug builds only, release trusts the caller's type
+            template<typename T>
+            void check(const MetadataKey& key) const {
+#ifndef NDEBUG
+                if (type() != MetadataTraits<T>::type)
+                    throw std::runtime_error("Metadata has a different type: " + key.name());
+#else
+                (void)key;
+#endif
             }
-            void format() override{};
         };
-        struct IntResourceMetadata:ResourceMetadata<std::atomic_int>{
-            IntResourceMetadata(const std::string& dataname,const int& starter){
-                data.store(starter);
-                this->dataname = dataname;
+
+        class ResourceMetadataStore;
+
+        //! a bound slot, a per frame scalar read through it is one load
+        template<typename T>
+        struct MetadataRef {
+            ResourceMetadataStore* store = nullptr;
+            MetadataSlot* slot = nullptr;
+            MetadataKey key;
+
+            T get() const;
+            void set(const T& value);
+            explicit operator bool() const { return slot != nullptr; }
+        };
+
+        //! typed properties by interned key, kept in a chain of small open addressed tables per resource.
+        //! a full table gets a twice as large one in front of it, slots never move and readers take no lock.
+        //! string reads count themselves in readers, a replaced string is freed by the first write that
+        //! sees no read in flight, or by clear
+        class ResourceMetadataStore {
+            struct Table {
+                Table* next;
+                uint32_t mask;
+                uint32_t used = 0;
+                std::unique_ptr<MetadataSlot[]> slots;
+                Table(uint32_t capacity, Table* next) : next(next), mask(capacity - 1), slots(new MetadataSlot[capacity]) {}
+            };
+            static constexpr uint32_t FIRST_CAPACITY = 4;
+
+            std::atomic<Table*> tables = nullptr;
+            mutable std::atomic<uint32_t> readers = 0;
+            std::mutex writeMutex;
+            std::vector<const std::string*> retired;
+
+            MetadataSlot* find(const MetadataKey& key) const {
+                if (!key.valid()) return nullptr;
+                for (Table* table = tables.load(std::memory_order_acquire); table; table = table->next) {
+                    for (uint32_t i = key.index & table->mask;; i = (i + 1) & table->mask) {
+                        uint32_t k = table->slots[i].key.load(std::memory_order_acquire);
+                        if (k == key.index) return &table->slots[i];
+                        if (k == MetadataKey::NONE) break;
+                    }
+                }
+                return nullptr;
+            }
+
+            //! caller holds writeMutex
+            MetadataSlot& slotFor(const MetadataKey& key) {
+                if (!key.valid()) throw std::runtime_error("Invalid metadata key");
+                if (MetadataSlot* slot = find(key)) return *slot;
+                Table* table = tables.load(std::memory_order_relaxed);
+                if (!table || (table->used + 1) * 4 > (table->mask + 1) * 3) {
+                    table = new Table(table ? (table->mask + 1) * 2 : FIRST_CAPACITY, table);
+                    tables.store(table, std::memory_order_release);
+                }
+                uint32_t i = key.index & table->mask;
+                while (table->slots[i].key.load(std::memory_order_relaxed) != MetadataKey::NONE) i = (i + 1) & table->mask;
+                table->used++;
+                return table->slots[i];
+            }
+
+            //! caller holds writeMutex, key is published last so a reader never sees a slot without a value
+            void store(MetadataSlot& slot, uint32_t key, uint64_t word) {
+                uint64_t old = slot.value.exchange(word, std::memory_order_seq_cst);
+                if (slot.key.load(std::memory_order_relaxed) != key) slot.key.store(key, std::memory_order_release);
+                if (const std::string* text = MetadataSlot::text(old)) retired.push_back(text);
+                if (!retired.empty() && readers.load(std::memory_order_seq_cst) == 0) {
+                    for (const std::string* text : retired) delete text;
+                    retired.clear();
+                }
+            }
+
+            template<typename T>
+            static uint64_t pack(const T& value) {
+                if constexpr (std::is_same_v<T, std::string>) {
+                    return reinterpret_cast<uint64_t>(new std::string(value)) | static_cast<uint64_t>(MetadataType::STRING);
+                } else {
+                    return (static_cast<uint64_t>(MetadataTraits<T>::pack(value)) << 32) | static_cast<uint64_t>(MetadataTraits<T>::type);
+                }
+            }
+
+            public:
+            ResourceMetadataStore() = default;
+            ResourceMetadataStore(const ResourceMetadataStore& other) { *this = other; }
+            ResourceMetadataStore& operator=(const ResourceMetadataStore& other) {
+                if (this == &other) return *this;
+                clear();
+                std::scoped_lock lock(writeMutex, const_cast<std::mutex&>(other.writeMutex));
+                std::vector<Table*> chain;
+                for (Table* table = other.tables.load(std::memory_order_acquire); table; table = table->next) chain.push_back(table);
+                // oldest first, so a key lands in the same kind of table it had
+                for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+                    for (uint32_t i = 0; i <= (*it)->mask; i++) {
+                        const MetadataSlot& source = (*it)->slots[i];
+                        uint32_t key = source.key.load(std::memory_order_acquire);
+                        if (key == MetadataKey::NONE) continue;
+                        uint64_t word = source.value.load(std::memory_order_acquire);
+                        if (const std::string* text = MetadataSlot::text(word)) word = pack(*text);
+                        MetadataKey k;
+                        k.index = key;
+                        store(slotFor(k), key, word);
+                    }
+                }
+                return *this;
+            }
+            ~ResourceMetadataStore() { clear(); }
+
+            //! not safe against concurrent readers, refs taken before are dangling after
+            void clear() {
+                std::lock_guard<std::mutex> lock(writeMutex);
+                Table* table = tables.exchange(nullptr);
+                while (table) {
+                    for (uint32_t i = 0; i <= table->mask; i++) delete MetadataSlot::text(table->slots[i].value.load());
+                    Table* next = table->next;
+                    delete table;
+                    table = next;
+                }
+                for (const std::string* text : retired) delete text;
+                retired.clear();
+            }
+
+            template<typename T>
+            MetadataRef<T> set(const MetadataKey& key, const T& value) {
+                std::lock_guard<std::mutex> lock(writeMutex);
+                MetadataSlot& slot = slotFor(key);
+                store(slot, key.index, pack(value));
+                return {this, &slot, key};
+            }
+
+            //! writes through a slot this store handed out
+            template<typename T>
+            void write(MetadataSlot& slot, const T& value) {
+                std::lock_guard<std::mutex> lock(writeMutex);
+                store(slot, slot.key.load(std::memory_order_relaxed), pack(value));
+            }
+
+            template<typename T>
+            T read(const MetadataSlot& slot) const {
+                if constexpr (std::is_same_v<T, std::string>) {
+                    readers.fetch_add(1, std::memory_order_seq_cst);
+                    const std::string* text = MetadataSlot::text(slot.value.load(std::memory_order_seq_cst));
+                    std::string value = text ? *text : std::string();
+                    readers.fetch_sub(1, std::memory_order_release);
+                    return value;
+                } else {
+                    return MetadataTraits<T>::unpack(static_cast<uint32_t>(slot.value.load(std::memory_order_acquire) >> 32));
+                }
+            }
+
+            //! throws when the key was never set, a wrong type only throws in debug builds
+            template<typename T>
+            T get(const MetadataKey& key) const {
+                MetadataSlot* slot = find(key);
+                if (!slot) throw std::runtime_error("Metadata not found: " + (key.valid() ? key.name() : std::string("<invalid>")));
+                slot->check<T>(key);
+                return read<T>(*slot);
+            }
+
+            //! binds a slot for repeated reads, unset keys start at fallback
+            template<typename T>
+            MetadataRef<T> ref(const MetadataKey& key, const T& fallback = T{}) {
+                MetadataSlot* slot = find(key);
+                if (slot) return {this, slot, key};
+                return set(key, fallback);
+            }
+
+            bool has(const MetadataKey& key) const { return find(key) != nullptr; }
+            MetadataType typeOf(const MetadataKey& key) const {
+                MetadataSlot* slot = find(key);
+                return slot ? slot->type() : MetadataType::NONE;
             }
-            void format() override{};
         };
-        
-        
-    
+
+        template<typename T>
+        T MetadataRef<T>::get() const {
+            slot->check<T>(key);
+            return store->read<T>(*slot);
+        }
+        template<typename T>
+        void MetadataRef<T>::set(const T& value) { store->write(*slot, value); }
+
         struct ResourceID{
             std::string basic_id;
             BoltID backend;
         };
     
+        //! one address per signature, lets a bind check types without RTTI
+        template<typename Signature>
+        const void* methodSignature() {
+            static const char tag = 0;
+            return &tag;
+        }
+
+        struct MethodSlotBase {
+            const void* signature = nullptr;
+            virtual std::unique_ptr<MethodSlotBase> clone() const = 0;
+            virtual ~MethodSlotBase() = default;
+        };
+
+        template<typename Signature> struct MethodSlot;
+        template<typename Ret, typename... Args>
+        struct MethodSlot<Ret(Args...)> : MethodSlotBase {
+            std::function<Ret(Args...)> fn;
+            explicit MethodSlot(std::function<Ret(Args...)> fn) : fn(std::move(fn)) {
+                signature = methodSignature<Ret(Args...)>();
+            }
+            std::unique_ptr<MethodSlotBase> clone() const override { return std::make_unique<MethodSlot>(fn); }
+        };
+
+        //! a method resolved once by name, calling it is a direct std::function call with no boxing
+        template<typename Signature> struct MethodHandle;
+        template<typename Ret, typename... Args>
+        struct MethodHandle<Ret(Args...)> {
+            MethodSlot<Ret(Args...)>* slot = nullptr;
+
+            Ret operator()(Args... args) const { return slot->fn(std::forward<Args>(args)...); }
+            explicit operator bool() const { return slot != nullptr; }
+        };
+
         struct ResourceType {
-            std::unordered_map<std::string, std::function<std::any(std::any)>> methods;
-        
+            //! slots are heap nodes so handles survive later definitions
+            std::unordered_map<std::string, std::unique_ptr<MethodSlotBase>> methods;
+
+            ResourceType() = default;
+            ResourceType(ResourceType&&) = default;
+            ResourceType& operator=(ResourceType&&) = default;
+            //! copies get their own slots, handles bound on the source keep calling the source
+            ResourceType(const ResourceType& other) { *this = other; }
+            ResourceType& operator=(const ResourceType& other) {
+                if (this == &other) return *this;
+                methods.clear();
+                for (const auto& [name, slot] : other.methods) methods.emplace(name, slot->clone());
+                return *this;
+            }
+
+            //! redefining with the same signature swaps the callable under existing handles
+            template<typename Signature, typename Fn>
+            MethodHandle<Signature> define(const std::string& name, Fn&& fn) {
+                auto it = methods.find(name);
+                if (it == methods.end()) {
+                    it = methods.emplace(name, std::make_unique<MethodSlot<Signature>>(std::forward<Fn>(fn))).first;
+                } else if (it->second->signature == methodSignature<Signature>()) {
+                    static_cast<MethodSlot<Signature>*>(it->second.get())->fn = std::forward<Fn>(fn);
+                } else {
+                    throw std::runtime_error("Method redefined with another signature: " + name);
+                }
+                return {static_cast<MethodSlot<Signature>*>(it->second.get())};
+            }
+
+            template<typename Signature>
+            MethodHandle<Signature> bind(const std::string& name) const {
+                auto it = methods.find(name);
+                if (it == methods.end()) throw std::runtime_error("Method not found: " + name);
+                if (it->second->signature != methodSignature<Signature>()) throw std::runtime_error("Method signature mismatch: " + name);
+                return {static_cast<MethodSlot<Signature>*>(it->second.get())};
+            }
+
+            bool has(const std::string& name) const { return methods.find(name) != methods.end(); }
+
             template<typename Ret, typename Arg>
             void setMethod(const std::string& name, std::function<Ret(Arg)> fn) {
-                methods[name] = [fn](std::any arg) -> std::any {
-                    return fn(std::any_cast<Arg>(arg));
-                };
+                define<Ret(Arg)>(name, std::move(fn));
             }
-        
+
+            //! one lookup per call, per frame callers should keep the bind() handle
             template<typename Ret, typename Arg>
             Ret call(const std::string& name, Arg arg) {
-                auto it = methods.find(name);
-                if (it != methods.end()) {
-                    return std::any_cast<Ret>(it->second(arg));
-                }
-                throw std::runtime_error("Method not found");
+                return bind<Ret(Arg)>(name)(std::move(arg));
             }
         };
     
         class resource{
             public:
-            std::map<std::string, std::shared_ptr<ResourceMetadataBase>> data;
+            ResourceMetadataStore data;
             ResourceID id;
             ResourceType type;
 
             ~resource(){
             }
 
-            std::shared_ptr<BoolResourceMetadata> set_bool_data(const std::string& key,bool& val){
-                auto ptr = std::make_shared<BoolResourceMetadata>(key,val);
-                this->data[key] = ptr;
-                return ptr;
+            MetadataRef<bool> set_bool_data(const MetadataKey& key,const bool& val){
+                return data.set(key,val);
             }
-            std::shared_ptr<StringResourceMetadata> set_str_data(const std::string& key,std::string& val){
-                auto ptr = std::make_shared<StringResourceMetadata>(key,val);
-                this->data[key] = ptr;
-                return ptr;
+            MetadataRef<std::string> set_str_data(const MetadataKey& key,const std::string& val){
+                return data.set(key,val);
             }
-            std::shared_ptr<IntResourceMetadata> set_int_data(const std::string& key,int& val){
-                auto ptr = std::make_shared<IntResourceMetadata>(key,val);
-                this->data[key] = ptr;
-                return ptr;
+            MetadataRef<int> set_int_data(const MetadataKey& key,const int& val){
+                return data.set(key,val);
             }
 
-            bool get_bool_data(const std::string& key) {
-                auto it = data.find(key);
-                if (it != data.end()) {
-                    auto ptr = std::dynamic_pointer_cast<BoolResourceMetadata>(it->second);
-                    if (ptr) return ptr->data;
-                }
-                throw std::runtime_error("Bool metadata not found or wrong type: " + key);
+            bool get_bool_data(const MetadataKey& key) const {
+                return data.get<bool>(key);
             }
         
-            std::string get_str_data(const std::string& key) {
-                auto it = data.find(key);
-                if (it != data.end()) {
-                    auto ptr = std::dynamic_pointer_cast<StringResourceMetadata>(it->second);
-                    if (ptr) return ptr->data;
-                }
-                throw std::runtime_error("String metadata not found or wrong type: " + key);
+            std::string get_str_data(const MetadataKey& key) const {
+                return data.get<std::string>(key);
             }
         
-            int get_int_data(const std::string& key) {
-                auto it = data.find(key);
-                if (it != data.end()) {
-                    auto ptr = std::dynamic_pointer_cast<IntResourceMetadata>(it->second);
-                    if (ptr) return ptr->data;
-                }
-                throw std::runtime_error("Int metadata not found or wrong type: " + key);
+            int get_int_data(const MetadataKey& key) const {
+                return data.get<int>(key);
             }
         };
     }//core
@@ -140,44 +439,96 @@ namespace brain{
     
     class file_resource:public core::resource{
 
-        BL::FileSink fsink;
+        //! holder shared by every copy, the sink inside is created on the first write so listing thousands of
+        //! files never opens one
+        std::shared_ptr<std::unique_ptr<BL::FileSink>> fsink;
+        //! holder shared by every copy, they reuse one mapping or archive entry and a flush through any of
+        //! them drops it for all
+        std::shared_ptr<PackData> content;
+
+        BL::FileSink& sink(){
+            if(!*fsink){
+                *fsink = std::make_unique<BL::FileSink>(id.basic_id,50,10000,"",true);
+                (*fsink)->enable_rotate = false;
+            }
+            return **fsink;
+        }
 
         public:
-        file_resource(std::string filePath):fsink(filePath,50,10000,"",true){
+        file_resource(std::string filePath)
+            :fsink(std::make_shared<std::unique_ptr<BL::FileSink>>()),content(std::make_shared<PackData>()){
           id.basic_id = filePath;
           id.backend = BoltID::randomBoltID(1);
-          fsink.enable_rotate = false;
         };
 
         bool write(const std::string& _msg){
-            fsink<<_msg;
+            sink()<<_msg;
             return true;
         }
         void flush(){
-            fsink<<FSINK;
+            sink()<<FSINK;
+            unmap();
+        }
+
+        //! the real path first so writes are seen, then mounted archives and directories,
+        //! the view stays valid until unmap() or a flush on any copy
+        std::string_view view(){
+            PackData& data = *content;
+            if(!data){
+                if(std::filesystem::is_regular_file(id.basic_id)) data = PackData::map(id.basic_id);
+                if(!data) data = vfs().read(id.basic_id);
+            }
+            return data.view;
+        }
+        std::span<const char> bytes(){
+            std::string_view v = view();
+            return {v.data(), v.size()};
+        }
+        bool mapped() const { return static_cast<bool>(*content); }
+        void unmap(){
+            *content = {};
+        }
+        bool exists() const {
+            return vfs().exists(id.basic_id) || std::filesystem::exists(id.basic_id);
         }
 
         CharStream<char> setup(){
-            std::ifstream ifs(id.basic_id);
-            if (!ifs) return CharStream<char>{{}};
-            auto read = std::string((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
-            CharUtils::CharStream<char> stream = CharUtils::Default_char_import(read);
+            if (!exists()) return CharStream<char>{{}};
+            std::string_view data = view();
+            if (!*content) return CharStream<char>{{}};
+            CharUtils::CharStream<char> stream = CharUtils::Default_char_import(std::string(data));
             return stream;
         }
         bool deleteFile(){
-            fsink.closeStream();
+            if(*fsink) (*fsink)->closeStream();
+            unmap();
             return std::remove(id.basic_id.c_str())==0;
         }
         void openFile(const char* mode){
-            fsink.open(mode);
+            unmap();
+            sink().open(mode);
         }
         void closeFile(){
-            fsink.closeStream();
+            if(*fsink) (*fsink)->closeStream();
         }
     };
     class directory_resource : public core::resource {
         std::vector<directory_resource> __subs, __sups;
         std::vector<file_resource> __subfiles;
+        //! file name -> index in __subs / __subfiles
+        std::unordered_map<std::string, size_t> __subIndex, __fileIndex;
+
+        static std::string leaf(const std::string& path){
+            return std::filesystem::path(path).filename().string();
+        }
+        void indexSubs(){
+            __subIndex.clear();
+            for (size_t i = 0; i < __subs.size(); i++) __subIndex.emplace(leaf(__subs[i].id.basic_id), i);
+        }
+        void indexFiles(){
+            __fileIndex.clear();
+            for (size_t i = 0; i < __subfiles.size(); i++) __fileIndex.emplace(leaf(__subfiles[i].id.basic_id), i);
+        }
     
     public:
         directory_resource(const std::string& dirPath) {
@@ -189,18 +540,25 @@ namespace brain{
             std::filesystem::create_directory(id.basic_id);
         }
 
+        //! the real directory merged with whatever vfs() mounts over it
         void setupFiles() {
             namespace fs = std::filesystem;
         
             if(!__subfiles.empty()) __subfiles.clear();
         
-            if (!fs::exists(id.basic_id)) return;
-        
-            for (const auto& entry : fs::directory_iterator(id.basic_id)) {
-                if (entry.is_regular_file()) {
-                    __subfiles.push_back(file_resource(entry.path().string()));
+            if (fs::exists(id.basic_id)) {
+                for (const auto& entry : fs::directory_iterator(id.basic_id)) {
+                    if (entry.is_regular_file()) {
+                        __subfiles.push_back(file_resource(entry.path().string()));
+                    }
                 }
             }
+            indexFiles();
+            for (const auto& name : vfs().listFiles(id.basic_id)) {
+                if (__fileIndex.count(name)) continue;
+                __fileIndex.emplace(name, __subfiles.size());
+                __subfiles.push_back(file_resource((fs::path(id.basic_id) / name).string()));
+            }
         }
         void setup() {
 
@@ -209,20 +567,26 @@ namespace brain{
 
             namespace fs = std::filesystem;
     
-            if (!fs::exists(id.basic_id)) return;
-    
             fs::path path(id.basic_id);
             fs::path parent = path.parent_path();
     
-            if (!parent.empty() && fs::exists(parent)) {
+            if (!parent.empty() && (fs::exists(parent) || vfs().exists(parent.string()))) {
                 __sups.push_back(directory_resource(parent.string()));
             }
     
-            for (const auto& entry : fs::directory_iterator(id.basic_id)) {
-                if (entry.is_directory()) {
-                    __subs.push_back(directory_resource(entry.path().string()));
+            if (fs::exists(id.basic_id)) {
+                for (const auto& entry : fs::directory_iterator(id.basic_id)) {
+                    if (entry.is_directory()) {
+                        __subs.push_back(directory_resource(entry.path().string()));
+                    }
                 }
             }
+            indexSubs();
+            for (const auto& name : vfs().listDirectories(id.basic_id)) {
+                if (__subIndex.count(name)) continue;
+                __subIndex.emplace(name, __subs.size());
+                __subs.push_back(directory_resource((path / name).string()));
+            }
 
             setupFiles();
         }
@@ -232,27 +596,25 @@ namespace brain{
             std::filesystem::create_directory(path);
             auto realdir = directory_resource(path.string());
             __subs.push_back(realdir);
+            indexSubs();
             return __subs.back();
         };
         file_resource& mkfile(const std::string& name){
             std::filesystem::path path =std::filesystem::path(id.basic_id) / name;
             file_resource fres {path.string()};
             __subfiles.push_back(fres);
+            indexFiles();
             return __subfiles.back();
         };
 
         directory_resource sub(const std::string& name) {
-            for (auto& d : __subs) {
-                if (std::filesystem::path(d.id.basic_id).filename() == name)
-                    return d;
-            }
+            auto it = __subIndex.find(name);
+            if (it != __subIndex.end()) return __subs[it->second];
             return directory_resource((std::filesystem::path(id.basic_id) / name).string());
         }
         file_resource subfile(const std::string& name) {
-            for (auto& d : __subfiles) {
-                if (std::filesystem::path(d.id.basic_id).filename() == name)
-                    return d;
-            }
+            auto it = __fileIndex.find(name);
+            if (it != __fileIndex.end()) return __subfiles[it->second];
             return file_resource((std::filesystem::path(id.basic_id) / name).string());
         }
     
@@ -267,19 +629,15 @@ namespace brain{
         std::vector<directory_resource> subs(const std::string& name = "") {
             if (name.empty()) return __subs;
             std::vector<directory_resource> filtered;
-            for (auto& d : __subs) {
-                if (std::filesystem::path(d.id.basic_id).filename() == name)
-                    filtered.push_back(d);
-            }
+            auto it = __subIndex.find(name);
+            if (it != __subIndex.end()) filtered.push_back(__subs[it->second]);
             return filtered;
         }
         std::vector<file_resource> subfiles(const std::string& name = "") {
             if (name.empty()) return __subfiles;
             std::vector<file_resource> filtered;
-            for (auto& d : __subfiles) {
-                if (std::filesystem::path(d.id.basic_id).filename() == name)
-                    filtered.push_back(d);
-            }
+            auto it = __fileIndex.find(name);
+            if (it != __fileIndex.end()) filtered.push_back(__subfiles[it->second]);
             return filtered;
         }
 
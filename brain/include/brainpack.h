@@ -0,0 +1,423 @@
+#ifndef BRAINPACK_H
+#define BRAINPACK_H
+
+#include "lz4block.h"
+#include "mappedfile.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace brain{
+
+    //! bytes of one file, from a mapping or a decompressed buffer that keepAlive holds
+    struct PackData {
+        std::string_view view;
+        std::shared_ptr<const void> keepAlive;
+
+        explicit operator bool() const { return keepAlive != nullptr; }
+
+        static PackData map(const std::string& path){
+            auto mapped = std::make_shared<MappedFile>();
+            if (!mapped->open(path)) return {};
+            return {{reinterpret_cast<const char*>(mapped->data()), mapped->size()}, mapped};
+        }
+    };
+
+    //! generic, lexically normal and without a leading "./" or trailing '/', the form pack names and mounts use
+    inline std::string normalizePackPath(const std::string& path){
+        std::string normal = std::filesystem::path(path).lexically_normal().generic_string();
+        while (normal.size() > 1 && normal.back() == '/') normal.pop_back();
+        if (normal == ".") return "";
+        if (normal.rfind("./", 0) == 0) normal.erase(0, 2);
+        return normal;
+    }
+
+    inline uint64_t packHash(std::string_view name){
+        return fnv1a64(reinterpret_cast<const uint8_t*>(name.data()), name.size());
+    }
+
+    //! .opak, header | aligned entry data | entry table | hash buckets | names
+    struct PackHeader {
+        static constexpr uint32_t MAGIC = 0x4B41504F;  // "OPAK"
+        static constexpr uint16_t VERSION = 1;
+
+        uint32_t magic = MAGIC;
+        uint16_t version = VERSION;
+        uint16_t flags = 0;
+        uint32_t entryCount = 0;
+        uint32_t bucketCount = 0;
+        uint64_t entriesOffset = 0;
+        uint64_t bucketsOffset = 0;
+        uint64_t namesOffset = 0;
+        uint64_t namesSize = 0;
+    };
+    static_assert(sizeof(PackHeader) == 48, "PackHeader is written as is");
+
+    struct PackEntry {
+        static constexpr uint32_t FLAG_LZ4 = 1;
+
+        uint64_t hash = 0;
+        uint64_t offset = 0;
+        uint64_t storedSize = 0;
+        uint64_t rawSize = 0;
+        uint32_t nameOffset = 0;
+        uint32_t nameLength = 0;
+        uint32_t flags = 0;
+        uint32_t reserved = 0;
+    };
+    static_assert(sizeof(PackEntry) == 48, "PackEntry is written as is");
+
+    struct PackWriteOptions {
+        //! entry data starts on this boundary, a power of two
+        uint32_t alignment = 16;
+        bool compress = false;
+        //! compressed entries are kept only below this fraction of the raw size
+        float minSaving = 0.9f;
+    };
+
+    class PackWriter {
+        struct Pending {
+            std::string name;
+            std::vector<uint8_t> bytes;
+            bool compress;
+        };
+        std::vector<Pending> pending;
+
+        public:
+        PackWriteOptions options;
+
+        explicit PackWriter(PackWriteOptions options = {}) : options(options) {}
+
+        void add(const std::string& name, std::vector<uint8_t> bytes){
+            add(name, std::move(bytes), options.compress);
+        }
+        void add(const std::string& name, std::vector<uint8_t> bytes, bool compress){
+            pending.push_back({normalizePackPath(name), std::move(bytes), compress});
+        }
+
+        //! every regular file under root, named relative to it
+        size_t addDirectory(const std::string& root){
+            namespace fs = std::filesystem;
+            size_t added = 0;
+            std::error_code error;
+            for (const auto& entry : fs::recursive_directory_iterator(root, error)) {
+                if (!entry.is_regular_file()) continue;
+                std::ifstream in(entry.path(), std::ios::binary);
+                std::vector<uint8_t> bytes(static_cast<size_t>(entry.file_size()));
+                in.read(reinterpret_cast<char*>(bytes.data()), bytes.size());
+                add(fs::relative(entry.path(), root).generic_string(), std::move(bytes));
+                added++;
+            }
+            return added;
+        }
+
+        size_t size() const { return pending.size(); }
+
+        std::vector<uint8_t> build() const {
+            uint64_t align = options.alignment == 0 ? 1 : options.alignment;
+            auto alignUp = [align](uint64_t v){ return (v + align - 1) / align * align; };
+
+            std::vector<uint8_t> file(sizeof(PackHeader), 0);
+            std::vector<PackEntry> entries;
+            std::string names;
+            for (const auto& item : pending) {
+                PackEntry entry;
+                entry.hash = packHash(item.name);
+                entry.rawSize = item.bytes.size();
+                entry.nameOffset = static_cast<uint32_t>(names.size());
+                entry.nameLength = static_cast<uint32_t>(item.name.size());
+                names += item.name;
+
+                std::vector<uint8_t> packed;
+                if (item.compress && !item.bytes.empty()) {
+                    packed = lz4::compress(item.bytes.data(), item.bytes.size());
+                    if (packed.size() < item.bytes.size() * options.minSaving) entry.flags |= PackEntry::FLAG_LZ4;
+                }
+                const std::vector<uint8_t>& stored = (entry.flags & PackEntry::FLAG_LZ4) ? packed : item.bytes;
+                entry.offset = alignUp(file.size());
+                entry.storedSize = stored.size();
+                file.resize(entry.offset);
+                file.insert(file.end(), stored.begin(), stored.end());
+                entries.push_back(entry);
+            }
+
+            // open addressing at most half full, probes stay short
+            uint32_t bucketCount = 1;
+            while (bucketCount < entries.size() * 2) bucketCount <<= 1;
+            std::vector<uint32_t> buckets(bucketCount, UINT32_MAX);
+            for (uint32_t i = 0; i < entries.size(); i++) {
+                size_t b = entries[i].hash & (bucketCount - 1);
+                while (buckets[b] != UINT32_MAX) b = (b + 1) & (bucketCount - 1);
+                buckets[b] = i;
+            }
+
+            PackHeader header;
+            header.entryCount = static_cast<uint32_t>(entries.size());
+            header.bucketCount = bucketCount;
+            header.entriesOffset = (file.size() + 15) & ~uint64_t(15);
+            header.bucketsOffset = header.entriesOffset + entries.size() * sizeof(PackEntry);
+            header.namesOffset = header.bucketsOffset + buckets.size() * sizeof(uint32_t);
+            header.namesSize = names.size();
+            file.resize(header.namesOffset + names.size());
+            std::memcpy(file.data(), &header, sizeof(header));
+            std::memcpy(file.data() + header.entriesOffset, entries.data(), entries.size() * sizeof(PackEntry));
+            std::memcpy(file.data() + header.bucketsOffset, buckets.data(), buckets.size() * sizeof(uint32_t));
+            std::memcpy(file.data() + header.namesOffset, names.data(), names.size());
+            return file;
+        }
+
+        bool write(const std::string& path) const {
+            std::vector<uint8_t> file = build();
+            std::ofstream out(path, std::ios::binary);
+            out.write(reinterpret_cast<const char*>(file.data()), file.size());
+            if (!out) {
+                std::cerr << "PackWriter: cannot write " << path << std::endl;
+                return false;
+            }
+            return true;
+        }
+    };
+
+    //! a mapped .opak, lookups hash the name once and probe the bucket table
+    class PackArchive {
+        std::shared_ptr<MappedFile> mapping;
+        PackHeader header;
+        const PackEntry* entries = nullptr;
+        const uint32_t* buckets = nullptr;
+        const char* names = nullptr;
+        //! directory -> immediate children, built once at open
+        std::unordered_map<std::string, std::vector<std::string>> files, directories;
+
+        void index(){
+            files.clear();
+            directories.clear();
+            for (uint32_t i = 0; i < header.entryCount; i++) {
+                std::string name(this->name(entries[i]));
+                size_t slash = name.rfind('/');
+                std::string parent = slash == std::string::npos ? "" : name.substr(0, slash);
+                files[parent].push_back(name.substr(slash + 1));
+                while (!parent.empty()) {
+                    slash = parent.rfind('/');
+                    std::string up = slash == std::string::npos ? "" : parent.substr(0, slash);
+                    auto& subs = directories[up];
+                    std::string leaf = parent.substr(slash + 1);
+                    if (std::find(subs.begin(), subs.end(), leaf) != subs.end()) break;
+                    subs.push_back(leaf);
+                    parent = up;
+                }
+            }
+        }
+
+        public:
+        bool open(const std::string& path){
+            auto mapped = std::make_shared<MappedFile>();
+            if (!mapped->open(path)) return false;
+            const uint8_t* data = mapped->data();
+            size_t size = mapped->size();
+            if (size < sizeof(PackHeader)) return false;
+            std::memcpy(&header, data, sizeof(header));
+            if (header.magic != PackHeader::MAGIC || header.version != PackHeader::VERSION ||
+                (header.bucketCount & (header.bucketCount - 1)) != 0 || header.bucketCount <= header.entryCount ||
+                header.entriesOffset % alignof(PackEntry) != 0 || header.namesOffset + header.namesSize > size ||
+                header.bucketsOffset != header.entriesOffset + uint64_t(header.entryCount) * sizeof(PackEntry) ||
+                header.namesOffset != header.bucketsOffset + uint64_t(header.bucketCount) * sizeof(uint32_t)) {
+                std::cerr << "PackArchive: not an opak v" << PackHeader::VERSION << " file: " << path << std::endl;
+                return false;
+            }
+            entries = reinterpret_cast<const PackEntry*>(data + header.entriesOffset);
+            buckets = reinterpret_cast<const uint32_t*>(data + header.bucketsOffset);
+            names = reinterpret_cast<const char*>(data + header.namesOffset);
+            for (uint32_t i = 0; i < header.entryCount; i++) {
+                const PackEntry& e = entries[i];
+                if (e.offset + e.storedSize > header.entriesOffset || uint64_t(e.nameOffset) + e.nameLength > header.namesSize) {
+                    std::cerr << "PackArchive: corrupt entry table: " << path << std::endl;
+                    return false;
+                }
+            }
+            mapping = std::move(mapped);
+            index();
+            return true;
+        }
+
+        bool isOpen() const { return mapping != nullptr; }
+        size_t size() const { return header.entryCount; }
+        std::string_view name(const PackEntry& entry) const { return {names + entry.nameOffset, entry.nameLength}; }
+
+        const PackEntry* find(std::string_view name) const {
+            if (!mapping || header.bucketCount == 0) return nullptr;
+            uint64_t hash = packHash(name);
+            size_t b = hash & (header.bucketCount - 1);
+            for (uint32_t probe = 0; probe < header.bucketCount; probe++, b = (b + 1) & (header.bucketCount - 1)) {
+                uint32_t i = buckets[b];
+                if (i >= header.entryCount) return nullptr;
+                if (entries[i].hash == hash && this->name(entries[i]) == name) return &entries[i];
+            }
+            return nullptr;
+        }
+
+        //! stored entries are views into the mapping, compressed ones decompress into their own buffer
+        PackData read(const PackEntry& entry) const {
+            const char* stored = reinterpret_cast<const char*>(mapping->data()) + entry.offset;
+            if (!(entry.flags & PackEntry::FLAG_LZ4)) return {{stored, entry.storedSize}, mapping};
+            auto buffer = std::make_shared<std::vector<char>>(entry.rawSize);
+            if (!lz4::decompress(reinterpret_cast<const uint8_t*>(stored), entry.storedSize,
+                                 reinterpret_cast<uint8_t*>(buffer->data()), buffer->size())) {
+                std::cerr << "PackArchive: corrupt entry " << name(entry) << std::endl;
+                return {};
+            }
+            return {{buffer->data(), buffer->size()}, buffer};
+        }
+        PackData read(std::string_view name) const {
+            const PackEntry* entry = find(name);
+            return entry ? read(*entry) : PackData{};
+        }
+
+        const std::vector<std::string>& listFiles(const std::string& directory) const {
+            static const std::vector<std::string> none;
+            auto it = files.find(directory);
+            return it == files.end() ? none : it->second;
+        }
+        const std::vector<std::string>& listDirectories(const std::string& directory) const {
+            static const std::vector<std::string> none;
+            auto it = directories.find(directory);
+            return it == directories.end() ? none : it->second;
+        }
+        bool isDirectory(const std::string& directory) const {
+            return files.count(directory) > 0 || directories.count(directory) > 0;
+        }
+    };
+
+    //! archives and loose directories mounted over path prefixes, later mounts win
+    class VirtualFileSystem {
+        struct Mount {
+            std::string point;
+            std::shared_ptr<PackArchive> archive;
+            std::string directory;
+        };
+        std::vector<Mount> mounts;
+        mutable std::shared_mutex mutex;
+
+        //! the part of path under point, false when the mount does not cover it
+        static bool relativeTo(const std::string& path, const std::string& point, std::string& relative){
+            if (point.empty()) {
+                relative = path;
+                return true;
+            }
+            if (path.size() < point.size() || path.compare(0, point.size(), point) != 0) return false;
+            if (path.size() == point.size()) {
+                relative.clear();
+                return true;
+            }
+            if (path[point.size()] != '/') return false;
+            relative = path.substr(point.size() + 1);
+            return true;
+        }
+
+        static void appendUnique(std::vector<std::string>& out, const std::vector<std::string>& names){
+            for (const auto& name : names) {
+                if (std::find(out.begin(), out.end(), name) == out.end()) out.push_back(name);
+            }
+        }
+
+        public:
+        bool mountArchive(const std::string& archivePath, const std::string& mountPoint = ""){
+            auto archive = std::make_shared<PackArchive>();
+            if (!archive->open(archivePath)) return false;
+            std::unique_lock<std::shared_mutex> lock(mutex);
+            mounts.push_back({normalizePackPath(mountPoint), std::move(archive), {}});
+            return true;
+        }
+        bool mountDirectory(const std::string& directory, const std::string& mountPoint = ""){
+            if (!std::filesystem::is_directory(directory)) return false;
+            std::unique_lock<std::shared_mutex> lock(mutex);
+            mounts.push_back({normalizePackPath(mountPoint), nullptr, directory});
+            return true;
+        }
+        void unmount(const std::string& mountPoint){
+            std::string point = normalizePackPath(mountPoint);
+            std::unique_lock<std::shared_mutex> lock(mutex);
+            mounts.erase(std::remove_if(mounts.begin(), mounts.end(), [&](const Mount& m){ return m.point == point; }), mounts.end());
+        }
+        void clear(){
+            std::unique_lock<std::shared_mutex> lock(mutex);
+            mounts.clear();
+        }
+        bool empty() const {
+            std::shared_lock<std::shared_mutex> lock(mutex);
+            return mounts.empty();
+        }
+
+        //! empty when no mount has the file, callers fall back to the real path
+        PackData read(const std::string& path) const {
+            std::shared_lock<std::shared_mutex> lock(mutex);
+            if (mounts.empty()) return {};
+            std::string normal = normalizePackPath(path), relative;
+            for (auto it = mounts.rbegin(); it != mounts.rend(); ++it) {
+                if (!relativeTo(normal, it->point, relative)) continue;
+                if (it->archive) {
+                    if (const PackEntry* entry = it->archive->find(relative)) return it->archive->read(*entry);
+                } else {
+                    std::filesystem::path loose = std::filesystem::path(it->directory) / relative;
+                    std::error_code error;
+                    if (std::filesystem::is_regular_file(loose, error)) return PackData::map(loose.string());
+                }
+            }
+            return {};
+        }
+
+        bool exists(const std::string& path) const {
+            std::shared_lock<std::shared_mutex> lock(mutex);
+            std::string normal = normalizePackPath(path), relative;
+            for (const auto& m : mounts) {
+                if (!relativeTo(normal, m.point, relative)) continue;
+                std::error_code error;
+                if (m.archive ? (m.archive->find(relative) || m.archive->isDirectory(relative))
+                              : std::filesystem::exists(std::filesystem::path(m.directory) / relative, error)) return true;
+            }
+            return false;
+        }
+
+        //! immediate children across every mount covering directory, names only
+        std::vector<std::string> listFiles(const std::string& directory) const { return list(directory, false); }
+        std::vector<std::string> listDirectories(const std::string& directory) const { return list(directory, true); }
+
+        private:
+        std::vector<std::string> list(const std::string& directory, bool directories) const {
+            std::vector<std::string> out;
+            std::shared_lock<std::shared_mutex> lock(mutex);
+            std::string normal = normalizePackPath(directory), relative;
+            for (auto it = mounts.rbegin(); it != mounts.rend(); ++it) {
+                if (!relativeTo(normal, it->point, relative)) continue;
+                if (it->archive) {
+                    appendUnique(out, directories ? it->archive->listDirectories(relative) : it->archive->listFiles(relative));
+                    continue;
+                }
+                std::error_code error;
+                std::vector<std::string> names;
+                for (const auto& entry : std::filesystem::directory_iterator(std::filesystem::path(it->directory) / relative, error)) {
+                    if (directories ? entry.is_directory() : entry.is_regular_file()) names.push_back(entry.path().filename().string());
+                }
+                appendUnique(out, names);
+            }
+            return out;
+        }
+    };
+
+    //! the mounts file_resource and directory_resource read through
+    inline VirtualFileSystem& vfs(){
+        static VirtualFileSystem instance;
+        return instance;
+    }
+}
+
+#endif // BRAINPACK_H
@@ -0,0 +1,330 @@
+#include "include/brain.h"
+#include "test_utils.h"
+#include "time_utils.h"
+#include <any>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+static int brainFailures = 0;
+#define BRAIN_CHECK(cond)\
+if(!(cond)){\
+    std::cerr<<"[BRAIN_CHECK] "<<__FILE__<<":"<<__LINE__<<" "<<#cond<<std::endl;\
+    brainFailures++;\
+}\
+
+template<typename F>
+static bool throws(F&& fn){
+    try{
+        fn();
+    }catch(const std::runtime_error&){
+        return true;
+    }
+    return false;
+}
+
+TEST(brainMetadataStore){
+    using namespace brain::core;
+    resource res;
+    res.set_bool_data("visible", true);
+    res.set_int_data("layer", 7);
+    res.set_str_data("name", "player");
+    BRAIN_CHECK(res.get_bool_data("visible") && res.get_int_data("layer") == 7 && res.get_str_data("name") == "player");
+
+    // keys intern once, the same name is the same index everywhere
+    MetadataKey layer("layer");
+    BRAIN_CHECK(layer == MetadataKey("layer") && layer.name() == "layer" && !(layer == MetadataKey("visible")));
+    res.set_int_data(layer, -3);
+    BRAIN_CHECK(res.get_int_data("layer") == -3);
+    res.data.set(MetadataKey("speed"), 2.5f);
+    BRAIN_CHECK(res.data.get<float>("speed") == 2.5f && res.data.typeOf("speed") == MetadataType::FLOAT);
+
+    BRAIN_CHECK(throws([&]{ res.get_int_data("missing"); }) && !res.data.has("missing"));
+#ifndef NDEBUG
+    BRAIN_CHECK(throws([&]{ res.get_int_data("visible"); }));
+#endif
+
+    // copies own their values
+    resource copy = res;
+    copy.set_str_data("name", "enemy");
+    BRAIN_CHECK(copy.get_str_data("name") == "enemy" && res.get_str_data("name") == "player" && copy.get_int_data(layer) == -3);
+
+    // a bound ref sees every later write, readers race a writer without locks
+    MetadataRef<bool> paused = res.data.ref<bool>("paused");
+    BRAIN_CHECK(paused && !paused.get());
+    std::atomic<bool> done = false;
+    std::thread writer([&]{
+        for(int i = 0; i < 100000; i++) res.set_bool_data("paused", i % 2 == 0);
+        res.set_str_data("name", "done");
+        done = true;
+    });
+    size_t reads = 0;
+    do{
+        paused.get();
+        BRAIN_CHECK(!res.get_str_data("name").empty());
+        reads++;
+    }while(!done);
+    writer.join();
+    BRAIN_CHECK(!paused.get() && res.get_str_data("name") == "done" && reads > 0);
+    return BoltTestResult::CALCULATED;
+};
+
+TEST(brainMetadataLookupBenchmark){
+    using namespace brain::core;
+    // the old layout, a string keyed tree of shared objects checked with dynamic_pointer_cast
+    struct Base { virtual ~Base() = default; };
+    struct BoolValue : Base { std::atomic_bool data; explicit BoolValue(bool v) : data(v) {} };
+    std::map<std::string, std::shared_ptr<Base>> legacy;
+    resource res;
+    for(int i = 0; i < 64; i++){
+        std::string name = "config_flag_" + std::to_string(i);
+        legacy[name] = std::make_shared<BoolValue>(i % 3 == 0);
+        res.set_bool_data(name, i % 3 == 0);
+    }
+    const std::string query = "config_flag_33";
+    MetadataKey key(query);
+    MetadataRef<bool> ref = res.data.ref<bool>(key);
+
+    const int loops = 1000000;
+    size_t hits = 0;
+    auto time = [&](auto&& fn){
+        auto start = std::chrono::steady_clock::now();
+        for(int i = 0; i < loops; i++) hits += fn();
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / loops;
+    };
+    double legacyNs = time([&]{
+        auto it = legacy.find(query);
+        auto value = std::dynamic_pointer_cast<BoolValue>(it->second);
+        return value && value->data.load();
+    });
+    double stringNs = time([&]{ return res.get_bool_data(query); });
+    double keyNs = time([&]{ return res.get_bool_data(key); });
+    double refNs = time([&]{ return ref.get(); });
+    BRAIN_CHECK(hits == static_cast<size_t>(loops) * 4);
+    std::cout<<"metadata bool read | map + dynamic cast "<<legacyNs<<"ns | string key "<<stringNs<<"ns | interned key "<<keyNs
+             <<"ns | bound ref "<<refNs<<"ns"<<std::endl;
+    return BoltTestResult::CALCULATED;
+};
+
+TEST(brainTypedMethods){
+    using namespace brain::core;
+    resource res;
+    int ticks = 0;
+    MethodHandle<int(int)> twice = res.type.define<int(int)>("twice", [](int v){ return v * 2; });
+    res.type.define<void(float)>("tick", [&](float){ ticks++; });
+    res.type.setMethod<std::string, std::string>("greet", [](std::string who){ return "hi " + who; });
+    int byName = res.type.call<int, int>("twice", 4);
+    std::string greeting = res.type.call<std::string, std::string>("greet", "bob");
+    BRAIN_CHECK(twice(21) == 42 && byName == 8 && greeting == "hi bob");
+    auto tick = res.type.bind<void(float)>("tick");
+    tick(0.016f);
+    tick(0.016f);
+    BRAIN_CHECK(ticks == 2);
+
+    // signatures are checked when binding, not on every call
+    BRAIN_CHECK(throws([&]{ res.type.bind<int(float)>("twice"); }));
+    BRAIN_CHECK(throws([&]{ res.type.bind<int(int)>("missing"); }));
+    BRAIN_CHECK(throws([&]{ res.type.define<float(int)>("twice", [](int){ return 0.0f; }); }));
+
+    // redefining keeps bound handles valid, copies own their callables
+    res.type.define<int(int)>("twice", [](int v){ return v + v + 1; });
+    BRAIN_CHECK(twice(1) == 3);
+    resource copy = res;
+    copy.type.define<int(int)>("twice", [](int v){ return -v; });
+    int copied = copy.type.call<int, int>("twice", 1);
+    BRAIN_CHECK(twice(1) == 3 && copied == -1);
+    return BoltTestResult::CALCULATED;
+};
+
+TEST(brainMethodDispatchBenchmark){
+    using namespace brain::core;
+    // the old dispatch, a string keyed map of std::any boxing functions
+    std::unordered_map<std::string, std::function<std::any(std::any)>> legacy;
+    std::function<std::string(std::string)> tag = [](std::string s){ s += '!'; return s; };
+    std::function<int(int)> step = [](int v){ return v + 1; };
+    legacy["tag"] = [tag](std::any arg) -> std::any { return tag(std::any_cast<std::string>(arg)); };
+    legacy["step"] = [step](std::any arg) -> std::any { return step(std::any_cast<int>(arg)); };
+    ResourceType type;
+    type.setMethod("tag", tag);
+    type.setMethod("step", step);
+    auto tagHandle = type.bind<std::string(std::string)>("tag");
+    auto stepHandle = type.bind<int(int)>("step");
+
+    const int loops = 500000;
+    const std::string name = "a scripted behaviour name longer than sso";
+    size_t sink = 0;
+    auto time = [&](auto&& fn){
+        auto start = std::chrono::steady_clock::now();
+        for(int i = 0; i < loops; i++) sink += fn(i);
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / loops;
+    };
+    double anyInt = time([&](int i){ return std::any_cast<int>(legacy.find("step")->second(i)); });
+    double anyString = time([&](int){ return std::any_cast<std::string>(legacy.find("tag")->second(name)).size(); });
+    double callInt = time([&](int i){ return type.call<int, int>("step", i); });
+    double handleInt = time([&](int i){ return stepHandle(i); });
+    double handleString = time([&](int){ return tagHandle(name).size(); });
+    BRAIN_CHECK(sink > 0);
+    std::cout<<"method dispatch | any int "<<anyInt<<"ns | any string "<<anyString<<"ns | typed call by name "<<callInt
+             <<"ns | handle int "<<handleInt<<"ns | handle string "<<handleString<<"ns"<<std::endl;
+    return BoltTestResult::CALCULATED;
+};
+
+TEST(brainMappedFileView){
+    namespace fs = std::filesystem;
+    fs::path path = fs::temp_directory_path() / "brain_mapped_level.txt";
+    {
+        std::ofstream out(path, std::ios::binary);
+        std::string row = "tile 12 34 grass\n";
+        for(int i = 0; i < (32 << 20) / static_cast<int>(row.size()); i++) out << row;
+    }
+    size_t size = fs::file_size(path);
+
+    auto start = std::chrono::steady_clock::now();
+    std::ifstream ifs(path);
+    std::string read((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+    double iteratorMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    brain::file_resource file(path.string());
+    start = std::chrono::steady_clock::now();
+    std::string_view view = file.view();
+    double mapUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    BRAIN_CHECK(file.mapped() && view.size() == size && view == read);
+    BRAIN_CHECK(file.bytes().data() == view.data() && view.substr(0, 4) == "tile");
+
+    // copies share the mapping, a flush drops it for every copy so all of them see the new size
+    brain::file_resource copy = file;
+    BRAIN_CHECK(copy.view().data() == view.data());
+    file.openFile("a");
+    file.write("tail\n");
+    file.flush();
+    BRAIN_CHECK(!file.mapped() && !copy.mapped());
+    BRAIN_CHECK(file.view().size() == size + 5 && file.view().substr(size) == "tail\n");
+    file.closeFile();
+    BRAIN_CHECK(copy.view().size() == size + 5 && copy.view().substr(size) == "tail\n");
+    copy.unmap();
+    BRAIN_CHECK(file.deleteFile() && !fs::exists(path));
+    brain::file_resource missing(path.string());
+    BRAIN_CHECK(missing.view().empty() && !missing.mapped());
+
+    // copies taken before the first write still share one sink
+    brain::file_resource opener(path.string());
+    brain::file_resource writer = opener;
+    opener.openFile("w");
+    writer.write("shared");
+    writer.flush();
+    opener.closeFile();
+    BRAIN_CHECK(opener.view() == "shared");
+    BRAIN_CHECK(opener.deleteFile());
+
+    std::cout<<"file read "<<(size >> 20)<<"MB | istreambuf_iterator "<<iteratorMs<<"ms | mapped view "<<mapUs<<"us"<<std::endl;
+    return BoltTestResult::CALCULATED;
+};
+
+TEST(brainPackedVfs){
+    namespace fs = std::filesystem;
+    fs::path root = fs::temp_directory_path() / "brain_vfs";
+    fs::remove_all(root);
+    fs::path loose = root / "loose";
+    const int count = 2000;
+    for(int i = 0; i < count; i++){
+        fs::path file = loose / ("group" + std::to_string(i % 20)) / ("asset" + std::to_string(i) + ".txt");
+        fs::create_directories(file.parent_path());
+        std::ofstream out(file, std::ios::binary);
+        out << "asset " << i << " " << std::string(static_cast<size_t>(100 + i % 300), static_cast<char>('a' + i % 26));
+    }
+
+    brain::PackWriteOptions options;
+    options.compress = true;
+    brain::PackWriter writer(options);
+    BRAIN_CHECK(writer.addDirectory(loose.string()) == static_cast<size_t>(count));
+    writer.add("raw/incompressible.bin", {1, 200, 3, 77, 5, 9}, true);
+    std::string packPath = (root / "assets.opak").string();
+    BRAIN_CHECK(writer.write(packPath));
+
+    brain::PackArchive archive;
+    BRAIN_CHECK(archive.open(packPath) && archive.size() == static_cast<size_t>(count) + 1);
+    const brain::PackEntry* entry = archive.find("group3/asset3.txt");
+    BRAIN_CHECK(entry && (entry->flags & brain::PackEntry::FLAG_LZ4));
+    brain::PackData data = archive.read(*entry);
+    BRAIN_CHECK(data && data.view.substr(0, 8) == "asset 3 " && data.view.size() == 8 + 103);
+    // stored entries are aligned views straight into the mapping
+    brain::PackData raw = archive.read("raw/incompressible.bin");
+    BRAIN_CHECK(raw && raw.view.size() == 6 && reinterpret_cast<uintptr_t>(raw.view.data()) % 16 == 0);
+    BRAIN_CHECK(!archive.find("group3/missing.txt") && archive.listDirectories("").size() == 21 && archive.listFiles("group7").size() == 100);
+
+    // the brain api reads the mounted archive as if it were a directory
+    brain::vfs().mountArchive(packPath, (root / "mounted").string());
+    brain::directory_resource dir((root / "mounted").string());
+    dir.setup();
+    BRAIN_CHECK(dir.subs().size() == 21 && dir.sub("group5").id.basic_id == (root / "mounted" / "group5").string());
+    brain::directory_resource group = dir.sub("group5");
+    group.setup();
+    BRAIN_CHECK(group.subfiles().size() == 100 && group.subfiles("asset105.txt").size() == 1);
+    brain::file_resource asset = group.subfile("asset105.txt");
+    BRAIN_CHECK(asset.exists() && asset.view().substr(0, 10) == "asset 105 ");
+
+    // a later loose mount overrides single files
+    fs::path overlay = root / "overlay" / "group5";
+    fs::create_directories(overlay);
+    { std::ofstream out(overlay / "asset105.txt"); out << "patched"; }
+    brain::vfs().mountDirectory((root / "overlay").string(), (root / "mounted").string());
+    brain::file_resource patched((root / "mounted" / "group5" / "asset105.txt").string());
+    brain::file_resource untouched((root / "mounted" / "group5" / "asset125.txt").string());
+    BRAIN_CHECK(patched.view() == "patched" && untouched.view().substr(0, 10) == "asset 125 ");
+    // a file written under the mount point is read back from disk, not from the archive
+    fs::create_directories(root / "mounted" / "group5");
+    brain::file_resource written((root / "mounted" / "group5" / "asset145.txt").string());
+    BRAIN_CHECK(written.view().substr(0, 10) == "asset 145 ");
+    written.openFile("w");
+    written.write("rewritten");
+    written.flush();
+    written.closeFile();
+    BRAIN_CHECK(written.view() == "rewritten");
+    brain::vfs().clear();
+
+    // opening thousands of loose files against one mapped archive
+    std::vector<std::string> names;
+    for(int i = 0; i < count; i++) names.push_back("group" + std::to_string(i % 20) + "/asset" + std::to_string(i) + ".txt");
+    size_t bytes = 0;
+    auto start = std::chrono::steady_clock::now();
+    for(const auto& name : names){
+        std::ifstream in(loose / name, std::ios::binary);
+        std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        bytes += text.size();
+    }
+    double looseMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    start = std::chrono::steady_clock::now();
+    brain::PackArchive cold;
+    cold.open(packPath);
+    for(const auto& name : names) bytes -= cold.read(name).view.size();
+    double packMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    BRAIN_CHECK(bytes == 0);
+    std::cout<<"read "<<count<<" small assets | loose files "<<looseMs<<"ms | packed archive "<<packMs<<"ms ("
+             <<fs::file_size(packPath)<<" bytes, lz4)"<<std::endl;
+
+    std::vector<uint8_t> truncated(fs::file_size(packPath) / 2);
+    { std::ifstream in(packPath, std::ios::binary); in.read(reinterpret_cast<char*>(truncated.data()), truncated.size()); }
+    { std::ofstream out(root / "broken.opak", std::ios::binary); out.write(reinterpret_cast<const char*>(truncated.data()), truncated.size()); }
+    BRAIN_CHECK(!brain::PackArchive().open((root / "broken.opak").string()));
+    fs::remove_all(root);
+    return BoltTestResult::CALCULATED;
+};
+
+int main(){
+    COLORIZED_MODE = true;
+    TIME_PROFILER_IS_ON = true;
+
+    BOLT_TEST(brainTest1,"typed metadata store, interning, copies and lock free reads",brainMetadataStore);
+    BOLT_TEST(brainTest2,"metadata lookup against the map + dynamic cast layout",brainMetadataLookupBenchmark);
+    BOLT_TEST(brainTest3,"typed method slots, bind time signature checks",brainTypedMethods);
+    BOLT_TEST(brainTest4,"method handles against std::any dispatch",brainMethodDispatchBenchmark);
+    BOLT_TEST(brainTest5,"file_resource mapped views against iterator reads",brainMappedFileView);
+    BOLT_TEST(brainTest6,"packed archive mounts, hashed lookups and loose overrides",brainPackedVfs);
+
+    std::ofstream fileStream{"profilerResults__brain.json"};
+    runTests(std::cout,fileStream);
+    fileStream.close();
+
+    return brainFailures == 0 ? 0 : 1;
+}
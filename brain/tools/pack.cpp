@@ -0,0 +1,35 @@
+#include "brainpack.h"
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// brainpack <output .opak> <directory> [--lz4] [--align N]
+// packs every file under directory, mount the result with brain::vfs().mountArchive(output, directory)
+int main(int argc, char** argv) {
+    brain::PackWriteOptions options;
+    std::vector<std::string> positional;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--lz4") options.compress = true;
+        else if (arg == "--align" && i + 1 < argc) options.alignment = static_cast<uint32_t>(std::atoi(argv[++i]));
+        else positional.push_back(arg);
+    }
+    if (positional.size() != 2 || (options.alignment & (options.alignment - 1)) != 0) {
+        std::cerr << "usage: brainpack <output .opak> <directory> [--lz4] [--align N], N a power of two" << std::endl;
+        return 1;
+    }
+    if (!std::filesystem::is_directory(positional[1])) {
+        std::cerr << "brainpack: " << positional[1] << " is not a directory" << std::endl;
+        return 1;
+    }
+
+    brain::PackWriter writer(options);
+    size_t files = writer.addDirectory(positional[1]);
+    std::filesystem::path out = positional[0];
+    if (out.has_parent_path()) std::filesystem::create_directories(out.parent_path());
+    if (!writer.write(out.string())) return 1;
+    std::cout << files << " files into " << out.filename().string() << ", " << std::filesystem::file_size(out) << " bytes" << std::endl;
+    return 0;
+}
@@ -1,6 +1,9 @@
 #ifndef BOLTF_H
 #define BOLTF_H
 
+#include <algorithm>
+#include <array>
+#include <cstring>
 #include <string>
 #include <unordered_map>
 #include <utility>
@@ -18,57 +21,93 @@ struct Character {
     max::vec2<int> size;
     max::vec2<int> bearing;   
     GLuint advance;     
+    max::vec2<float> uvMin;
+    max::vec2<float> uvMax;
 };
 
+//! every glyph lives in one atlas, quads between begin() and end() go out in one upload and one draw
 class BoltF {
 private:
-    std::unordered_map<char, Character> characters;
+    std::array<Character, 128> characters{};
     FT_Library ft;
     FT_Face face;
     
     GLuint VAO, VBO;
+    GLuint atlasTexture = 0;
     GLuint shaderProgram;
     GLuint vertexShader, fragmentShader;
     
     GLint projectionLoc;
-    GLint textColorLoc;
     GLint textureLoc;
     
     max::vec2<int> screenSize;
+
+    // x, y, u, v, r, g, b, a
+    static constexpr int floatsPerVertex = 8;
+    std::vector<float> batch;
+    size_t bufferCapacity = 0;
+    max::vec4<float> textColor{1.0f, 1.0f, 1.0f, 1.0f};
     
     
     const char* vertexShaderSource = R"(
         #version 330 core
         layout (location = 0) in vec2 vertex;
         layout (location = 1) in vec2 texCoord;
+        layout (location = 2) in vec4 color;
         
         out vec2 TexCoords;
+        out vec4 TextColor;
         
         uniform mat4 projection;
         
         void main() {
             gl_Position = projection * vec4(vertex, 0.0, 1.0);
             TexCoords = texCoord;
+            TextColor = color;
         }
     )";
     
     const char* fragmentShaderSource = R"(
         #version 330 core
         in vec2 TexCoords;
+        in vec4 TextColor;
         out vec4 color;
         
         uniform sampler2D text;
-        uniform vec3 textColor;
         
         void main() {
-            vec4 sampled = vec4(1.0, 1.0, 1.0, texture(text, TexCoords).r);
-            color = vec4(textColor, 1.0) * sampled;
+            color = vec4(TextColor.rgb, TextColor.a * texture(text, TexCoords).r);
         }
     )";
     
     bool initialized = false;
     bool fontLoaded = false;
 
+    const Character& glyph(char c) const {
+        unsigned char index = static_cast<unsigned char>(c);
+        return characters[index < characters.size() ? index : 0];
+    }
+
+    void pushVertex(float x, float y, float u, float v) {
+        batch.insert(batch.end(), {x, y, u, v, textColor.x, textColor.y, textColor.z, textColor.w});
+    }
+
+    //! single upload and draw for everything queued since the last flush
+    void flush() {
+        if (batch.empty() || !initialized) return;
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        size_t bytes = batch.size() * sizeof(float);
+        if (bytes > bufferCapacity) {
+            bufferCapacity = (std::max)(bytes, bufferCapacity * 2);
+            glBufferData(GL_ARRAY_BUFFER, bufferCapacity, NULL, GL_DYNAMIC_DRAW);
+        }
+        glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, batch.data());
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(batch.size() / floatsPerVertex));
+        batch.clear();
+    }
+
 public:
     BoltF() : VAO(0), VBO(0), shaderProgram(0), vertexShader(0), fragmentShader(0) {
         if (FT_Init_FreeType(&ft)) {
@@ -98,6 +137,7 @@ public:
             glDeleteBuffers(1, &VBO);
             VBO = 0;
         }
+        bufferCapacity = 0;
         if (shaderProgram != 0) {
             glDeleteProgram(shaderProgram);
             shaderProgram = 0;
@@ -110,11 +150,12 @@ public:
             glDeleteShader(fragmentShader);
             fragmentShader = 0;
         }
-        
-        for (auto& pair : characters) {
-            glDeleteTextures(1, &pair.second.textureID);
+        if (atlasTexture != 0) {
+            glDeleteTextures(1, &atlasTexture);
+            atlasTexture = 0;
         }
-        characters.clear();
+        characters = {};
+        batch.clear();
         
         initialized = false;
         fontLoaded = false;
@@ -162,7 +203,6 @@ public:
         if (!checkProgramLink(shaderProgram)) return false;
         
         projectionLoc = glGetUniformLocation(shaderProgram, "projection");
-        textColorLoc = glGetUniformLocation(shaderProgram, "textColor");
         textureLoc = glGetUniformLocation(shaderProgram, "text");
         
         return true;
@@ -189,50 +229,79 @@ public:
         glGenBuffers(1, &VBO);
         glBindVertexArray(VAO);
         glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 6 * 4, NULL, GL_DYNAMIC_DRAW);
+        bufferCapacity = sizeof(float) * floatsPerVertex * 6 * 256;
+        glBufferData(GL_ARRAY_BUFFER, bufferCapacity, NULL, GL_DYNAMIC_DRAW);
         glEnableVertexAttribArray(0);
-        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, floatsPerVertex * sizeof(float), (void*)0);
         glEnableVertexAttribArray(1);
-        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, floatsPerVertex * sizeof(float), (void*)(2 * sizeof(float)));
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, floatsPerVertex * sizeof(float), (void*)(4 * sizeof(float)));
         glBindBuffer(GL_ARRAY_BUFFER, 0);
         glBindVertexArray(0);
-        
-        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-        
+
+        // shelf pack the rendered glyphs, the atlas height is whatever the rows add up to
+        struct Bitmap {
+            int x = 0, y = 0;
+            int width = 0, rows = 0;
+            std::vector<unsigned char> pixels;
+        };
+        std::array<Bitmap, 128> bitmaps;
+        const int atlasW = 1024;
+        int x = 0, y = 0, rowHeight = 0;
         for (unsigned char c = 0; c < 128; c++) {
             if (FT_Load_Char(face, c, FT_LOAD_RENDER)) {
                 std::cerr << "ERROR::FREETYPE: Failed to load Glyph for char: " << (int)c << std::endl;
                 continue;
             }
-            
-            GLuint texture;
-            glGenTextures(1, &texture);
-            glBindTexture(GL_TEXTURE_2D, texture);
-            glTexImage2D(
-                GL_TEXTURE_2D,
-                0,
-                GL_RED,
-                face->glyph->bitmap.width,
-                face->glyph->bitmap.rows,
+            const auto& bitmap = face->glyph->bitmap;
+            Bitmap& packed = bitmaps[c];
+            packed.width = bitmap.width;
+            packed.rows = bitmap.rows;
+            packed.pixels.resize(static_cast<size_t>(bitmap.width) * bitmap.rows);
+            for (unsigned int row = 0; row < bitmap.rows; row++) {
+                std::memcpy(&packed.pixels[row * bitmap.width], bitmap.buffer + row * bitmap.pitch, bitmap.width);
+            }
+            if (x + packed.width + 1 > atlasW) {
+                x = 0;
+                y += rowHeight + 1;
+                rowHeight = 0;
+            }
+            packed.x = x;
+            packed.y = y;
+            x += packed.width + 1;
+            rowHeight = (std::max)(rowHeight, packed.rows);
+
+            characters[c] = {
                 0,
-                GL_RED,
-                GL_UNSIGNED_BYTE,
-                face->glyph->bitmap.buffer
-            );
-            
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-            
-            Character character = {
-                texture,
                 max::vec2<int>(face->glyph->bitmap.width, face->glyph->bitmap.rows),
                 max::vec2<int>(face->glyph->bitmap_left, face->glyph->bitmap_top),
                 static_cast<GLuint>(face->glyph->advance.x)
             };
-            characters.insert(std::pair<char, Character>(c, character));
         }
+        int atlasH = (std::max)(1, y + rowHeight);
+
+        std::vector<unsigned char> atlas(static_cast<size_t>(atlasW) * atlasH, 0);
+        for (size_t c = 0; c < bitmaps.size(); c++) {
+            const Bitmap& packed = bitmaps[c];
+            for (int row = 0; row < packed.rows; row++) {
+                std::memcpy(&atlas[static_cast<size_t>(packed.y + row) * atlasW + packed.x],
+                            &packed.pixels[static_cast<size_t>(row) * packed.width], packed.width);
+            }
+            characters[c].uvMin = {(float)packed.x / atlasW, (float)packed.y / atlasH};
+            characters[c].uvMax = {(float)(packed.x + packed.width) / atlasW, (float)(packed.y + packed.rows) / atlasH};
+        }
+
+        glGenTextures(1, &atlasTexture);
+        glBindTexture(GL_TEXTURE_2D, atlasTexture);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, atlasW, atlasH, 0, GL_RED, GL_UNSIGNED_BYTE, atlas.data());
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        for (auto& ch : characters) ch.textureID = atlasTexture;
         
         initialized = true;
         fontLoaded = true;
@@ -247,29 +316,12 @@ public:
         }
         
         this->screenSize = screenSize;
-        
-        glEnable(GL_BLEND);
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-        
-        glUseProgram(shaderProgram);
-        
-        float projection[16] = {
-            2.0f / screenSize.x, 0.0f, 0.0f, 0.0f,
-            0.0f, 2.0f / screenSize.y, 0.0f, 0.0f,
-            0.0f, 0.0f, -1.0f, 0.0f,
-            -1.0f, -1.0f, 0.0f, 1.0f
-        };
-        
-        glUniformMatrix4fv(projectionLoc, 1, GL_FALSE, projection);
-        glUniform1i(textureLoc, 0);
-        
-        glUniform3f(textColorLoc, 1.0f, 1.0f, 1.0f);
-        
-        glActiveTexture(GL_TEXTURE0);
-        glBindVertexArray(VAO);
+        batch.clear();
+        // every batch starts white, COLORBF between begin and end tints what follows
+        textColor = {1.0f, 1.0f, 1.0f, 1.0f};
     }
     
-    std::vector<std::pair<Character, float[4][6]>> totalVertex;
+    //! only queues the quads, nothing reaches GL before end()
     void draw(const std::string& text, const max::vec2<float>& scale, const max::vec2<float>& location) {
         if (!initialized || !fontLoaded) {
             return;
@@ -277,10 +329,10 @@ public:
         
         float x = location.x;
         float y = location.y;
+        batch.reserve(batch.size() + text.size() * 6 * floatsPerVertex);
         
-        std::string::const_iterator c;
-        for (c = text.begin(); c != text.end(); c++) {
-            Character ch = characters[*c];
+        for (char c : text) {
+            const Character& ch = glyph(c);
             
             float xpos = x + ch.bearing.x * scale.x;
             float ypos = y - (ch.size.y - ch.bearing.y) * scale.y;
@@ -288,41 +340,58 @@ public:
             float w = ch.size.x * scale.x;
             float h = ch.size.y * scale.y;
             
-            float vertices[6][4] = {
-                { xpos,     ypos + h,   0.0f, 0.0f },
-                { xpos,     ypos,       0.0f, 1.0f },
-                { xpos + w, ypos,       1.0f, 1.0f },
-                
-                { xpos,     ypos + h,   0.0f, 0.0f },
-                { xpos + w, ypos,       1.0f, 1.0f },
-                { xpos + w, ypos + h,   1.0f, 0.0f }
-            };
-            
-            glBindTexture(GL_TEXTURE_2D, ch.textureID);
-            
-            glBindBuffer(GL_ARRAY_BUFFER, VBO);
-            glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices);
-            glBindBuffer(GL_ARRAY_BUFFER, 0);
-            
-            glDrawArrays(GL_TRIANGLES, 0, 6);
+            if (w > 0.0f && h > 0.0f) {
+                pushVertex(xpos,     ypos + h, ch.uvMin.x, ch.uvMin.y);
+                pushVertex(xpos,     ypos,     ch.uvMin.x, ch.uvMax.y);
+                pushVertex(xpos + w, ypos,     ch.uvMax.x, ch.uvMax.y);
+
+                pushVertex(xpos,     ypos + h, ch.uvMin.x, ch.uvMin.y);
+                pushVertex(xpos + w, ypos,     ch.uvMax.x, ch.uvMax.y);
+                pushVertex(xpos + w, ypos + h, ch.uvMax.x, ch.uvMin.y);
+            }
             
             x += (ch.advance >> 6) * scale.x;
         }
     }
     
     void end() {
+        if (!initialized || !fontLoaded) {
+            return;
+        }
+
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        
+        glUseProgram(shaderProgram);
+        
+        float projection[16] = {
+            2.0f / screenSize.x, 0.0f, 0.0f, 0.0f,
+            0.0f, 2.0f / screenSize.y, 0.0f, 0.0f,
+            0.0f, 0.0f, -1.0f, 0.0f,
+            -1.0f, -1.0f, 0.0f, 1.0f
+        };
+        
+        glUniformMatrix4fv(projectionLoc, 1, GL_FALSE, projection);
+        glUniform1i(textureLoc, 0);
+        
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, atlasTexture);
+        glBindVertexArray(VAO);
+
+        flush();
+
         glBindVertexArray(0);
         glBindTexture(GL_TEXTURE_2D, 0);
         glUseProgram(0);
         glDisable(GL_BLEND);
     }
     
-    void setTextColor(float r, float g, float b) {
-        if (initialized) {
-            glUseProgram(shaderProgram);
-            glUniform3f(textColorLoc, r, g, b);
-        }
+    //! applies to the text drawn after it, colour travels with the vertices
+    void setTextColor(float r, float g, float b, float a = 1.0f) {
+        textColor = {r, g, b, a};
     }
+
+    size_t queuedGlyphs() const { return batch.size() / (6 * floatsPerVertex); }
     
     max::vec2<float> getTextSize(const std::string& text, const max::vec2<float>& scale) {
         if (!fontLoaded) return max::vec2<float>(0, 0);
@@ -331,10 +400,9 @@ public:
         float height = 0;
         
         for (char c : text) {
-            Character ch = characters[c];
+            const Character& ch = glyph(c);
             width += (ch.advance >> 6) * scale.x;
-            #define tssmax(a,b)            (((a) > (b)) ? (a) : (b))
-            height = tssmax(height, ch.size.y * scale.y);
+            height = (std::max)(height, ch.size.y * scale.y);
         }
         
         return max::vec2<float>(width, height);
@@ -434,8 +502,12 @@ private:
     int atlasGridWidth, atlasGridHeight; // Atlas'taki grid boyutu (örn: 16x16)
     __Vec2i atlasCellSize; // Her karakterin pixel boyutu
     
-    // Screen buffer - her hücre bir karakter
-    std::vector<std::vector<unsigned char>> screenBuffer;
+    // Screen buffer - her hücre bir karakter, satırlar arka arkaya (row * screenWidth + col)
+    std::vector<unsigned char> screenBuffer;
+    
+    // Değişen satırlar, updateBuffer sadece bunları yeniden yazar ve yükler
+    std::vector<unsigned char> dirtyRows;
+    bool anyDirty = false;
     
     // OpenGL nesneleri
     GLuint VAO, VBO;
@@ -445,7 +517,8 @@ private:
     // Shader uniform konumları
     GLint projectionLoc, textColorLoc, textureLoc;
     
-    // Vertex verileri
+    // Vertex verileri, her hücrenin sabit 6 vertex'lik yeri var (boş hücre = sıfır alanlı quad)
+    static constexpr int floatsPerCell = 6 * 4;
     std::vector<float> vertices;
     
     // Texture atlas
@@ -454,8 +527,9 @@ private:
     // Karakter pattern string'i (ASCII sıralı)
     std::string characterPattern;
     
-    // UV koordinat haritası
-    std::map<unsigned char, __Vec2> uvCoords;
+    // UV koordinat tablosu, karakter koduyla direkt indekslenir
+    std::array<__Vec2, 256> uvCoords;
+    std::array<bool, 256> hasUV{};
     
     // Shader kodları
     const char* vertexShaderSource = R"(
@@ -540,7 +614,7 @@ private:
     }
     
     void generateUVCoordinates() {
-        uvCoords.clear();
+        hasUV.fill(false);
         
         float cellW = 1.0f / atlasGridWidth;
         float cellH = 1.0f / atlasGridHeight;
@@ -554,52 +628,45 @@ private:
             
             unsigned char ch = static_cast<unsigned char>(characterPattern[i]);
             uvCoords[ch] = __Vec2(u, v);
+            hasUV[ch] = true;
         }
     }
     
-    void rebuildVertexData() {
-        vertices.clear();
-        
+    void markRowDirty(int row) {
+        dirtyRows[row] = 1;
+        anyDirty = true;
+    }
+    
+    void writeRowVertices(int row) {
         float cellW = 1.0f / atlasGridWidth;
         float cellH = 1.0f / atlasGridHeight;
+        float yPos = row * cellHeight;
         
-        for (int row = 0; row < screenHeight; ++row) {
-            for (int col = 0; col < screenWidth; ++col) {
-                unsigned char ch = screenBuffer[row][col];
-                
-                // Boş karakterleri atla
-                if (ch == 0 || ch == ' ') continue;
-                
-                // UV koordinatlarını al
-                auto it = uvCoords.find(ch);
-                if (it == uvCoords.end()) continue;
-                
-                __Vec2 uv = it->second;
-                
-                // Screen pozisyonları (pixel cinsinden)
-                float xPos = col * cellWidth;
-                float yPos = row * cellHeight;
-                
-                // İki üçgen oluştur (quad)
-                float quad[6][4] = {
-                    // İlk üçgen
-                    { xPos,              yPos + cellHeight, uv.x,        uv.y },
-                    { xPos,              yPos,              uv.x,        uv.y + cellH },
-                    { xPos + cellWidth,  yPos,              uv.x + cellW, uv.y + cellH },
-                    
-                    // İkinci üçgen
-                    { xPos,              yPos + cellHeight, uv.x,        uv.y },
-                    { xPos + cellWidth,  yPos,              uv.x + cellW, uv.y + cellH },
-                    { xPos + cellWidth,  yPos + cellHeight, uv.x + cellW, uv.y }
-                };
-                
-                // Vertex verilerini ekle
-                for (int i = 0; i < 6; ++i) {
-                    for (int j = 0; j < 4; ++j) {
-                        vertices.push_back(quad[i][j]);
-                    }
-                }
+        for (int col = 0; col < screenWidth; ++col) {
+            size_t cell = static_cast<size_t>(row) * screenWidth + col;
+            float* out = &vertices[cell * floatsPerCell];
+            unsigned char ch = screenBuffer[cell];
+            
+            // Boş karakterler sıfır alanlı quad olarak kalır
+            if (ch == 0 || ch == ' ' || !hasUV[ch]) {
+                std::fill(out, out + floatsPerCell, 0.0f);
+                continue;
             }
+            
+            __Vec2 uv = uvCoords[ch];
+            float xPos = col * cellWidth;
+            
+            // İki üçgen oluştur (quad)
+            const float quad[floatsPerCell] = {
+                xPos,              yPos + cellHeight, uv.x,         uv.y,
+                xPos,              yPos,              uv.x,         uv.y + cellH,
+                xPos + cellWidth,  yPos,              uv.x + cellW, uv.y + cellH,
+                
+                xPos,              yPos + cellHeight, uv.x,         uv.y,
+                xPos + cellWidth,  yPos,              uv.x + cellW, uv.y + cellH,
+                xPos + cellWidth,  yPos + cellHeight, uv.x + cellW, uv.y
+            };
+            std::memcpy(out, quad, sizeof(quad));
         }
     }
     
@@ -640,7 +707,10 @@ public:
         }
         
         // Screen buffer'ı initialize et
-        screenBuffer.resize(screenHeight, std::vector<unsigned char>(screenWidth, ' '));
+        screenBuffer.assign(static_cast<size_t>(screenWidth) * screenHeight, ' ');
+        vertices.assign(screenBuffer.size() * floatsPerCell, 0.0f);
+        dirtyRows.assign(screenHeight, 1);
+        anyDirty = true;
         
         // Texture atlas'ı yükle
         if (!atlas.loadFromFile(atlasPath)) {
@@ -681,28 +751,53 @@ public:
     
     void setCharacter(int x, int y, unsigned char ch) {
         if (x >= 0 && x < screenWidth && y >= 0 && y < screenHeight) {
-            screenBuffer[y][x] = ch;
+            unsigned char& cell = screenBuffer[static_cast<size_t>(y) * screenWidth + x];
+            if (cell == ch) return;
+            cell = ch;
+            markRowDirty(y);
         }
     }
     
     void setText(int x, int y, const std::string& text) {
-        for (size_t i = 0; i < text.length() && (x + i) < screenWidth; ++i) {
+        for (size_t i = 0; i < text.length() && x + static_cast<int>(i) < screenWidth; ++i) {
             setCharacter(x + i, y, text[i]);
         }
     }
     
     void clearScreen() {
-        for (auto& row : screenBuffer) {
-            std::fill(row.begin(), row.end(), ' ');
+        for (int row = 0; row < screenHeight; ++row) {
+            auto begin = screenBuffer.begin() + static_cast<size_t>(row) * screenWidth;
+            auto end = begin + screenWidth;
+            if (std::all_of(begin, end, [](unsigned char c) { return c == ' '; })) continue;
+            std::fill(begin, end, ' ');
+            markRowDirty(row);
         }
     }
     
+    // Sadece değişen satırları yeniden yazar, bitişik satırları tek glBufferSubData ile yükler
     void updateBuffer() {
-        rebuildVertexData();
+        if (!anyDirty) return;
         
         glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferSubData(GL_ARRAY_BUFFER, 0, vertices.size() * sizeof(float), vertices.data());
+        int row = 0;
+        while (row < screenHeight) {
+            if (!dirtyRows[row]) {
+                ++row;
+                continue;
+            }
+            int first = row;
+            while (row < screenHeight && dirtyRows[row]) {
+                writeRowVertices(row);
+                dirtyRows[row] = 0;
+                ++row;
+            }
+            size_t rowFloats = static_cast<size_t>(screenWidth) * floatsPerCell;
+            size_t offset = first * rowFloats;
+            size_t count = (row - first) * rowFloats;
+            glBufferSubData(GL_ARRAY_BUFFER, offset * sizeof(float), count * sizeof(float), &vertices[offset]);
+        }
         glBindBuffer(GL_ARRAY_BUFFER, 0);
+        anyDirty = false;
     }
     
     void render(const Color& textColor = Color(1.0f, 1.0f, 1.0f, 1.0f)) {
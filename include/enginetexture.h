@@ -0,0 +1,249 @@
+#ifndef ENGINETEXTURE_H
+#define ENGINETEXTURE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "lz4block.h"
+#include "mappedfile.h"
+#include "texture.h"
+
+//! .otex, a header, a level table and the RGBA8 mip chain, optionally one LZ4 block
+struct EngineTextureHeader {
+    static constexpr uint32_t MAGIC = 0x5845544F;  // "OTEX"
+    static constexpr uint16_t VERSION = 1;
+    static constexpr uint16_t FLAG_LZ4 = 1;
+
+    uint32_t magic = MAGIC;
+    uint16_t version = VERSION;
+    uint16_t flags = 0;
+    uint32_t width = 0, height = 0;
+    uint32_t levels = 0;
+    uint32_t reserved = 0;
+    uint64_t sourceHash = 0;
+    uint64_t rawSize = 0;
+    uint64_t storedSize = 0;
+};
+static_assert(sizeof(EngineTextureHeader) == 48, "EngineTextureHeader is written as is");
+
+struct EngineTextureLevel {
+    uint32_t width = 0, height = 0;
+    //! into the uncompressed payload
+    uint64_t offset = 0;
+};
+
+struct EngineTextureOptions {
+    bool mipmaps = true;
+    bool lz4 = false;
+};
+
+//! 2x2 box filter, odd edges reuse their last row or column
+inline void downsampleRGBA(const uint8_t* src, int width, int height, uint8_t* dst) {
+    int w = (std::max)(1, width / 2), h = (std::max)(1, height / 2);
+    for (int y = 0; y < h; y++) {
+        int y0 = (std::min)(y * 2, height - 1), y1 = (std::min)(y * 2 + 1, height - 1);
+        for (int x = 0; x < w; x++) {
+            int x0 = (std::min)(x * 2, width - 1), x1 = (std::min)(x * 2 + 1, width - 1);
+            const uint8_t* a = src + (static_cast<size_t>(y0) * width + x0) * 4;
+            const uint8_t* b = src + (static_cast<size_t>(y0) * width + x1) * 4;
+            const uint8_t* c = src + (static_cast<size_t>(y1) * width + x0) * 4;
+            const uint8_t* d = src + (static_cast<size_t>(y1) * width + x1) * 4;
+            uint8_t* out = dst + (static_cast<size_t>(y) * w + x) * 4;
+            for (int ch = 0; ch < 4; ch++) out[ch] = static_cast<uint8_t>((a[ch] + b[ch] + c[ch] + d[ch] + 2) / 4);
+        }
+    }
+}
+
+inline size_t engineTexturePayloadOffset(uint32_t levels) {
+    size_t end = sizeof(EngineTextureHeader) + levels * sizeof(EngineTextureLevel);
+    return (end + 15) & ~size_t(15);
+}
+
+inline std::vector<uint8_t> encodeEngineTexture(const uint8_t* rgba, int width, int height, const EngineTextureOptions& options,
+                                                uint64_t sourceHash = 0) {
+    std::vector<EngineTextureLevel> levels;
+    std::vector<uint8_t> raw(static_cast<size_t>(width) * height * 4);
+    std::memcpy(raw.data(), rgba, raw.size());
+    levels.push_back({static_cast<uint32_t>(width), static_cast<uint32_t>(height), 0});
+    while (options.mipmaps && (levels.back().width > 1 || levels.back().height > 1)) {
+        EngineTextureLevel last = levels.back();
+        EngineTextureLevel next{(std::max)(1u, last.width / 2), (std::max)(1u, last.height / 2), raw.size()};
+        raw.resize(raw.size() + size_t(next.width) * next.height * 4);
+        downsampleRGBA(raw.data() + last.offset, last.width, last.height, raw.data() + next.offset);
+        levels.push_back(next);
+    }
+
+    EngineTextureHeader header;
+    header.width = width;
+    header.height = height;
+    header.levels = static_cast<uint32_t>(levels.size());
+    header.sourceHash = sourceHash;
+    header.rawSize = raw.size();
+    std::vector<uint8_t> packed;
+    if (options.lz4) {
+        packed = lz4::compress(raw.data(), raw.size());
+        header.flags |= EngineTextureHeader::FLAG_LZ4;
+    }
+    const std::vector<uint8_t>& payload = options.lz4 ? packed : raw;
+    header.storedSize = payload.size();
+
+    size_t payloadOffset = engineTexturePayloadOffset(header.levels);
+    std::vector<uint8_t> file(payloadOffset + payload.size(), 0);
+    std::memcpy(file.data(), &header, sizeof(header));
+    std::memcpy(file.data() + sizeof(header), levels.data(), levels.size() * sizeof(EngineTextureLevel));
+    std::memcpy(file.data() + payloadOffset, payload.data(), payload.size());
+    return file;
+}
+
+//! parsed .otex, uncompressed files point straight into the mapping, LZ4 ones into an owned buffer
+class EngineTextureView {
+    MappedFile mapped;
+    std::vector<uint8_t> inflated;
+    const uint8_t* payload = nullptr;
+
+public:
+    EngineTextureHeader header;
+    std::vector<EngineTextureLevel> levels;
+
+    bool parse(const uint8_t* data, size_t size) {
+        if (size < sizeof(EngineTextureHeader)) return false;
+        std::memcpy(&header, data, sizeof(header));
+        if (header.magic != EngineTextureHeader::MAGIC || header.version != EngineTextureHeader::VERSION || header.levels == 0 ||
+            header.levels > 32) {
+            std::cerr << "EngineTexture: not an otex v" << EngineTextureHeader::VERSION << " file" << std::endl;
+            return false;
+        }
+        size_t payloadOffset = engineTexturePayloadOffset(header.levels);
+        if (payloadOffset + header.storedSize > size) {
+            std::cerr << "EngineTexture: truncated file" << std::endl;
+            return false;
+        }
+        levels.resize(header.levels);
+        std::memcpy(levels.data(), data + sizeof(header), levels.size() * sizeof(EngineTextureLevel));
+        for (const auto& level : levels) {
+            if (level.offset + uint64_t(level.width) * level.height * 4 > header.rawSize) return false;
+        }
+
+        const uint8_t* stored = data + payloadOffset;
+        if (header.flags & EngineTextureHeader::FLAG_LZ4) {
+            inflated.resize(header.rawSize);
+            if (!lz4::decompress(stored, header.storedSize, inflated.data(), inflated.size())) {
+                std::cerr << "EngineTexture: corrupt LZ4 payload" << std::endl;
+                return false;
+            }
+            payload = inflated.data();
+        } else {
+            if (header.storedSize != header.rawSize) return false;
+            payload = stored;
+        }
+        return true;
+    }
+
+    bool open(const std::string& path) {
+        if (!mapped.open(path)) return false;
+        return parse(mapped.data(), mapped.size());
+    }
+
+    const uint8_t* level(size_t i) const { return payload + levels[i].offset; }
+
+    bool upload(Texture& texture) const {
+        std::vector<const unsigned char*> pointers;
+        for (size_t i = 0; i < levels.size(); i++) pointers.push_back(level(i));
+        return texture.uploadLevels(header.width, header.height, pointers.data(), static_cast<int>(pointers.size()));
+    }
+};
+
+//! converted textures named <stem>-<source key>-<content hash>.otex, the key covers the source path and load
+//! options so a changed PNG replaces only its own entry
+class EngineTextureCache {
+public:
+    std::string directory;
+    EngineTextureOptions format;
+    size_t conversions = 0;
+
+    explicit EngineTextureCache(std::string directory, EngineTextureOptions format = {})
+        : directory(std::move(directory)), format(format) {}
+
+    //! path of an up to date .otex for source, converting it first when needed
+    std::string resolve(const std::string& source, const TextureLoadOptions& options = {}) {
+        namespace fs = std::filesystem;
+        MappedFile bytes(source);
+        if (!bytes.isOpen()) return {};
+        std::error_code error;
+        std::string canonical = fs::weakly_canonical(source, error).string();
+        if (error) canonical = fs::absolute(source, error).string();
+        std::string optionKey = options.key();
+        uint64_t key = fnv1a64(reinterpret_cast<const uint8_t*>(canonical.data()), canonical.size());
+        key = fnv1a64(reinterpret_cast<const uint8_t*>(optionKey.data()), optionKey.size(), key);
+        key ^= uint64_t(format.mipmaps) << 1 | uint64_t(format.lz4);
+        uint64_t hash = fnv1a64(bytes.data(), bytes.size(), key);
+
+        char hex[34];
+        std::snprintf(hex, sizeof(hex), "%016llx-%016llx", static_cast<unsigned long long>(key), static_cast<unsigned long long>(hash));
+        std::string prefix = fs::path(source).stem().string() + "-" + std::string(hex, 16) + "-";
+        fs::path target = fs::path(directory) / (prefix + (hex + 17) + ".otex");
+        if (isValid(target, hash)) return target.string();
+
+        TexturePixels pixels = Texture::decode(source, options);
+        if (!pixels) return {};
+        std::vector<uint8_t> file = encodeEngineTexture(pixels.data.get(), pixels.width, pixels.height, format, hash);
+
+        fs::create_directories(directory, error);
+        // written next to the target and renamed over it, readers never see half a file
+        fs::path temp = target;
+        temp += ".tmp" + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+        {
+            std::ofstream out(temp, std::ios::binary);
+            out.write(reinterpret_cast<const char*>(file.data()), file.size());
+            if (!out) {
+                std::cerr << "EngineTextureCache: cannot write " << temp.string() << std::endl;
+                out.close();
+                fs::remove(temp, error);
+                return {};
+            }
+        }
+        fs::rename(temp, target, error);
+        if (error) {
+            std::cerr << "EngineTextureCache: cannot rename into " << target.string() << std::endl;
+            fs::remove(temp, error);
+            return {};
+        }
+        // older contents of this same source and options are dead now
+        for (const auto& entry : fs::directory_iterator(directory, error)) {
+            std::string name = entry.path().filename().string();
+            if (name.size() == prefix.size() + 21 && name.compare(0, prefix.size(), prefix) == 0 && entry.path() != target)
+                fs::remove(entry.path(), error);
+        }
+        conversions++;
+        return target.string();
+    }
+
+    //! a cache hit is only trusted when its header, level table and size add up
+    static bool isValid(const std::filesystem::path& path, uint64_t hash) {
+        std::error_code error;
+        uint64_t size = std::filesystem::file_size(path, error);
+        if (error || size < sizeof(EngineTextureHeader)) return false;
+        EngineTextureHeader header;
+        std::ifstream in(path, std::ios::binary);
+        if (!in.read(reinterpret_cast<char*>(&header), sizeof(header))) return false;
+        return header.magic == EngineTextureHeader::MAGIC && header.version == EngineTextureHeader::VERSION &&
+               header.sourceHash == hash && header.levels > 0 && header.levels <= 32 &&
+               engineTexturePayloadOffset(header.levels) + header.storedSize == size;
+    }
+
+    //! GL thread, maps the cached file and uploads every level from it
+    bool load(Texture& texture, const std::string& source, const TextureLoadOptions& options = {}) {
+        std::string path = resolve(source, options);
+        EngineTextureView view;
+        return !path.empty() && view.open(path) && view.upload(texture);
+    }
+};
+
+#endif
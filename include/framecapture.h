@@ -0,0 +1,354 @@
+#ifndef FRAMECAPTURE_H
+#define FRAMECAPTURE_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <glad/gl.h>
+#include "imageops.h"
+#include "stbi_write.h"
+#include "workerpool.h"
+
+//! "Quite OK Image" format, lossless RGBA at a fraction of the cost of PNG deflate
+namespace qoi {
+
+struct Pixel {
+    uint8_t r = 0, g = 0, b = 0, a = 255;
+    bool operator==(const Pixel& o) const { return r == o.r && g == o.g && b == o.b && a == o.a; }
+};
+
+inline size_t hash(const Pixel& p) { return (p.r * 3 + p.g * 5 + p.b * 7 + p.a * 11) % 64; }
+
+inline void put32(std::vector<uint8_t>& out, uint32_t v) {
+    for (int shift = 24; shift >= 0; shift -= 8) out.push_back(static_cast<uint8_t>(v >> shift));
+}
+
+//! rows top-down RGBA8
+inline std::vector<uint8_t> encode(const uint8_t* rgba, int width, int height) {
+    std::vector<uint8_t> out;
+    size_t count = static_cast<size_t>(width) * height;
+    out.reserve(14 + count * 2 + 8);
+    out.insert(out.end(), {'q', 'o', 'i', 'f'});
+    put32(out, width);
+    put32(out, height);
+    out.push_back(4);
+    out.push_back(0);
+
+    Pixel index[64]{};
+    Pixel prev;
+    int run = 0;
+    for (size_t i = 0; i < count; i++) {
+        const uint8_t* s = rgba + i * 4;
+        Pixel px{s[0], s[1], s[2], s[3]};
+        if (px == prev) {
+            if (++run == 62 || i + 1 == count) {
+                out.push_back(static_cast<uint8_t>(0xc0 | (run - 1)));
+                run = 0;
+            }
+            continue;
+        }
+        if (run > 0) {
+            out.push_back(static_cast<uint8_t>(0xc0 | (run - 1)));
+            run = 0;
+        }
+        size_t slot = hash(px);
+        if (index[slot] == px) {
+            out.push_back(static_cast<uint8_t>(slot));
+        } else if (px.a == prev.a) {
+            index[slot] = px;
+            int vr = static_cast<int8_t>(px.r - prev.r);
+            int vg = static_cast<int8_t>(px.g - prev.g);
+            int vb = static_cast<int8_t>(px.b - prev.b);
+            int vgr = vr - vg, vgb = vb - vg;
+            if (vr > -3 && vr < 2 && vg > -3 && vg < 2 && vb > -3 && vb < 2) {
+                out.push_back(static_cast<uint8_t>(0x40 | (vr + 2) << 4 | (vg + 2) << 2 | (vb + 2)));
+            } else if (vgr > -9 && vgr < 8 && vg > -33 && vg < 32 && vgb > -9 && vgb < 8) {
+                out.push_back(static_cast<uint8_t>(0x80 | (vg + 32)));
+                out.push_back(static_cast<uint8_t>((vgr + 8) << 4 | (vgb + 8)));
+            } else {
+                out.insert(out.end(), {0xfe, px.r, px.g, px.b});
+            }
+        } else {
+            index[slot] = px;
+            out.insert(out.end(), {0xff, px.r, px.g, px.b, px.a});
+        }
+        prev = px;
+    }
+    out.insert(out.end(), {0, 0, 0, 0, 0, 0, 0, 1});
+    return out;
+}
+
+inline bool decode(const uint8_t* data, size_t size, std::vector<uint8_t>& rgba, int& width, int& height) {
+    if (size < 22 || std::memcmp(data, "qoif", 4) != 0) return false;
+    auto get32 = [&](size_t at) { return uint32_t(data[at]) << 24 | uint32_t(data[at + 1]) << 16 | uint32_t(data[at + 2]) << 8 | data[at + 3]; };
+    width = static_cast<int>(get32(4));
+    height = static_cast<int>(get32(8));
+    if (width <= 0 || height <= 0 || static_cast<uint64_t>(width) * height > (1u << 28)) return false;
+    rgba.resize(static_cast<size_t>(width) * height * 4);
+
+    Pixel index[64]{};
+    Pixel px;
+    size_t p = 14, end = size - 8;
+    int run = 0;
+    for (size_t i = 0; i < rgba.size(); i += 4) {
+        if (run > 0) {
+            run--;
+        } else if (p < end) {
+            uint8_t b1 = data[p++];
+            if (b1 == 0xfe) {
+                if (p + 3 > end) return false;
+                px.r = data[p++]; px.g = data[p++]; px.b = data[p++];
+            } else if (b1 == 0xff) {
+                if (p + 4 > end) return false;
+                px.r = data[p++]; px.g = data[p++]; px.b = data[p++]; px.a = data[p++];
+            } else if ((b1 & 0xc0) == 0x00) {
+                px = index[b1];
+            } else if ((b1 & 0xc0) == 0x40) {
+                px.r += ((b1 >> 4) & 3) - 2;
+                px.g += ((b1 >> 2) & 3) - 2;
+                px.b += (b1 & 3) - 2;
+            } else if ((b1 & 0xc0) == 0x80) {
+                if (p >= end) return false;
+                uint8_t b2 = data[p++];
+                int vg = (b1 & 0x3f) - 32;
+                px.r += vg - 8 + ((b2 >> 4) & 15);
+                px.g += vg;
+                px.b += vg - 8 + (b2 & 15);
+            } else {
+                run = b1 & 0x3f;
+            }
+            index[hash(px)] = px;
+        } else {
+            return false;
+        }
+        rgba[i] = px.r; rgba[i + 1] = px.g; rgba[i + 2] = px.b; rgba[i + 3] = px.a;
+    }
+    return true;
+}
+
+}  // namespace qoi
+
+enum class CaptureFormat { PNG, QOI };
+
+//! GPU readback through a ring of pixel pack buffers, encoding runs on workers so the frame never waits on the file
+class FrameCapture {
+    struct Slot {
+        GLuint pbo = 0;
+        GLsync fence = nullptr;
+        size_t capacity = 0;
+        int width = 0, height = 0;
+        std::string path;
+        CaptureFormat format = CaptureFormat::PNG;
+    };
+    std::vector<Slot> slots;
+    size_t nextSlot = 0;
+    std::atomic<size_t> written = 0;
+    std::atomic<size_t> failures = 0;
+    std::atomic<size_t> dropped = 0;
+    std::atomic<size_t> inFlight = 0;
+    //! after the counters, its destructor drains jobs that still bump them
+    WorkerPool workers;
+    size_t stalls = 0;
+
+    std::vector<std::string> screenshotRequests;
+    std::string recordDirectory;
+    int recordEvery = 0;
+    CaptureFormat recordFormat = CaptureFormat::QOI;
+    uint64_t frameIndex = 0;
+    size_t recordedFrames = 0;
+
+    //! GL thread, copies a finished slot out of its buffer and hands it to a worker
+    bool collect(Slot& slot, bool wait) {
+        if (!slot.fence) return true;
+        GLenum status = glClientWaitSync(slot.fence, wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, wait ? 1000000000ull : 0);
+        if (status == GL_TIMEOUT_EXPIRED) return false;
+        glDeleteSync(slot.fence);
+        slot.fence = nullptr;
+        if (status == GL_WAIT_FAILED) {
+            failures++;
+            return true;
+        }
+        size_t bytes = static_cast<size_t>(slot.width) * slot.height * 4;
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+        const void* mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, bytes, GL_MAP_READ_BIT);
+        if (mapped) {
+            std::vector<uint8_t> pixels(static_cast<const uint8_t*>(mapped), static_cast<const uint8_t*>(mapped) + bytes);
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+            submitEncode(std::move(pixels), slot.width, slot.height, slot.path, slot.format);
+        } else {
+            failures++;
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        return true;
+    }
+
+    //! next ring slot bound as the pack buffer, a full ring waits on its oldest capture instead of dropping one
+    Slot& acquire(int width, int height, const std::string& path, CaptureFormat format) {
+        Slot& slot = slots[nextSlot];
+        nextSlot = (nextSlot + 1) % slots.size();
+        if (slot.fence && !collect(slot, false)) {
+            stalls++;
+            while (!collect(slot, true)) {}
+        }
+        if (slot.pbo == 0) glGenBuffers(1, &slot.pbo);
+        size_t bytes = static_cast<size_t>(width) * height * 4;
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+        if (slot.capacity < bytes) {
+            glBufferData(GL_PIXEL_PACK_BUFFER, bytes, nullptr, GL_STREAM_READ);
+            slot.capacity = bytes;
+        }
+        glPixelStorei(GL_PACK_ALIGNMENT, 4);
+        slot.width = width;
+        slot.height = height;
+        slot.path = path;
+        slot.format = format;
+        return slot;
+    }
+
+    void fence(Slot& slot) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+public:
+    //! encodes queued or running before submitEncode pushes back, ring depth times workers by default, 0 is unbounded
+    size_t maxPendingEncodes;
+    //! past the cap a frame is dropped and counted instead of the caller waiting for a worker
+    bool dropWhenBusy = false;
+
+    //! three slots cover the usual two frames of driver latency
+    explicit FrameCapture(size_t slotCount = 3, size_t threads = 1)
+        : slots(slotCount > 0 ? slotCount : 1), workers(threads), maxPendingEncodes(slots.size() * workers.threadCount()) {}
+    FrameCapture(const FrameCapture&) = delete;
+    FrameCapture& operator=(const FrameCapture&) = delete;
+
+    static CaptureFormat formatFor(const std::string& path) {
+        return std::filesystem::path(path).extension() == ".qoi" ? CaptureFormat::QOI : CaptureFormat::PNG;
+    }
+
+    //! flips GL's bottom-up rows in place and writes the file, any thread
+    static bool writeImage(std::vector<uint8_t>& pixels, int width, int height, const std::string& path, CaptureFormat format) {
+        size_t stride = static_cast<size_t>(width) * 4;
+        for (int y = 0; y < height / 2; y++) {
+            imageops::swapRows(pixels.data() + y * stride, pixels.data() + (height - 1 - y) * stride, stride);
+        }
+        if (format == CaptureFormat::PNG) {
+            return stbi_write_png(path.c_str(), width, height, 4, pixels.data(), static_cast<int>(stride)) != 0;
+        }
+        std::vector<uint8_t> encoded = qoi::encode(pixels.data(), width, height);
+        std::ofstream out(path, std::ios::binary);
+        out.write(reinterpret_cast<const char*>(encoded.data()), encoded.size());
+        return static_cast<bool>(out);
+    }
+
+    //! bottom-up RGBA8 straight from a readback, flipped and encoded on a worker. false when the frame was dropped
+    bool submitEncode(std::vector<uint8_t>&& pixels, int width, int height, std::string path, CaptureFormat format) {
+        if (maxPendingEncodes > 0 && inFlight >= maxPendingEncodes) {
+            if (dropWhenBusy) {
+                dropped++;
+                return false;
+            }
+            while (inFlight >= maxPendingEncodes) std::this_thread::yield();
+        }
+        inFlight++;
+        auto job = std::make_shared<std::vector<uint8_t>>(std::move(pixels));
+        workers.submit([this, job, width, height, path = std::move(path), format] {
+            if (writeImage(*job, width, height, path, format)) {
+                written++;
+            } else {
+                failures++;
+                std::cerr << "FrameCapture: failed to write " << path << std::endl;
+            }
+            inFlight--;
+        });
+        return true;
+    }
+
+    //! GL thread, queues a readback of level 0 of a texture
+    void captureTexture(GLuint textureID, int width, int height, const std::string& path) {
+        Slot& slot = acquire(width, height, path, formatFor(path));
+        glBindTexture(GL_TEXTURE_2D, textureID);
+        glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        fence(slot);
+    }
+
+    //! GL thread, queues a readback of the bound read framebuffer
+    void captureFramebuffer(int x, int y, int width, int height, const std::string& path) {
+        Slot& slot = acquire(width, height, path, formatFor(path));
+        glReadPixels(x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        fence(slot);
+    }
+
+    //! taken from the framebuffer at the next endFrame()
+    void requestScreenshot(const std::string& path) { screenshotRequests.push_back(path); }
+
+    //! writes every nth frame to directory/frame_000000.qoi (or .png) until stopRecording()
+    void startRecording(const std::string& directory, int everyNthFrame = 1, CaptureFormat format = CaptureFormat::QOI) {
+        std::error_code error;
+        std::filesystem::create_directories(directory, error);
+        recordDirectory = directory;
+        recordEvery = (std::max)(1, everyNthFrame);
+        recordFormat = format;
+        recordedFrames = 0;
+    }
+    void stopRecording() { recordEvery = 0; }
+    bool isRecording() const { return recordEvery > 0; }
+
+    //! GL thread, once per frame after drawing and before the swap
+    void endFrame(int width, int height) {
+        poll();
+        for (const auto& path : screenshotRequests) captureFramebuffer(0, 0, width, height, path);
+        screenshotRequests.clear();
+        if (recordEvery > 0 && frameIndex % recordEvery == 0) {
+            char name[32];
+            std::snprintf(name, sizeof(name), "frame_%06zu.%s", recordedFrames++, recordFormat == CaptureFormat::QOI ? "qoi" : "png");
+            captureFramebuffer(0, 0, width, height, (std::filesystem::path(recordDirectory) / name).string());
+        }
+        frameIndex++;
+    }
+
+    //! GL thread, hands every readback the GPU has finished to the workers without blocking
+    void poll() {
+        for (auto& slot : slots) collect(slot, false);
+    }
+
+    //! GL thread, blocks until every queued capture is on disk
+    void finish() {
+        for (size_t i = 0; i < slots.size(); i++) {
+            Slot& slot = slots[(nextSlot + i) % slots.size()];
+            while (!collect(slot, true)) {}
+        }
+        while (inFlight > 0) std::this_thread::yield();
+    }
+
+    //! GL thread, finishes outstanding captures and frees the buffers
+    void dispose() {
+        finish();
+        for (auto& slot : slots) {
+            if (slot.pbo) glDeleteBuffers(1, &slot.pbo);
+            slot.pbo = 0;
+            slot.capacity = 0;
+        }
+    }
+
+    size_t writtenCount() const { return written; }
+    size_t failureCount() const { return failures; }
+    //! frames dropped because maxPendingEncodes was reached with dropWhenBusy set
+    size_t droppedCount() const { return dropped; }
+    //! captures that found the ring full and waited on the GPU
+    size_t stallCount() const { return stalls; }
+    //! encodes queued or running on the workers
+    size_t pendingEncodes() const { return inFlight; }
+};
+
+#endif
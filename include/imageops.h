@@ -0,0 +1,326 @@
+#ifndef IMAGEOPS_H
+#define IMAGEOPS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define OMNIX_IMAGEOPS_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define OMNIX_TARGET_AVX2
+#else
+#define OMNIX_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+//! RGBA8 post-processing with scalar, SSE2 and AVX2 paths that give identical bytes
+namespace imageops {
+
+enum class SimdLevel { SCALAR, SSE2, AVX2 };
+
+inline SimdLevel detectSimd() {
+#if defined(OMNIX_IMAGEOPS_X86)
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] >= 7) {
+        __cpuidex(info, 1, 0);
+        bool osxsave = (info[2] & (1 << 27)) != 0, avx = (info[2] & (1 << 28)) != 0;
+        if (osxsave && avx && (_xgetbv(0) & 6) == 6) {
+            __cpuidex(info, 7, 0);
+            if (info[1] & (1 << 5)) return SimdLevel::AVX2;
+        }
+    }
+    return SimdLevel::SSE2;
+#else
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return SimdLevel::AVX2;
+    return __builtin_cpu_supports("sse2") ? SimdLevel::SSE2 : SimdLevel::SCALAR;
+#endif
+#else
+    return SimdLevel::SCALAR;
+#endif
+}
+
+//! the best level this CPU runs, probed once
+inline SimdLevel bestSimd() {
+    static const SimdLevel level = detectSimd();
+    return level;
+}
+
+inline const char* simdName(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::AVX2: return "avx2";
+        case SimdLevel::SSE2: return "sse2";
+        default: return "scalar";
+    }
+}
+
+// x / 255 rounded, exact for every product of two bytes
+inline uint8_t div255(unsigned x) {
+    x += 128;
+    return static_cast<uint8_t>((x + (x >> 8)) >> 8);
+}
+
+namespace detail {
+
+inline uint32_t packRGBA(const uint8_t c[4]) {
+    return uint32_t(c[0]) | uint32_t(c[1]) << 8 | uint32_t(c[2]) << 16 | uint32_t(c[3]) << 24;
+}
+
+inline void colorKeyScalar(uint8_t* px, size_t count, const uint8_t key[3], const uint8_t value[4]) {
+    for (size_t i = 0; i < count; i++, px += 4) {
+        if (px[0] == key[0] && px[1] == key[1] && px[2] == key[2]) std::memcpy(px, value, 4);
+    }
+}
+inline void premultiplyScalar(uint8_t* px, size_t count) {
+    for (size_t i = 0; i < count; i++, px += 4) {
+        unsigned a = px[3];
+        px[0] = div255(px[0] * a);
+        px[1] = div255(px[1] * a);
+        px[2] = div255(px[2] * a);
+    }
+}
+inline void swizzleScalar(uint8_t* px, size_t count, const uint8_t order[4]) {
+    for (size_t i = 0; i < count; i++, px += 4) {
+        uint8_t src[4] = {px[0], px[1], px[2], px[3]};
+        for (int c = 0; c < 4; c++) px[c] = src[order[c]];
+    }
+}
+inline void swapRowsScalar(uint8_t* a, uint8_t* b, size_t bytes) {
+    uint8_t tmp[256];
+    while (bytes > 0) {
+        size_t n = bytes < sizeof(tmp) ? bytes : sizeof(tmp);
+        std::memcpy(tmp, a, n);
+        std::memcpy(a, b, n);
+        std::memcpy(b, tmp, n);
+        a += n;
+        b += n;
+        bytes -= n;
+    }
+}
+
+#if defined(OMNIX_IMAGEOPS_X86)
+inline void colorKeySSE2(uint8_t* px, size_t count, const uint8_t key[3], const uint8_t value[4]) {
+    uint8_t keyBytes[4] = {key[0], key[1], key[2], 0};
+    const __m128i rgbMask = _mm_set1_epi32(0x00FFFFFF);
+    const __m128i keyV = _mm_set1_epi32(static_cast<int>(packRGBA(keyBytes)));
+    const __m128i valueV = _mm_set1_epi32(static_cast<int>(packRGBA(value)));
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(px + i * 4));
+        __m128i eq = _mm_cmpeq_epi32(_mm_and_si128(v, rgbMask), keyV);
+        v = _mm_or_si128(_mm_and_si128(eq, valueV), _mm_andnot_si128(eq, v));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(px + i * 4), v);
+    }
+    colorKeyScalar(px + i * 4, count - i, key, value);
+}
+
+// two pixels per 16 bit half, alpha broadcast to r, g, b and 255 in the alpha lane keeps alpha
+inline __m128i premultiplyHalfSSE2(__m128i half, __m128i alphaLane) {
+    __m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(half, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+    a = _mm_or_si128(_mm_andnot_si128(alphaLane, a), _mm_and_si128(alphaLane, _mm_set1_epi16(255)));
+    __m128i t = _mm_add_epi16(_mm_mullo_epi16(half, a), _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+inline void premultiplySSE2(uint8_t* px, size_t count) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i alphaLane = _mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(px + i * 4));
+        __m128i lo = premultiplyHalfSSE2(_mm_unpacklo_epi8(v, zero), alphaLane);
+        __m128i hi = premultiplyHalfSSE2(_mm_unpackhi_epi8(v, zero), alphaLane);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(px + i * 4), _mm_packus_epi16(lo, hi));
+    }
+    premultiplyScalar(px + i * 4, count - i);
+}
+
+inline void swizzleSSE2(uint8_t* px, size_t count, const uint8_t order[4]) {
+    const __m128i byteMask = _mm_set1_epi32(0xFF);
+    __m128i from[4], to[4];
+    for (int c = 0; c < 4; c++) {
+        from[c] = _mm_cvtsi32_si128(order[c] * 8);
+        to[c] = _mm_cvtsi32_si128(c * 8);
+    }
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(px + i * 4));
+        __m128i out = _mm_setzero_si128();
+        for (int c = 0; c < 4; c++) {
+            __m128i channel = _mm_and_si128(_mm_srl_epi32(v, from[c]), byteMask);
+            out = _mm_or_si128(out, _mm_sll_epi32(channel, to[c]));
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(px + i * 4), out);
+    }
+    swizzleScalar(px + i * 4, count - i, order);
+}
+
+inline void swapRowsSSE2(uint8_t* a, uint8_t* b, size_t bytes) {
+    size_t i = 0;
+    for (; i + 16 <= bytes; i += 16) {
+        __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+        __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(a + i), vb);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(b + i), va);
+    }
+    swapRowsScalar(a + i, b + i, bytes - i);
+}
+
+OMNIX_TARGET_AVX2 inline void colorKeyAVX2(uint8_t* px, size_t count, const uint8_t key[3], const uint8_t value[4]) {
+    uint8_t keyBytes[4] = {key[0], key[1], key[2], 0};
+    const __m256i rgbMask = _mm256_set1_epi32(0x00FFFFFF);
+    const __m256i keyV = _mm256_set1_epi32(static_cast<int>(packRGBA(keyBytes)));
+    const __m256i valueV = _mm256_set1_epi32(static_cast<int>(packRGBA(value)));
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(px + i * 4));
+        __m256i eq = _mm256_cmpeq_epi32(_mm256_and_si256(v, rgbMask), keyV);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(px + i * 4), _mm256_blendv_epi8(v, valueV, eq));
+    }
+    colorKeySSE2(px + i * 4, count - i, key, value);
+}
+
+OMNIX_TARGET_AVX2 inline __m256i premultiplyHalfAVX2(__m256i half, __m256i alphaLane) {
+    __m256i a = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(half, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+    a = _mm256_blendv_epi8(a, _mm256_set1_epi16(255), alphaLane);
+    __m256i t = _mm256_add_epi16(_mm256_mullo_epi16(half, a), _mm256_set1_epi16(128));
+    return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+}
+OMNIX_TARGET_AVX2 inline void premultiplyAVX2(uint8_t* px, size_t count) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i alphaLane = _mm256_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(px + i * 4));
+        // unpack and pack both work per 128 bit lane, so the pixel order survives the round trip
+        __m256i lo = premultiplyHalfAVX2(_mm256_unpacklo_epi8(v, zero), alphaLane);
+        __m256i hi = premultiplyHalfAVX2(_mm256_unpackhi_epi8(v, zero), alphaLane);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(px + i * 4), _mm256_packus_epi16(lo, hi));
+    }
+    premultiplySSE2(px + i * 4, count - i);
+}
+
+OMNIX_TARGET_AVX2 inline void swizzleAVX2(uint8_t* px, size_t count, const uint8_t order[4]) {
+    alignas(32) int8_t shuffle[32];
+    for (int p = 0; p < 8; p++) {
+        for (int c = 0; c < 4; c++) shuffle[p * 4 + c] = static_cast<int8_t>((p % 4) * 4 + order[c]);
+    }
+    const __m256i mask = _mm256_load_si256(reinterpret_cast<const __m256i*>(shuffle));
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(px + i * 4));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(px + i * 4), _mm256_shuffle_epi8(v, mask));
+    }
+    swizzleSSE2(px + i * 4, count - i, order);
+}
+
+OMNIX_TARGET_AVX2 inline void swapRowsAVX2(uint8_t* a, uint8_t* b, size_t bytes) {
+    size_t i = 0;
+    for (; i + 32 <= bytes; i += 32) {
+        __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+        __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(a + i), vb);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(b + i), va);
+    }
+    swapRowsSSE2(a + i, b + i, bytes - i);
+}
+#endif
+
+}  // namespace detail
+
+inline void colorKey(uint8_t* px, size_t count, const uint8_t key[3], const uint8_t value[4], SimdLevel level = bestSimd()) {
+#if defined(OMNIX_IMAGEOPS_X86)
+    if (level == SimdLevel::AVX2) return detail::colorKeyAVX2(px, count, key, value);
+    if (level == SimdLevel::SSE2) return detail::colorKeySSE2(px, count, key, value);
+#endif
+    detail::colorKeyScalar(px, count, key, value);
+}
+inline void premultiply(uint8_t* px, size_t count, SimdLevel level = bestSimd()) {
+#if defined(OMNIX_IMAGEOPS_X86)
+    if (level == SimdLevel::AVX2) return detail::premultiplyAVX2(px, count);
+    if (level == SimdLevel::SSE2) return detail::premultiplySSE2(px, count);
+#endif
+    detail::premultiplyScalar(px, count);
+}
+//! dst channel c takes src channel order[c], {2,1,0,3} turns RGBA into BGRA
+inline void swizzle(uint8_t* px, size_t count, const uint8_t order[4], SimdLevel level = bestSimd()) {
+#if defined(OMNIX_IMAGEOPS_X86)
+    if (level == SimdLevel::AVX2) return detail::swizzleAVX2(px, count, order);
+    if (level == SimdLevel::SSE2) return detail::swizzleSSE2(px, count, order);
+#endif
+    detail::swizzleScalar(px, count, order);
+}
+inline void swapRows(uint8_t* a, uint8_t* b, size_t bytes, SimdLevel level = bestSimd()) {
+#if defined(OMNIX_IMAGEOPS_X86)
+    if (level == SimdLevel::AVX2) return detail::swapRowsAVX2(a, b, bytes);
+    if (level == SimdLevel::SSE2) return detail::swapRowsSSE2(a, b, bytes);
+#endif
+    detail::swapRowsScalar(a, b, bytes);
+}
+
+//! ordered per-pixel ops plus an optional vertical flip, run row by row in one pass over the image
+class Pipeline {
+    struct Op {
+        enum Kind { COLOR_KEY, PREMULTIPLY, SWIZZLE } kind;
+        uint8_t key[3];
+        uint8_t value[4];
+        uint8_t order[4];
+    };
+    std::vector<Op> ops;
+    bool flip = false;
+
+    void runRow(uint8_t* row, size_t width, SimdLevel level) const {
+        for (const Op& op : ops) {
+            switch (op.kind) {
+                case Op::COLOR_KEY: imageops::colorKey(row, width, op.key, op.value, level); break;
+                case Op::PREMULTIPLY: imageops::premultiply(row, width, level); break;
+                case Op::SWIZZLE: imageops::swizzle(row, width, op.order, level); break;
+            }
+        }
+    }
+
+public:
+    Pipeline& colorKey(uint8_t r, uint8_t g, uint8_t b, const uint8_t value[4]) {
+        Op op{Op::COLOR_KEY, {r, g, b}, {value[0], value[1], value[2], value[3]}, {}};
+        ops.push_back(op);
+        return *this;
+    }
+    Pipeline& premultiply() {
+        ops.push_back({Op::PREMULTIPLY, {}, {}, {}});
+        return *this;
+    }
+    Pipeline& swizzle(uint8_t r, uint8_t g, uint8_t b, uint8_t a) {
+        ops.push_back({Op::SWIZZLE, {}, {}, {r, g, b, a}});
+        return *this;
+    }
+    Pipeline& flipVertically(bool enabled = true) {
+        flip = enabled;
+        return *this;
+    }
+    bool empty() const { return ops.empty() && !flip; }
+
+    void run(uint8_t* pixels, size_t width, size_t height, SimdLevel level = bestSimd()) const {
+        size_t stride = width * 4;
+        if (!flip) {
+            for (size_t y = 0; y < height; y++) runRow(pixels + y * stride, width, level);
+            return;
+        }
+        for (size_t y = 0; y < height / 2; y++) {
+            uint8_t* top = pixels + y * stride;
+            uint8_t* bottom = pixels + (height - 1 - y) * stride;
+            runRow(top, width, level);
+            runRow(bottom, width, level);
+            swapRows(top, bottom, stride, level);
+        }
+        if (height % 2) runRow(pixels + (height / 2) * stride, width, level);
+    }
+};
+
+}  // namespace imageops
+
+#endif
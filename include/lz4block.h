@@ -0,0 +1,116 @@
+#ifndef LZ4BLOCK_H
+#define LZ4BLOCK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+//! LZ4 block format, enough of it to pack textures and archives without another dependency
+namespace lz4 {
+
+inline uint32_t read32(const uint8_t* p) {
+    uint32_t v;
+    std::memcpy(&v, p, 4);
+    return v;
+}
+
+inline void putLength(std::vector<uint8_t>& out, size_t length) {
+    while (length >= 255) {
+        out.push_back(255);
+        length -= 255;
+    }
+    out.push_back(static_cast<uint8_t>(length));
+}
+
+inline void putSequence(std::vector<uint8_t>& out, const uint8_t* literals, size_t literalLength, size_t offset, size_t matchLength) {
+    size_t tokenMatch = matchLength >= 4 ? matchLength - 4 : 0;
+    out.push_back(static_cast<uint8_t>((literalLength < 15 ? literalLength : 15) << 4 | (tokenMatch < 15 ? tokenMatch : 15)));
+    if (literalLength >= 15) putLength(out, literalLength - 15);
+    out.insert(out.end(), literals, literals + literalLength);
+    if (matchLength == 0) return;
+    out.push_back(static_cast<uint8_t>(offset));
+    out.push_back(static_cast<uint8_t>(offset >> 8));
+    if (tokenMatch >= 15) putLength(out, tokenMatch - 15);
+}
+
+//! greedy single-probe compressor, the output decodes with any LZ4 block decoder
+inline std::vector<uint8_t> compress(const uint8_t* src, size_t size) {
+    constexpr int hashBits = 14;
+    constexpr size_t minMatch = 4, lastLiterals = 5, matchLimit = 12;
+    std::vector<uint8_t> out;
+    out.reserve(size / 2 + 16);
+    // positions are stored plus one so zero means empty
+    std::vector<uint32_t> table(size_t(1) << hashBits, 0);
+
+    size_t anchor = 0, i = 0;
+    size_t lastMatchStart = size > matchLimit ? size - matchLimit : 0;
+    while (i < lastMatchStart) {
+        uint32_t sequence = read32(src + i);
+        uint32_t hash = (sequence * 2654435761u) >> (32 - hashBits);
+        size_t candidate = table[hash];
+        table[hash] = static_cast<uint32_t>(i + 1);
+        if (candidate == 0 || i - (candidate - 1) > 65535 || read32(src + candidate - 1) != sequence) {
+            i++;
+            continue;
+        }
+        size_t ref = candidate - 1;
+        size_t length = minMatch;
+        while (i + length < size - lastLiterals && src[ref + length] == src[i + length]) length++;
+        putSequence(out, src + anchor, i - anchor, i - ref, length);
+        i += length;
+        anchor = i;
+    }
+    putSequence(out, src + anchor, size - anchor, 0, 0);
+    return out;
+}
+
+//! false on malformed input or when the output is not exactly dstSize bytes
+inline bool decompress(const uint8_t* src, size_t size, uint8_t* dst, size_t dstSize) {
+    size_t ip = 0, op = 0;
+    auto readLength = [&](size_t length) {
+        if (length != 15) return length;
+        uint8_t more;
+        do {
+            if (ip >= size) return SIZE_MAX;
+            more = src[ip++];
+            length += more;
+        } while (more == 255);
+        return length;
+    };
+    while (ip < size) {
+        uint8_t token = src[ip++];
+        size_t literalLength = readLength(token >> 4);
+        if (literalLength == SIZE_MAX || ip + literalLength > size || op + literalLength > dstSize) return false;
+        std::memcpy(dst + op, src + ip, literalLength);
+        ip += literalLength;
+        op += literalLength;
+        if (ip == size) break;
+
+        if (ip + 2 > size) return false;
+        size_t offset = src[ip] | size_t(src[ip + 1]) << 8;
+        ip += 2;
+        size_t matchLength = readLength(token & 15);
+        if (matchLength == SIZE_MAX || offset == 0 || offset > op) return false;
+        matchLength += 4;
+        if (op + matchLength > dstSize) return false;
+        // overlapping copies repeat the last offset bytes, byte order matters here
+        const uint8_t* match = dst + op - offset;
+        for (size_t k = 0; k < matchLength; k++) dst[op + k] = match[k];
+        op += matchLength;
+    }
+    return op == dstSize;
+}
+
+}  // namespace lz4
+
+//! FNV-1a, stable across platforms so it can key files on disk
+inline uint64_t fnv1a64(const uint8_t* data, size_t size, uint64_t hash = 1469598103934665603ull) {
+    for (size_t i = 0; i < size; i++) {
+        hash ^= data[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+#endif
@@ -1,14 +1,84 @@
 #ifndef TEXTURE_H
 #define TEXTURE_H
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <iterator>
+#include <list>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 #include <glad/gl.h>
 #include <stb_image.h>
 #include <iostream>
+#include "imageops.h"
+#include "max.h"
+#include "workerpool.h"
+
+struct TextureLoadOptions {
+    bool flipVertically = true;
+    //! pixels with this rgb are replaced by force_data_VALUE, all zero disables it
+    max::vec4<unsigned char> force_data_RGBA{};
+    max::vec4<unsigned char> force_data_VALUE{};
+    bool premultiplyAlpha = false;
+
+    //! the post-decode work these options ask for, flipping included
+    imageops::Pipeline pipeline() const {
+        imageops::Pipeline ops;
+        if (force_data_RGBA.x + force_data_RGBA.y + force_data_RGBA.z > 0) {
+            const uint8_t value[4] = {force_data_VALUE.x, force_data_VALUE.y, force_data_VALUE.z, force_data_VALUE.w};
+            ops.colorKey(force_data_RGBA.x, force_data_RGBA.y, force_data_RGBA.z, value);
+        }
+        if (premultiplyAlpha) ops.premultiply();
+        return ops.flipVertically(flipVertically);
+    }
+
+    //! everything that changes the decoded bytes, for cache keys
+    std::string key() const {
+        char buffer[64];
+        std::snprintf(buffer, sizeof(buffer), "|%d%d|%d,%d,%d|%d,%d,%d,%d", flipVertically, premultiplyAlpha,
+                      force_data_RGBA.x, force_data_RGBA.y, force_data_RGBA.z,
+                      force_data_VALUE.x, force_data_VALUE.y, force_data_VALUE.z, force_data_VALUE.w);
+        return buffer;
+    }
+};
+
+//! decoded RGBA8 image, produced on any thread and uploaded on the GL thread
+struct TexturePixels {
+    int width = 0;
+    int height = 0;
+    std::unique_ptr<unsigned char, void (*)(void*)> data{nullptr, stbi_image_free};
+
+    explicit operator bool() const { return data != nullptr; }
+    //! what the upload takes in VRAM, the full mip chain adds a third
+    size_t vramBytes() const { return static_cast<size_t>(width) * height * 4 * 4 / 3; }
+};
 
 class Texture {
 public:
     Texture() : textureID(0), width(0), height(0), channels(0) {}
+    // a copy would delete the GL name twice, ownership only moves
+    Texture(const Texture&) = delete;
+    Texture& operator=(const Texture&) = delete;
+    Texture(Texture&& other) noexcept : textureID(other.textureID), width(other.width), height(other.height), channels(other.channels) {
+        other.textureID = 0;
+    }
+    Texture& operator=(Texture&& other) noexcept {
+        if (this != &other) {
+            if (textureID != 0) glDeleteTextures(1, &textureID);
+            textureID = other.textureID;
+            width = other.width;
+            height = other.height;
+            channels = other.channels;
+            other.textureID = 0;
+        }
+        return *this;
+    }
 
     ~Texture() {
         if (textureID != 0) {
@@ -16,50 +86,87 @@ public:
         }
     }
 
-    bool loadFromFile(const std::string& path, bool flipVertically = true,
-                      max::vec4<unsigned char> force_data_RGBA = {}, max::vec4<unsigned char> force_data_VALUE = {}) {
-        if (flipVertically) {
-            stbi_set_flip_vertically_on_load(1);
-        }
-    
-        unsigned char* data = stbi_load(path.c_str(), &width, &height, &channels, STBI_rgb_alpha);
-        if (!data) {
+    //! decode plus the option pipeline, touches no GL and no stbi flip state
+    static TexturePixels decode(const std::string& path, const TextureLoadOptions& options) {
+        TexturePixels out;
+        int channels = 0;
+        out.data.reset(stbi_load(path.c_str(), &out.width, &out.height, &channels, STBI_rgb_alpha));
+        if (!out.data) {
             std::cerr << "Failed to load image: " << path << std::endl;
-            return false;
-        }
-    
-        channels = 4; 
-        if (force_data_RGBA.x + force_data_RGBA.y + force_data_RGBA.z > 0) {
-            for (int i = 0; i < width * height * 4; i += 4) {
-                unsigned char r = data[i];
-                unsigned char g = data[i + 1];
-                unsigned char b = data[i + 2];
-                if (r == force_data_RGBA.x && g == force_data_RGBA.y && b == force_data_RGBA.z) {
-                    data[i] = force_data_VALUE.x; 
-                    data[i + 1] = force_data_VALUE.y; 
-                    data[i + 2] = force_data_VALUE.z; 
-                    data[i + 3] = force_data_VALUE.w; 
-                }
-            }
+            return out;
         }
-    
+
+        options.pipeline().run(out.data.get(), out.width, out.height);
+        return out;
+    }
+
+    bool upload(const TexturePixels& pixels) {
+        if (!pixels) return false;
+        width = pixels.width;
+        height = pixels.height;
+        channels = 4;
         GLenum format = GL_RGBA;
-    
-        glGenTextures(1, &textureID);
+
+        if (textureID == 0) glGenTextures(1, &textureID);
         glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, pixels.data.get());
         glGenerateMipmap(GL_TEXTURE_2D);
-    
+
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    
-        stbi_image_free(data);
+
         glBindTexture(GL_TEXTURE_2D, 0);
         return true;
     }
 
+    //! uploads a prebuilt mip chain, level i is max(1, width >> i) by max(1, height >> i) RGBA8
+    bool uploadLevels(int levelWidth, int levelHeight, const unsigned char* const* levels, int levelCount) {
+        if (levelCount <= 0) return false;
+        width = levelWidth;
+        height = levelHeight;
+        channels = 4;
+
+        if (textureID == 0) glGenTextures(1, &textureID);
+        glBindTexture(GL_TEXTURE_2D, textureID);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        for (int level = 0; level < levelCount; level++) {
+            int w = (std::max)(1, width >> level), h = (std::max)(1, height >> level);
+            glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, levels[level]);
+        }
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levelCount - 1);
+
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, levelCount > 1 ? GL_NEAREST_MIPMAP_NEAREST : GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+        glBindTexture(GL_TEXTURE_2D, 0);
+        return true;
+    }
+
+    //! flipVertically=false keeps the image top-down
+    bool loadFromFile(const std::string& path, bool flipVertically = true,
+                      max::vec4<unsigned char> force_data_RGBA = {}, max::vec4<unsigned char> force_data_VALUE = {}) {
+        return upload(decode(path, {flipVertically, force_data_RGBA, force_data_VALUE}));
+    }
+
+    //! 2x2 magenta checker shown while a texture streams in, created on first use on the GL thread
+    static GLuint placeholder() {
+        static GLuint id = 0;
+        if (id == 0) {
+            const unsigned char pixels[16] = {255, 0, 255, 255, 0, 0, 0, 255, 0, 0, 0, 255, 255, 0, 255, 255};
+            glGenTextures(1, &id);
+            glBindTexture(GL_TEXTURE_2D, id);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 2, 2, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glBindTexture(GL_TEXTURE_2D, 0);
+        }
+        return id;
+    }
+
     void bind(GLenum textureUnit = GL_TEXTURE0) const {
         glActiveTexture(textureUnit);
         glBindTexture(GL_TEXTURE_2D, textureID);
@@ -80,4 +187,239 @@ private:
     int channels;
 };
 
-#endif // TEXTURE_H
\ No newline at end of file
+//! what an async load hands back, the placeholder stands in until ready() turns true
+class TextureHandle {
+public:
+    struct State {
+        std::string path;
+        Texture texture;
+        std::atomic<bool> ready = false;
+        std::atomic<bool> failed = false;
+        size_t vramBytes = 0;
+    };
+
+    TextureHandle() = default;
+    explicit TextureHandle(std::shared_ptr<State> state) : state(std::move(state)) {}
+
+    bool valid() const { return state != nullptr; }
+    bool ready() const { return state && state->ready; }
+    bool failed() const { return state && state->failed; }
+    //! GL thread only, it may create the placeholder
+    GLuint getID() const { return ready() ? state->texture.getID() : Texture::placeholder(); }
+    int getWidth() const { return ready() ? state->texture.getWidth() : 0; }
+    int getHeight() const { return ready() ? state->texture.getHeight() : 0; }
+    const std::string& getPath() const { return state->path; }
+    const Texture* get() const { return ready() ? &state->texture : nullptr; }
+    //! handles sharing this texture, the cache holds one of them
+    long useCount() const { return state.use_count(); }
+
+private:
+    friend class TextureCache;
+    std::shared_ptr<State> state;
+};
+
+//! decodes on worker threads, pumpUploads() moves finished images to GL under a time budget
+class AsyncTextureLoader {
+    struct Finished {
+        std::shared_ptr<TextureHandle::State> state;
+        TexturePixels pixels;
+    };
+
+    WorkerPool workers;
+    std::mutex finishedMutex;
+    std::deque<Finished> finished;
+    std::atomic<size_t> decoding = 0;
+    size_t loads = 0;
+    size_t uploads = 0;
+
+public:
+    //! the GL stage, swapped out by tests that run without a context
+    std::function<bool(Texture&, const TexturePixels&)> uploadFnc = [](Texture& texture, const TexturePixels& pixels) {
+        return texture.upload(pixels);
+    };
+
+    explicit AsyncTextureLoader(size_t threadCount = 0) : workers(threadCount) {}
+    AsyncTextureLoader(const AsyncTextureLoader&) = delete;
+    AsyncTextureLoader& operator=(const AsyncTextureLoader&) = delete;
+
+    ~AsyncTextureLoader() {
+        workers.stop();
+    }
+
+    TextureHandle load(const std::string& path, const TextureLoadOptions& options = {}) {
+        auto state = std::make_shared<TextureHandle::State>();
+        state->path = path;
+        loads++;
+        decoding++;
+        // the state moves on with the pixels, the last reference must never be dropped on a worker without GL
+        workers.submit([this, state, options]() mutable {
+            TexturePixels pixels = Texture::decode(state->path, options);
+            {
+                std::lock_guard<std::mutex> lock(finishedMutex);
+                finished.push_back({std::move(state), std::move(pixels)});
+            }
+            decoding--;
+        });
+        return TextureHandle(state);
+    }
+
+    //! GL thread, uploads until budgetMs is spent, at least one image per call so the queue always drains
+    size_t pumpUploads(double budgetMs = 2.0) {
+        auto start = std::chrono::steady_clock::now();
+        size_t count = 0;
+        while (true) {
+            Finished next;
+            {
+                std::lock_guard<std::mutex> lock(finishedMutex);
+                if (finished.empty()) break;
+                next = std::move(finished.front());
+                finished.pop_front();
+            }
+            if (next.pixels && uploadFnc(next.state->texture, next.pixels)) {
+                next.state->vramBytes = next.pixels.vramBytes();
+                next.state->ready = true;
+            } else {
+                next.state->failed = true;
+            }
+            count++;
+            std::chrono::duration<double, std::milli> spent = std::chrono::steady_clock::now() - start;
+            if (spent.count() >= budgetMs) break;
+        }
+        uploads += count;
+        return count;
+    }
+
+    //! blocks the GL thread until every queued load is uploaded or failed
+    void finish() {
+        while (pending() > 0) {
+            if (pumpUploads(1e9) == 0) std::this_thread::yield();
+        }
+    }
+
+    //! loads still decoding or waiting for upload
+    size_t pending() {
+        std::lock_guard<std::mutex> lock(finishedMutex);
+        return decoding + finished.size();
+    }
+    size_t loadCount() const { return loads; }
+    size_t uploadCount() const { return uploads; }
+};
+
+//! one texture per (path, options), shared through refcounted handles.
+//! over the VRAM budget the least recently requested textures nobody else holds are dropped
+class TextureCache {
+    struct Entry {
+        std::shared_ptr<TextureHandle::State> state;
+        std::list<std::string>::iterator order;
+    };
+    std::unordered_map<std::string, Entry> entries;
+    //! keys, least recently requested first
+    std::list<std::string> lru;
+    AsyncTextureLoader* loader;
+
+public:
+    struct Stats {
+        size_t hits = 0;
+        size_t misses = 0;
+        size_t evictions = 0;
+        size_t residentBytes = 0;
+    };
+
+    size_t budgetBytes;
+    //! GL stage of synchronous loads, same role as AsyncTextureLoader::uploadFnc
+    std::function<bool(Texture&, const TexturePixels&)> uploadFnc = [](Texture& texture, const TexturePixels& pixels) {
+        return texture.upload(pixels);
+    };
+
+    //! without a loader misses decode and upload on the calling thread
+    explicit TextureCache(size_t budgetBytes = 256u << 20, AsyncTextureLoader* loader = nullptr)
+        : loader(loader), budgetBytes(budgetBytes) {}
+
+    TextureHandle get(const std::string& path, const TextureLoadOptions& options = {}) {
+        std::string key = path + options.key();
+        auto it = entries.find(key);
+        // a failed load is dropped and tried again, the file may have shown up since
+        if (it != entries.end() && it->second.state->failed) {
+            lru.erase(it->second.order);
+            entries.erase(it);
+            it = entries.end();
+        }
+        if (it != entries.end()) {
+            lru.splice(lru.end(), lru, it->second.order);
+            stats.hits++;
+            return TextureHandle(it->second.state);
+        }
+        stats.misses++;
+
+        TextureHandle handle;
+        if (loader) {
+            handle = loader->load(path, options);
+        } else {
+            auto state = std::make_shared<TextureHandle::State>();
+            state->path = path;
+            TexturePixels pixels = Texture::decode(path, options);
+            if (pixels && uploadFnc(state->texture, pixels)) {
+                state->vramBytes = pixels.vramBytes();
+                state->ready = true;
+            } else {
+                state->failed = true;
+            }
+            handle = TextureHandle(state);
+        }
+        lru.push_back(key);
+        entries[key] = {handle.state, std::prev(lru.end())};
+        trim();
+        return handle;
+    }
+
+    //! evicts unreferenced textures, oldest first, until the resident set fits the budget
+    void trim() {
+        refreshResident();
+        for (auto order = lru.begin(); order != lru.end() && stats.residentBytes > budgetBytes;) {
+            auto victim = entries.find(*order);
+            const auto& state = victim->second.state;
+            if (state.use_count() > 1 || !(state->ready || state->failed)) {
+                ++order;
+                continue;
+            }
+            if (state->ready) stats.residentBytes -= state->vramBytes;
+            entries.erase(victim);
+            order = lru.erase(order);
+            stats.evictions++;
+        }
+    }
+
+    //! drops every texture only the cache still holds, whatever the budget
+    void collect() {
+        for (auto it = entries.begin(); it != entries.end();) {
+            bool settled = it->second.state->ready || it->second.state->failed;
+            if (settled && it->second.state.use_count() == 1) {
+                lru.erase(it->second.order);
+                it = entries.erase(it);
+                stats.evictions++;
+            } else {
+                ++it;
+            }
+        }
+        refreshResident();
+    }
+
+    const Stats& getStats() {
+        refreshResident();
+        return stats;
+    }
+    size_t size() const { return entries.size(); }
+
+private:
+    Stats stats;
+
+    // async entries only know their size once uploaded
+    void refreshResident() {
+        stats.residentBytes = 0;
+        for (const auto& [key, entry] : entries) {
+            if (entry.state->ready) stats.residentBytes += entry.state->vramBytes;
+        }
+    }
+};
+
+#endif // TEXTURE_H
@@ -0,0 +1,82 @@
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+//! fixed set of worker threads draining one job queue, same shape as ASyncFileSink
+class WorkerPool {
+    private:
+    std::queue<std::function<void()>> _jobs;
+    std::mutex _mutex;
+    std::condition_variable _cv;
+    std::atomic<bool> running = true;
+    std::atomic<size_t> busy = 0;
+    std::vector<std::thread> workers;
+
+    public:
+    explicit WorkerPool(size_t threadCount = 0){
+        if(threadCount == 0){
+            size_t hw = std::thread::hardware_concurrency();
+            threadCount = hw > 1 ? hw - 1 : 1;
+        }
+        for(size_t i = 0; i < threadCount; i++){
+            workers.emplace_back([this] {
+                while (true) {
+                    std::function<void()> job;
+                    {
+                        std::unique_lock<std::mutex> lock(_mutex);
+                        _cv.wait(lock, [this] { return !_jobs.empty() || !running; });
+                        if (_jobs.empty()) return;
+                        job = std::move(_jobs.front());
+                        _jobs.pop();
+                        busy++;
+                    }
+                    job();
+                    busy--;
+                }
+            });
+        }
+    }
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    void submit(std::function<void()> job){
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _jobs.push(std::move(job));
+        }
+        _cv.notify_one();
+    }
+
+    //! queued plus running jobs
+    size_t pending(){
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _jobs.size() + busy;
+    }
+    size_t threadCount() const { return workers.size(); }
+
+    //! finishes the queued jobs, then joins
+    void stop(){
+        // under the lock, a worker between its predicate check and the wait cannot miss the wakeup
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            running = false;
+        }
+        _cv.notify_all();
+        for(auto& worker:workers){
+            if (worker.joinable()) worker.join();
+        }
+        workers.clear();
+    }
+
+    ~WorkerPool(){
+        stop();
+    }
+};
+
+#endif
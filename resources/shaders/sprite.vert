@@ -5,6 +5,7 @@ layout(location = 2) in vec4 aColor;
 layout(location = 3) in int texLoc;
 
 uniform mat4 projection;
+uniform int textureBase;
 
 out vec2 TexCoord;
 out vec4 Color;
@@ -13,6 +14,6 @@ flat out int TexIndex;
 void main() {
     gl_Position = projection * vec4(aPos, 1.0, 1.0);
     TexCoord = aTexCoord;
-    TexIndex = texLoc;
+    TexIndex = texLoc < 0 ? texLoc : texLoc - textureBase;
     Color = aColor;
 }
\ No newline at end of file
@@ -0,0 +1,30 @@
+#version 330 core
+layout(location = 0) in vec2 iPos;
+layout(location = 1) in vec2 iScale;
+layout(location = 2) in float iRotation;
+layout(location = 3) in vec4 iUV;
+layout(location = 4) in vec4 iColor;
+layout(location = 5) in int iTexLoc;
+
+uniform mat4 projection;
+uniform int textureBase;
+
+out vec2 TexCoord;
+out vec4 Color;
+flat out int TexIndex;
+
+const vec2 corners[4] = vec2[4](vec2(-0.5, 0.5), vec2(0.5, 0.5), vec2(0.5, -0.5), vec2(-0.5, -0.5));
+const vec2 uvSelect[4] = vec2[4](vec2(0.0, 0.0), vec2(1.0, 0.0), vec2(1.0, 1.0), vec2(0.0, 1.0));
+
+void main() {
+    vec2 local = corners[gl_VertexID] * iScale;
+    if (iRotation != 0.0) {
+        float c = cos(iRotation);
+        float s = sin(iRotation);
+        local = vec2(local.x * c - local.y * s, local.x * s + local.y * c);
+    }
+    gl_Position = projection * vec4(local + iPos, 1.0, 1.0);
+    TexCoord = mix(iUV.xy, iUV.zw, uvSelect[gl_VertexID]);
+    TexIndex = iTexLoc < 0 ? iTexLoc : iTexLoc - textureBase;
+    Color = iColor;
+}
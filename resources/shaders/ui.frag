@@ -2,36 +2,61 @@
 
 #define OMNIX_UI_FONT 0
 #define OMNIX_UI_BUTTON 1
+#define OMNIX_UI_FONT_SDF 2
 
 in vec2 TexCoord;
 in vec4 Color;
 flat in int TexID;
 flat in int Type;
 
-uniform sampler2D textures[32];
+uniform sampler2D textures[16];
 
 out vec4 FragColor;
 
+float fontSample() {
+    switch(TexID) {
+        case 0: return texture(textures[0], TexCoord).r;
+        case 1: return texture(textures[1], TexCoord).r;
+        case 2: return texture(textures[2], TexCoord).r;
+        case 3: return texture(textures[3], TexCoord).r;
+        case 4: return texture(textures[4], TexCoord).r;
+        case 5: return texture(textures[5], TexCoord).r;
+        case 6: return texture(textures[6], TexCoord).r;
+        case 7: return texture(textures[7], TexCoord).r;
+        case 8: return texture(textures[8], TexCoord).r;
+        case 9: return texture(textures[9], TexCoord).r;
+        case 10: return texture(textures[10], TexCoord).r;
+        case 11: return texture(textures[11], TexCoord).r;
+        case 12: return texture(textures[12], TexCoord).r;
+        case 13: return texture(textures[13], TexCoord).r;
+        case 14: return texture(textures[14], TexCoord).r;
+        case 15: return texture(textures[15], TexCoord).r;
+        default: return -1.0;
+    }
+}
+
 void main() {
     if(Type == OMNIX_UI_FONT){
-      float alpha;
-      switch(TexID) {
-        case 0: alpha = texture(textures[0], TexCoord).r; break;
-        case 1: alpha = texture(textures[1], TexCoord).r; break;
-        case 2: alpha = texture(textures[2], TexCoord).r; break;
-        case 3: alpha = texture(textures[3], TexCoord).r; break;
-        case 4: alpha = texture(textures[4], TexCoord).r; break;
-        case 5: alpha = texture(textures[5], TexCoord).r; break;
-        case 6: alpha = texture(textures[6], TexCoord).r; break;
-        case 7: alpha = texture(textures[7], TexCoord).r; break;
-        case 8: alpha = texture(textures[8], TexCoord).r; break;
-        case 9: alpha = texture(textures[9], TexCoord).r; break;
-        case 10: alpha = texture(textures[10], TexCoord).r; break;
-        default: FragColor = vec4(1,0,1,1); break;
+      float alpha = fontSample();
+      if(alpha < 0.0){
+        FragColor = vec4(1,0,1,1);
+        return;
       }
       FragColor = vec4(Color.x, Color.y, Color.z, alpha);
       return;
     }
+    if(Type == OMNIX_UI_FONT_SDF){
+      float dist = fontSample();
+      if(dist < 0.0){
+        FragColor = vec4(1,0,1,1);
+        return;
+      }
+      // edge width follows the screen space derivative so any scale stays one pixel soft
+      float width = max(fwidth(dist) * 0.7, 0.0001);
+      float alpha = smoothstep(0.5 - width, 0.5 + width, dist);
+      FragColor = vec4(Color.xyz, Color.w * alpha);
+      return;
+    }
     if(Type == OMNIX_UI_BUTTON){
         switch(TexID) {
           case 0: FragColor= Color*texture(textures[0], TexCoord); break;
@@ -44,7 +69,12 @@ void main() {
           case 7: FragColor= Color*texture(textures[7], TexCoord); break;
           case 8: FragColor= Color*texture(textures[8], TexCoord); break;
           case 9: FragColor= Color*texture(textures[9], TexCoord); break;
-          case 10:FragColor= Color*texture(textures[10], TexCoord); break;
+          case 10: FragColor= Color*texture(textures[10], TexCoord); break;
+          case 11: FragColor= Color*texture(textures[11], TexCoord); break;
+          case 12: FragColor= Color*texture(textures[12], TexCoord); break;
+          case 13: FragColor= Color*texture(textures[13], TexCoord); break;
+          case 14: FragColor= Color*texture(textures[14], TexCoord); break;
+          case 15: FragColor= Color*texture(textures[15], TexCoord); break;
           default: FragColor = Color; break;
         }
     }
@@ -7,6 +7,7 @@ layout (location = 3) in int aTexID;
 layout (location = 4) in int aType;
 
 uniform mat4 projection;
+uniform int textureBase;
 
 out vec2 TexCoord;
 out vec4 Color;
@@ -17,6 +18,6 @@ void main() {
     gl_Position = projection * vec4(aPos.xy, 0.0, 1.0);
     TexCoord = aUV;
     Color = aColor;
-    TexID = aTexID;
+    TexID = aTexID < 0 ? aTexID : aTexID - textureBase;
     Type = aType;
 }
\ No newline at end of file
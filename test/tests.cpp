@@ -46,20 +46,9 @@
 
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include "stbi_write.h"
+#include "framecapture.h"
 static Omnix::Core::OmnixState STATIC_STATE = Omnix::Core::OmnixState::START;
 
-void SaveTextureToFile(GLuint textureID, int width, int height, const char* filename) {
-    glBindTexture(GL_TEXTURE_2D, textureID);
-
-    std::vector<unsigned char> pixels(width * height * 4); 
-    glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
-
-    std::vector<unsigned char> flipped(pixels.size());
-    for (int y = 0; y < height; ++y)
-        memcpy(&flipped[y * width * 4], &pixels[(height - 1 - y) * width * 4], width * 4);
-
-    stbi_write_png(filename, width, height, 4, flipped.data(), width * 4);
-}
 std::string formatFloat(float value, int precision = 1) {
     std::ostringstream oss;
     oss << std::fixed << std::setprecision(precision) << value;
@@ -94,6 +83,7 @@ class TestModule:public Omnix::Core::OmnixModule{
     int width=0,height = 0;
     Texture tex{};
     Texture tex2{};
+    FrameCapture capture{};
     Timer anim{};
     bool setblend = false;
 
@@ -114,7 +104,7 @@ class TestModule:public Omnix::Core::OmnixModule{
     t2d::ui::UIFont *font;
     
     Camera2D cam {600,600};
-    Map<50, 50> *map;
+    TileMap *map;
 
     Scene* scene;
 
@@ -208,6 +198,14 @@ class TestModule:public Omnix::Core::OmnixModule{
                 b2Body_SetLinearVelocity(scene->objects[obj].body, {0,10});
             }
 
+            if(Omnix::Helpers::np_get_data<bool,__variants>("OmnixKeyboardModule", {OMNIX_JUST_PRESS,{'P'}},&this->id().get_backend())){
+                capture.requestScreenshot("screenshot.png");
+            }
+            if(Omnix::Helpers::np_get_data<bool,__variants>("OmnixKeyboardModule", {OMNIX_JUST_PRESS,{'R'}},&this->id().get_backend())){
+                if(capture.isRecording()) capture.stopRecording();
+                else capture.startRecording("capture", 2);
+            }
+
         };
         
         OMNIX_EVENT(Omnix::Defaults::OmnixInitOnGraphicContextEvent, initGraphicEvent,&omnix) {
@@ -228,7 +226,7 @@ class TestModule:public Omnix::Core::OmnixModule{
                 GLuint txhold = 0;
  
                 font = new t2d::ui::UIFont();
-                font->chars = t2d::ui::UIFont::init("testfont.ttf", 32, &txhold);
+                font->glyphs = t2d::ui::UIFont::init("testfont.ttf", 32, &txhold);
                 font->fontAtlasTexture = txhold;
 
                 tex.loadFromFile("resources/ui/uiatlas.png");
@@ -244,13 +242,26 @@ class TestModule:public Omnix::Core::OmnixModule{
                 
                 scene = new Scene(cam);
                 scene->init({0.0f,-10.0f},{tex.getID()});
+                scene->set_culling(true, 500.0f);
                
-                map = Map<50,50>::initialize_and_create_map_HEAP(scene->spriteBatch, {}, {2500,2500}, {50,50});
-                map->m_state(0, SOLID);
-                map->m_color(0, {1,0,0,1});
-                
-
-                scene->init_map(map);
+                map = new TileMap(50.0f);
+                map->set_generator([](int chunkX,int chunkY,TileChunkData& out){
+                    for(int y = 0; y < T2D_CHUNK_SIZE; y++){
+                        for(int x = 0; x < T2D_CHUNK_SIZE; x++){
+                            int tileX = chunkX*T2D_CHUNK_SIZE+x;
+                            int tileY = chunkY*T2D_CHUNK_SIZE+y;
+                            if(tileX < 0 || tileX >= 50 || tileY < 0 || tileY >= 50) continue;
+                            int i = TileChunkData::index(x,y);
+                            out.flags[i] = T2D_TILE_VISIBLE;
+                            if(tileY == 0){
+                                out.flags[i] |= T2D_TILE_SOLID;
+                                out.colors[i] = packTileColor({1,0,0,1});
+                            }
+                        }
+                    }
+                });
+                map->init({tex.getID()});
+                scene->attach_tilemap(map);
 
                 obj = scene->add_object_dynamic({50,50}, {50,50});
                 scene->objects[obj].sprite->setZOrder(100);
@@ -327,17 +338,13 @@ class TestModule:public Omnix::Core::OmnixModule{
                 ptr->init();
                 
                 
-                frame->updateFnc = [this](t2d::ui::UIFrame* self){
-                    self->reload();
-                };
-
                 frame->layout = new t2d::ui::VerticalLayout();
 
                 manager->elements.push_back(frame);
             
                 max::vec2<int> mvec {mousex,mousey};
 
-                uirenderer->renderer->addRenderable(std::make_shared<t2d::ui::UIGlyph>(font->chars,'X',max::vec2<float>{0,0},max::vec2<float>{0,0}));
+                uirenderer->renderer->addRenderable(std::make_shared<t2d::ui::UIGlyph>(&font->glyphs,'X',max::vec2<float>{0,0},max::vec2<float>{0,0}));
                 manager->draw(uirenderer);
                 uirenderer->refresh();
             }
@@ -354,15 +361,17 @@ class TestModule:public Omnix::Core::OmnixModule{
                 mousey = Omnix::Helpers::np_get_data<int,__variants>("OmnixMouseModule", {{OMNIX_MOUSE_POS_Y,OMNIX_INVERTED}});
                 max::vec2<int> mvec {mousex,mousey};
 
-                map->refresh();
                 scene->update(std::min(1.0f/30.0f,event->dt));
 
                 cam.setZoom(static_cast<t2d::ui::UISlider<float>*>(frame->childs[0])->currentVal/100);
 
                 uirenderer->begin();
                 uirenderer->drawText("FPS:: "+formatFloat(1.0f/event->dt,0), {0,40}, {1,1},{1,0,0,1});
+                uirenderer->drawText("DRAWS:: "+std::to_string(RenderStats::lastFrameDrawCalls), {0,80}, {1,1},{1,0,0,1});
                 manager->update(uirenderer);
                 uirenderer->end(&cam);
+                RenderStats::endFrame();
+                capture.endFrame(width, height);
 
                 std::cout<<uirenderer->renderer->renderables.size()<<std::endl;
 
@@ -384,6 +393,7 @@ class TestModule:public Omnix::Core::OmnixModule{
     }END_INSTALL
 
     UNINSTALL(TestModule){
+        capture.dispose();
 
         uirenderer->dispose();
         delete uirenderer;
@@ -391,6 +401,7 @@ class TestModule:public Omnix::Core::OmnixModule{
         delete manager;
 
 
+        map->destroy();
         delete map;
         delete scene;
     }END_UNINSTALL
@@ -449,15 +460,63 @@ TEST(_BLogTest){
     return BoltTestResult::CALCULATED;
 }
 
+static int uiFailures = 0;
+
+TEST(_UIIdleMenuTest){
+    Omnix::Core::Omnix omnix;
+    auto Mouse_mod = std::make_shared<Omnix::Defaults::OmnixMouseModule>();
+    Omnix::Core::Omnix::data_instance().registerProvider("OmnixMouseModule",Mouse_mod);
+
+    t2d::ui::UIManager manager(omnix);
+    t2d::ui::UIRenderer ui({600,600});
+    t2d::ui::UIFont font;
+    ui.fonts.push_back(&font);
+    Camera2D cam{600,600};
+    auto uicoords = parse_sheet({160,160}, {16,16});
+
+    auto* menu = new t2d::ui::UIFrame({200,540},{400,1080},{0,1,1,1});
+    for(int i = 0; i < 3; i++){
+        menu->add(t2d::ui::newButton({0,0},{400,20},-1,-1,-1,{1,0,0,1},{0.8,0,0,1},{0.5,0,0,1},
+            uicoords[0],uicoords[1],uicoords[0],"Option "+std::to_string(i),{0.5,0.5},&cam,&manager));
+    }
+    menu->add(t2d::ui::newCheckBox({0,0},{20,20},-1,-1,-1,{1,1,1,1},{0.8,0,0,1},{0.5,0,0,1},
+        uicoords[0],uicoords[1],uicoords[0],"Check",{0.5,0.5},&cam,&manager,-1,uicoords[2]));
+    menu->layout = new t2d::ui::VerticalLayout();
+    manager.elements.push_back(menu);
+    manager.draw(&ui);
+
+    // builder callbacks only draw text, so an untouched menu settles after its first updates
+    for(int frame = 0; frame < 4; frame++){
+        ui.begin();
+        manager.update(&ui);
+    }
+    if(manager.updatedLastFrame != 0){
+        std::cerr<<"[UI] idle menu still updating "<<manager.updatedLastFrame<<" elements"<<std::endl;
+        uiFailures++;
+    }
+
+    menu->childs[1]->mark_dirty();
+    ui.begin();
+    manager.update(&ui);
+    if(manager.updatedLastFrame == 0){
+        std::cerr<<"[UI] dirty child did not wake its menu"<<std::endl;
+        uiFailures++;
+    }
+
+    manager.dispose();
+    return BoltTestResult::CALCULATED;
+}
+
 
 int main() {
     TIME_PROFILER_IS_ON = true;
     COLORIZED_MODE = true;
 
     BOLT_TEST(BLogTest, "noDesc", _BLogTest);
+    BOLT_TEST(UIIdleMenuTest, "idle builder menu settles", _UIIdleMenuTest);
 
     std::ofstream stream{"profilerResult.json"};
     runTests(std::cout,stream);
     stream.close();
-    return 0;
+    return uiFailures == 0 ? 0 : 1;
 }
\ No newline at end of file